@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "board.h"
+#include <assert.h>
+#include <stdio.h>
+#include "PolyMCU.h"
+
+#define EVENT_PRIORITY_BLINK	0
+#define EVENT_PRIORITY_REPORT	1
+
+static polymcu_event_t g_event_blink;
+static polymcu_event_t g_event_report;
+
+static void event_blink_handler(polymcu_event_t* event, uint32_t signals) {
+	static int led_state;
+
+	led_state = !led_state;
+	if (led_state) {
+		led_on(1);
+	} else {
+		led_off(1);
+	}
+
+	// Ask the less urgent handler to report the new state
+	polymcu_event_post(&g_event_report, 1 << led_state);
+}
+
+static void event_report_handler(polymcu_event_t* event, uint32_t signals) {
+	if (signals & POLYMCU_EVENT_SIGNAL_TIMER) {
+		printf("# Report (current timer value: %d)\n", polymcu_timer_get_value());
+	}
+	if (signals & (1 << 1)) {
+		puts("# LED on");
+	}
+	if (signals & (1 << 0)) {
+		puts("# LED off");
+	}
+}
+
+// The processor clock is initialized by CMSIS startup + system file
+int main (void) {
+	polymcu_timer_task_t task_blink;
+	polymcu_timer_task_t task_report;
+	int ret;
+
+	// Initialize PolyMCU Timer Support
+	ret = polymcu_timer_init(TIMER_PERIOD_MILLISECOND);
+	if (ret) {
+		puts("ERROR: Fail to initialize PolyMCU Timer");
+		while(1);
+	}
+
+	polymcu_event_init(&g_event_blink, event_blink_handler, EVENT_PRIORITY_BLINK, NULL);
+	polymcu_event_init(&g_event_report, event_report_handler, EVENT_PRIORITY_REPORT, NULL);
+
+	task_blink = polymcu_event_create_timer(&g_event_blink, 500, 1);
+	assert(task_blink != NULL);
+	task_report = polymcu_event_create_timer(&g_event_report, 2000, 1);
+	assert(task_report != NULL);
+
+	polymcu_timer_start_task(task_blink);
+	polymcu_timer_start_task(task_report);
+
+	polymcu_event_run();
+}
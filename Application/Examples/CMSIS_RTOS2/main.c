@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "board.h"
+#include <cmsis_os2.h>
+#include <stdio.h>
+
+#define SAMPLE_COUNT		4
+#define FLAG_SAMPLE		0x1
+
+typedef struct {
+	uint32_t index;
+	uint32_t tick;
+} sample_t;
+
+static osMemoryPoolId_t g_sample_pool;
+static osMessageQueueId_t g_sample_queue;
+static osEventFlagsId_t g_sample_flags;
+
+// The control block of the message queue is provided by the application
+static os2_message_queue_cb_t g_sample_queue_cb;
+
+static void sample_timer(void* argument) {
+	osEventFlagsSet(g_sample_flags, FLAG_SAMPLE);
+}
+
+static void producer(void* argument) {
+	uint32_t index = 0;
+	sample_t* sample;
+
+	while (1) {
+		osEventFlagsWait(g_sample_flags, FLAG_SAMPLE, osFlagsWaitAny, osWaitForever);
+
+		sample = osMemoryPoolAlloc(g_sample_pool, 0);
+		if (sample == NULL) {
+			printf("producer: no free sample\n");
+			continue;
+		}
+		sample->index = index++;
+		sample->tick = osKernelGetTickCount();
+
+		// The pointer to the sample is the message: the sample itself is not copied
+		osMessageQueuePut(g_sample_queue, &sample, 0, osWaitForever);
+	}
+}
+
+static void consumer(void* argument) {
+	sample_t* sample;
+
+	while (1) {
+		if (osMessageQueueGet(g_sample_queue, &sample, NULL, osWaitForever) == osOK) {
+			printf("sample %u at tick %u\n", (unsigned int)sample->index, (unsigned int)sample->tick);
+			osMemoryPoolFree(g_sample_pool, sample);
+		}
+	}
+}
+
+int main(void) {
+	const osThreadAttr_t producer_attr = { .name = "producer", .priority = osPriorityAboveNormal };
+	const osThreadAttr_t consumer_attr = { .name = "consumer", .priority = osPriorityNormal };
+	const osMessageQueueAttr_t queue_attr = {
+		.name = "samples", .cb_mem = &g_sample_queue_cb, .cb_size = sizeof(g_sample_queue_cb)
+	};
+	osVersion_t version;
+	char kernel_id[32];
+	osTimerId_t timer;
+
+	osKernelInitialize();
+
+	g_sample_pool = osMemoryPoolNew(SAMPLE_COUNT, sizeof(sample_t), NULL);
+	g_sample_queue = osMessageQueueNew(SAMPLE_COUNT, sizeof(sample_t*), &queue_attr);
+	g_sample_flags = osEventFlagsNew(NULL);
+	if ((g_sample_pool == NULL) || (g_sample_queue == NULL) || (g_sample_flags == NULL)) {
+		printf("Failed to create the objects\n");
+		return 1;
+	}
+
+	osThreadNew(producer, NULL, &producer_attr);
+	osThreadNew(consumer, NULL, &consumer_attr);
+
+	// A new sample every second
+	timer = osTimerNew(sample_timer, osTimerPeriodic, NULL, NULL);
+	osTimerStart(timer, osKernelGetTickFreq());
+
+	osKernelGetInfo(&version, kernel_id, sizeof(kernel_id));
+	printf("Start %s (API %u)\n", kernel_id, (unsigned int)version.api);
+	osKernelStart();
+
+	// osKernelStart() only returns on error
+	return 1;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "board.h"
+#include "PolyMCU.h"
+#include <cmsis_os.h>
+#include <stdio.h>
+
+// The measures are read from the DWT cycle counter and the ISR is the DebugMonitor exception
+#ifndef POLYMCU_HAS_CYCLE_COUNTER
+  #error "The CMSIS RTOS benchmark requires the DWT cycle counter (ARMv7-M or ARMv8-M Mainline)"
+#endif
+
+// Name of the kernel printed in the first column of the tables
+#ifndef BENCHMARK_RTOS
+  #define BENCHMARK_RTOS		"unknown"
+#endif
+
+#define BENCHMARK_CYCLES()		DWT->CYCCNT
+
+typedef struct {
+	const char* name;
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+} bench_stats_t;
+
+void bench_stats_init(bench_stats_t* stats, const char* name);
+void bench_stats_add(bench_stats_t* stats, uint32_t cycles);
+
+// Each table starts with its header line. The comment lines start with '#'.
+void bench_print_latency_header(void);
+void bench_print_latency(const bench_stats_t* stats);
+void bench_print_ram_header(void);
+void bench_print_ram(const char* object, uint32_t static_bytes, uint32_t pool_bytes, uint32_t heap_bytes);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "benchmark.h"
+
+void bench_stats_init(bench_stats_t* stats, const char* name) {
+	stats->name = name;
+	stats->count = 0;
+	stats->min = UINT32_MAX;
+	stats->max = 0;
+	stats->total = 0;
+}
+
+void bench_stats_add(bench_stats_t* stats, uint32_t cycles) {
+	stats->count++;
+	stats->total += cycles;
+	if (cycles < stats->min) {
+		stats->min = cycles;
+	}
+	if (cycles > stats->max) {
+		stats->max = cycles;
+	}
+}
+
+void bench_print_latency_header(void) {
+	puts("kernel,test,samples,min,avg,max");
+}
+
+void bench_print_latency(const bench_stats_t* stats) {
+	// An empty measure (eg: the ISR has never been taken) leaves the cycle columns empty
+	if (stats->count == 0) {
+		printf("%s,%s,0,,,\n", BENCHMARK_RTOS, stats->name);
+	} else {
+		printf("%s,%s,%lu,%lu,%lu,%lu\n", BENCHMARK_RTOS, stats->name,
+				(unsigned long)stats->count, (unsigned long)stats->min,
+				(unsigned long)(stats->total / stats->count), (unsigned long)stats->max);
+	}
+}
+
+void bench_print_ram_header(void) {
+	puts("kernel,object,static,pool,heap");
+}
+
+void bench_print_ram(const char* object, uint32_t static_bytes, uint32_t pool_bytes, uint32_t heap_bytes) {
+	printf("%s,%s,%lu,%lu,%lu\n", BENCHMARK_RTOS, object,
+			(unsigned long)static_bytes, (unsigned long)pool_bytes, (unsigned long)heap_bytes);
+}
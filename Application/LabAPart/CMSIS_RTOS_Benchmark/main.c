@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "benchmark.h"
+#include <stdlib.h>
+
+#ifdef BENCHMARK_RTOS_FreeRTOS
+#include "FreeRTOS.h"
+#endif
+
+#define BENCH_ITERATIONS		1000
+#define BENCH_QUEUE_DEPTH		16
+#define BENCH_TIMER_PERIOD_MS	10
+#define BENCH_TIMER_SAMPLES		100
+// Time given to the ISR to wake up the thread before considering it is never taken
+#define BENCH_ISR_TIMEOUT_MS	100
+
+// Number of rows of the latency table
+#define BENCH_STATS_COUNT		12
+
+#define SIGNAL_PEER				0x1
+#define SIGNAL_DONE				0x2
+
+static osThreadId g_main_thread;
+static osThreadId g_peer_thread;
+
+// Cycle counter sampled by the peer thread, the ISR and the timer callback
+static volatile uint32_t g_peer_stamp;
+static volatile uint32_t g_isr_stamp;
+static volatile uint32_t g_peer_count;
+
+// Rows of the latency table (not on the stack of main() that also runs printf())
+static bench_stats_t g_stats[BENCH_STATS_COUNT];
+
+static uint32_t g_timer_intervals[BENCH_TIMER_SAMPLES];
+static volatile uint32_t g_timer_count;
+static uint32_t g_timer_last;
+
+osMutexId bench_mutex;
+osMutexDef(bench_mutex);
+
+osSemaphoreId bench_ping;
+osSemaphoreDef(bench_ping);
+osSemaphoreId bench_pong;
+osSemaphoreDef(bench_pong);
+
+osMessageQId bench_queue;
+osMessageQDef(bench_queue, BENCH_QUEUE_DEPTH, uint32_t);
+
+// Free bytes of the kernel heap. Only FreeRTOS allocates its objects from a heap, RTX and
+// RioT-OS use the storage of the 'osXxxDef()' macros and their preallocated pools.
+static uint32_t bench_heap_free(void) {
+#ifdef BENCHMARK_RTOS_FreeRTOS
+	return xPortGetFreeHeapSize();
+#else
+	return 0;
+#endif
+}
+
+//
+// Peer threads
+//
+
+// Equal priority: it only runs when the main thread yields
+void job_yield(void const *argument) {
+	while (1) {
+		g_peer_stamp = BENCHMARK_CYCLES();
+		osThreadYield();
+	}
+}
+osThreadDef(job_yield, osPriorityNormal, 1, 0);
+
+// Higher priority: releasing 'bench_ping' switches to it immediately
+void job_semaphore(void const *argument) {
+	while (1) {
+		osSemaphoreWait(bench_ping, osWaitForever);
+		osSemaphoreRelease(bench_pong);
+	}
+}
+osThreadDef(job_semaphore, osPriorityAboveNormal, 1, 0);
+
+// Higher priority: it blocks on the mutex owned by the main thread until it is released
+void job_mutex(void const *argument) {
+	while (1) {
+		osSignalWait(SIGNAL_PEER, osWaitForever);
+		osMutexWait(bench_mutex, osWaitForever);
+		g_peer_stamp = BENCHMARK_CYCLES();
+		osMutexRelease(bench_mutex);
+	}
+}
+osThreadDef(job_mutex, osPriorityAboveNormal, 1, 0);
+
+// Equal priority: it drains the queue when the main thread blocks on a full queue
+void job_consumer(void const *argument) {
+	osEvent event;
+
+	while (1) {
+		event = osMessageGet(bench_queue, osWaitForever);
+		if ((event.status == osEventMessage) && (++g_peer_count == BENCH_ITERATIONS)) {
+			osSignalSet(g_main_thread, SIGNAL_DONE);
+		}
+	}
+}
+osThreadDef(job_consumer, osPriorityNormal, 1, 0);
+
+// Higher priority: it is woken up by the signal set from the ISR
+void job_isr_wake(void const *argument) {
+	while (1) {
+		osSignalWait(SIGNAL_PEER, osWaitForever);
+		g_peer_stamp = BENCHMARK_CYCLES();
+		osSignalSet(g_main_thread, SIGNAL_DONE);
+	}
+}
+osThreadDef(job_isr_wake, osPriorityAboveNormal, 1, 0);
+
+// Only created to measure the RAM used by a thread
+void job_idle(void const *argument) {
+	while (1) {
+		osSignalWait(SIGNAL_PEER, osWaitForever);
+	}
+}
+osThreadDef(job_idle, osPriorityAboveNormal, 1, 0);
+
+//
+// ISR and timer
+//
+
+// The DebugMonitor exception is pended by software (DEMCR.MON_PEND). It is not used by the
+// kernels and exists on every ARMv7-M device, unlike a spare peripheral interrupt.
+void DebugMon_Handler(void) {
+	g_isr_stamp = BENCHMARK_CYCLES();
+	osSignalSet(g_peer_thread, SIGNAL_PEER);
+}
+
+void job_timer(void const *argument) {
+	uint32_t now = BENCHMARK_CYCLES();
+	uint32_t count = g_timer_count;
+
+	// The first call only starts the measure
+	if ((count > 0) && (count <= BENCH_TIMER_SAMPLES)) {
+		g_timer_intervals[count - 1] = now - g_timer_last;
+	}
+	g_timer_last = now;
+	g_timer_count = count + 1;
+
+	if (count == BENCH_TIMER_SAMPLES) {
+		osSignalSet(g_main_thread, SIGNAL_DONE);
+	}
+}
+osTimerDef(bench_timer, job_timer);
+
+//
+// Benchmarks
+//
+
+static void bench_ram(void) {
+	uint32_t heap;
+	osTimerId timer;
+	osThreadId thread;
+
+	bench_print_ram_header();
+
+	heap = bench_heap_free();
+	bench_mutex = osMutexCreate(osMutex(bench_mutex));
+	bench_print_ram("mutex", sizeof(os_mutex_cb_bench_mutex), 0, heap - bench_heap_free());
+
+	heap = bench_heap_free();
+	bench_ping = osSemaphoreCreate(osSemaphore(bench_ping), 0);
+	bench_print_ram("semaphore", sizeof(os_semaphore_cb_bench_ping), 0, heap - bench_heap_free());
+	bench_pong = osSemaphoreCreate(osSemaphore(bench_pong), 0);
+
+	heap = bench_heap_free();
+	bench_queue = osMessageCreate(osMessageQ(bench_queue), NULL);
+	bench_print_ram("message_queue_16", sizeof(os_messageQ_q_bench_queue), 0, heap - bench_heap_free());
+
+	heap = bench_heap_free();
+	timer = osTimerCreate(osTimer(bench_timer), osTimerPeriodic, NULL);
+	bench_print_ram("timer", sizeof(os_timer_cb_bench_timer), 0, heap - bench_heap_free());
+	osTimerDelete(timer);
+
+	// RTX and RioT-OS take the stack from a pool of RTOS_TASK_STACK_SIZE blocks (their thread
+	// control block is not counted), FreeRTOS allocates the stack and the TCB from its heap
+	heap = bench_heap_free();
+	thread = osThreadCreate(osThread(job_idle), NULL);
+#ifdef BENCHMARK_RTOS_FreeRTOS
+	bench_print_ram("thread", 0, 0, heap - bench_heap_free());
+#else
+	bench_print_ram("thread", 0, BENCHMARK_TASK_STACK_SIZE, heap - bench_heap_free());
+#endif
+	osThreadTerminate(thread);
+}
+
+static void bench_cycle_counter(bench_stats_t* stats) {
+	uint32_t start, end;
+	uint32_t index;
+
+	bench_stats_init(stats, "cycle_counter");
+	for (index = 0; index < BENCH_ITERATIONS; index++) {
+		start = BENCHMARK_CYCLES();
+		end = BENCHMARK_CYCLES();
+		bench_stats_add(stats, end - start);
+	}
+}
+
+static void bench_yield(bench_stats_t* thread_switch, bench_stats_t* yield) {
+	uint32_t start, end;
+	uint32_t index;
+
+	bench_stats_init(thread_switch, "thread_switch");
+	bench_stats_init(yield, "yield_round_trip");
+
+	g_peer_thread = osThreadCreate(osThread(job_yield), NULL);
+	// Let the peer thread reach its loop
+	osThreadYield();
+
+	for (index = 0; index < BENCH_ITERATIONS; index++) {
+		start = BENCHMARK_CYCLES();
+		osThreadYield();
+		end = BENCHMARK_CYCLES();
+		bench_stats_add(thread_switch, g_peer_stamp - start);
+		bench_stats_add(yield, end - start);
+	}
+
+	osThreadTerminate(g_peer_thread);
+}
+
+static void bench_semaphore(bench_stats_t* stats) {
+	uint32_t start, end;
+	uint32_t index;
+
+	bench_stats_init(stats, "semaphore_ping_pong");
+
+	g_peer_thread = osThreadCreate(osThread(job_semaphore), NULL);
+
+	for (index = 0; index < BENCH_ITERATIONS; index++) {
+		start = BENCHMARK_CYCLES();
+		osSemaphoreRelease(bench_ping);
+		osSemaphoreWait(bench_pong, osWaitForever);
+		end = BENCHMARK_CYCLES();
+		bench_stats_add(stats, end - start);
+	}
+
+	osThreadTerminate(g_peer_thread);
+}
+
+static void bench_mutex_uncontended(bench_stats_t* stats) {
+	uint32_t start, end;
+	uint32_t index;
+
+	bench_stats_init(stats, "mutex_uncontended");
+
+	for (index = 0; index < BENCH_ITERATIONS; index++) {
+		start = BENCHMARK_CYCLES();
+		osMutexWait(bench_mutex, osWaitForever);
+		osMutexRelease(bench_mutex);
+		end = BENCHMARK_CYCLES();
+		bench_stats_add(stats, end - start);
+	}
+}
+
+// Time from the release of the mutex by its owner to the waiting thread owning it
+static void bench_mutex_contended(bench_stats_t* stats) {
+	uint32_t start;
+	uint32_t index;
+
+	bench_stats_init(stats, "mutex_contended");
+
+	g_peer_thread = osThreadCreate(osThread(job_mutex), NULL);
+
+	for (index = 0; index < BENCH_ITERATIONS; index++) {
+		osMutexWait(bench_mutex, osWaitForever);
+		// The peer thread preempts us and blocks on the mutex
+		osSignalSet(g_peer_thread, SIGNAL_PEER);
+		start = BENCHMARK_CYCLES();
+		osMutexRelease(bench_mutex);
+		bench_stats_add(stats, g_peer_stamp - start);
+	}
+
+	osThreadTerminate(g_peer_thread);
+}
+
+static void bench_message_queue(bench_stats_t* put, bench_stats_t* message) {
+	uint32_t start, end, put_start;
+	uint32_t index;
+
+	bench_stats_init(put, "message_queue_put");
+	bench_stats_init(message, "message_queue_message");
+
+	g_peer_count = 0;
+	g_peer_thread = osThreadCreate(osThread(job_consumer), NULL);
+
+	start = BENCHMARK_CYCLES();
+	for (index = 0; index < BENCH_ITERATIONS; index++) {
+		put_start = BENCHMARK_CYCLES();
+		osMessagePut(bench_queue, index, osWaitForever);
+		bench_stats_add(put, BENCHMARK_CYCLES() - put_start);
+	}
+	osSignalWait(SIGNAL_DONE, osWaitForever);
+	end = BENCHMARK_CYCLES();
+
+	// Throughput: average cost of a message from the producer to the consumer
+	message->count = BENCH_ITERATIONS;
+	message->total = end - start;
+	message->min = (uint32_t)(message->total / BENCH_ITERATIONS);
+	message->max = message->min;
+
+	osThreadTerminate(g_peer_thread);
+}
+
+// 'isr_entry' is the time from pending the exception to its handler, 'isr_signal_wake' the
+// time from the handler setting the signal to the thread running
+static void bench_isr_signal(bench_stats_t* entry, bench_stats_t* wake) {
+	uint32_t start;
+	uint32_t index;
+	osEvent event;
+
+	bench_stats_init(entry, "isr_entry");
+	bench_stats_init(wake, "isr_signal_wake");
+
+	g_peer_thread = osThreadCreate(osThread(job_isr_wake), NULL);
+
+	// Lowest priority: the ISR is allowed to call the kernel on all the RTOS
+	NVIC_SetPriority(DebugMonitor_IRQn, (1UL << __NVIC_PRIO_BITS) - 1);
+
+	for (index = 0; index < BENCH_ITERATIONS; index++) {
+		start = BENCHMARK_CYCLES();
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_MON_PEND_Msk;
+		event = osSignalWait(SIGNAL_DONE, BENCH_ISR_TIMEOUT_MS);
+		if (event.status != osEventSignal) {
+			// The exception is not taken when a debugger has enabled halting debug
+			CoreDebug->DEMCR &= ~CoreDebug_DEMCR_MON_PEND_Msk;
+			puts("# DebugMonitor exception not taken - isr measures skipped");
+			break;
+		}
+		bench_stats_add(entry, g_isr_stamp - start);
+		bench_stats_add(wake, g_peer_stamp - g_isr_stamp);
+	}
+
+	osThreadTerminate(g_peer_thread);
+}
+
+// The jitter of a period is its distance to the average period
+static void bench_timer(bench_stats_t* period, bench_stats_t* jitter) {
+	osTimerId timer;
+	uint32_t average;
+	uint64_t total = 0;
+	uint32_t index;
+
+	bench_stats_init(period, "timer_period");
+	bench_stats_init(jitter, "timer_jitter");
+
+	g_timer_count = 0;
+	timer = osTimerCreate(osTimer(bench_timer), osTimerPeriodic, NULL);
+	osTimerStart(timer, BENCH_TIMER_PERIOD_MS);
+	osSignalWait(SIGNAL_DONE, osWaitForever);
+	osTimerStop(timer);
+	osTimerDelete(timer);
+
+	for (index = 0; index < BENCH_TIMER_SAMPLES; index++) {
+		bench_stats_add(period, g_timer_intervals[index]);
+		total += g_timer_intervals[index];
+	}
+	average = total / BENCH_TIMER_SAMPLES;
+	for (index = 0; index < BENCH_TIMER_SAMPLES; index++) {
+		if (g_timer_intervals[index] > average) {
+			bench_stats_add(jitter, g_timer_intervals[index] - average);
+		} else {
+			bench_stats_add(jitter, average - g_timer_intervals[index]);
+		}
+	}
+}
+
+// The processor clock is initialized by CMSIS startup + system file
+int main(void) {
+	uint32_t index;
+
+	// Note1: osKernelInitialize() is called before main() in software_init_hook() when newlib is used.
+	//       main() is considered as a task by RTX
+	g_main_thread = osThreadGetId();
+
+	// Start the DWT cycle counter
+	(void)polymcu_time_cycles();
+
+	printf("# CMSIS RTOS benchmark - kernel:%s core_clock:%lu iterations:%d\n",
+			BENCHMARK_RTOS, (unsigned long)SystemCoreClock, BENCH_ITERATIONS);
+
+	puts("# RAM cost of the kernel objects (bytes)");
+	bench_ram();
+
+	// Let the UART drain before measuring
+	osDelay(100);
+
+	bench_cycle_counter(&g_stats[0]);
+	bench_yield(&g_stats[1], &g_stats[2]);
+	bench_semaphore(&g_stats[3]);
+	bench_mutex_uncontended(&g_stats[4]);
+	bench_mutex_contended(&g_stats[5]);
+	bench_message_queue(&g_stats[6], &g_stats[7]);
+	bench_isr_signal(&g_stats[8], &g_stats[9]);
+	bench_timer(&g_stats[10], &g_stats[11]);
+
+	puts("# Latencies (CPU cycles)");
+	bench_print_latency_header();
+	for (index = 0; index < BENCH_STATS_COUNT; index++) {
+		bench_print_latency(&g_stats[index]);
+	}
+	puts("# Benchmark completed");
+
+#ifdef SUPPORT_SEMIHOSTING
+	// Terminate the emulation to run the benchmark in regression
+	exit(0);
+#endif
+
+	//Note: This line is optional when using RTX but it is required by FreeRTOS
+	osThreadTerminate(osThreadGetId());
+
+	// Note2: osKernelStart() is called before main() in software_init_hook() when newlib is used.
+}
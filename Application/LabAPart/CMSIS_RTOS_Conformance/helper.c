@@ -25,6 +25,7 @@
  */
 
 #include "conformance.h"
+#include <stdlib.h>
 
 static int g_test_pass = 0;
 static int g_test_fail = 0;
@@ -45,4 +46,9 @@ void test_output(const char* test, const char* assert_str, unsigned result) {
 
 void test_result(void) {
 	printf("=> Test completed - pass:%d fail:%d\n", g_test_pass, g_test_fail);
+
+#ifdef SUPPORT_SEMIHOSTING
+	// Return the result to the emulator to use the conformance test in regression
+	exit(g_test_fail ? 1 : 0);
+#endif
 }
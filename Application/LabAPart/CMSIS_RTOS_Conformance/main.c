@@ -381,10 +381,10 @@ int main(void) {
 	status = osMailFree(mail_test, mail3);
 	test_assert("Test osMailFree() with message which has not been removed from the mailbox", status != osOK);
 	event = osMailGet(mail_test, osWaitForever);
-	test_status("Test osMailGet()", status);
-	status = osMailFree(mail_test, mail3);
+	test_assert("Test osMailGet()", (event.status == osEventMail) && (event.value.p == mail1));
+	status = osMailFree(mail_test, event.value.p);
 	test_status("Test osMailFree()", status);
-	status = osMailFree(mail_test, mail3);
+	status = osMailFree(mail_test, event.value.p);
 	test_assert("Test osMailFree() with message already freed", status != osOK);
 #endif
 
@@ -25,6 +25,7 @@
  */
 
 #include "micropython_internal.h"
+#include "PolyMCU.h"
 
 #include "py/nlr.h"
 #include "py/compile.h"
@@ -46,7 +47,26 @@ int main (void) {
 	platform_init();
 soft_reset:
 #if MICROPY_ENABLE_GC
+#ifdef SUPPORT_HEAP_TLSF
+	// The garbage collector heap is allocated from the PolyMCU heap shared with newlib
+	static uint8_t* gc_heap;
+	static size_t gc_heap_size;
+	if (gc_heap == NULL) {
+		polymcu_heap_stats_t stats;
+
+		polymcu_heap_get_stats(NULL, &stats);
+		gc_heap_size = &__HeapLimit - &__HeapBase;
+		// Leave a quarter of the free memory to newlib
+		if (gc_heap_size > stats.largest_free_block - (stats.largest_free_block / 4)) {
+			gc_heap_size = stats.largest_free_block - (stats.largest_free_block / 4);
+		}
+		gc_heap = polymcu_heap_malloc(NULL, gc_heap_size);
+		assert(gc_heap != NULL);
+	}
+	gc_init(gc_heap, gc_heap + gc_heap_size);
+#else
 	gc_init(&__HeapBase, &__HeapLimit);
+#endif
 #endif
 
 	mp_init();
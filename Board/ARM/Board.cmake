@@ -24,10 +24,38 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #
 
-# Tell RTOS we are running at 10Mhz
-set(RTOS_CLOCK 10000000)
-# No UART on this board template
-set(SUPPORT_DEBUG_UART none)
+string(REGEX REPLACE "ARM/" "" _board_name ${BOARD})
+
+if (${_board_name} STREQUAL "QEMU_MPS2")
+  # MPS2 FPGA image emulated by QEMU. It selects the Cortex-M core of the board.
+  set(QEMU_MACHINE mps2-an385 CACHE STRING "QEMU machine of the QEMU_MPS2 board (mps2-an385, mps2-an386 or mps2-an500).")
+  if (QEMU_MACHINE STREQUAL "mps2-an385")
+    set(_board_cpu ARMCM3)
+  elseif (QEMU_MACHINE STREQUAL "mps2-an386")
+    set(_board_cpu ARMCM4)
+  elseif (QEMU_MACHINE STREQUAL "mps2-an500")
+    set(_board_cpu ARMCM7)
+  else()
+    message(FATAL_ERROR "QEMU machine '${QEMU_MACHINE}' not supported.")
+  endif()
+
+  # The MPS2 FPGA images run at 25Mhz
+  set(RTOS_CLOCK 25000000)
+  # Debug UART on the CMSDK UART0
+  set(SUPPORT_DEBUG_UART "cmsdk" CACHE STRING "Debug UART Port")
+  # The exit code of the application is returned to the host through semihosting
+  set(SUPPORT_SEMIHOSTING 1)
+else()
+  set(_board_cpu ${_board_name})
+
+  # Tell RTOS we are running at 10Mhz
+  set(RTOS_CLOCK 10000000)
+  # No UART on this board template
+  set(SUPPORT_DEBUG_UART none)
+endif()
+
+# Directory of the CMSIS device in 'Device/ARM'
+set(ARM_DEVICE ${_board_cpu})
 
 # List of HW modules
 list(APPEND LIST_MODULES Device/ARM
@@ -37,7 +65,6 @@ list(APPEND LIST_MODULES Device/ARM
 #
 # Build options
 #
-string(REGEX REPLACE "ARM/" "" _board_cpu ${BOARD})
 if (${_board_cpu} STREQUAL "ARMCM0")
   set(CPU "ARM Cortex-M0")
 elseif (${_board_cpu} STREQUAL "ARMCM0plus")
@@ -26,7 +26,29 @@
 
 find_package(ARM)
 
-string(REGEX REPLACE "ARM/" "" _board_cpu ${BOARD})
-include_directories(${CMAKE_CURRENT_LIST_DIR}/${_board_cpu})
+string(REGEX REPLACE "ARM/" "" _board_name ${BOARD})
+include_directories(${CMAKE_CURRENT_LIST_DIR}/${_board_name})
+
+if (${_board_name} STREQUAL "QEMU_MPS2")
+  # The MPS2 SSRAMs are larger than the memory of the generic Cortex-M devices
+  set(MCU_EXE_LINKER_FLAGS "-T ${CMAKE_CURRENT_LIST_DIR}/QEMU_MPS2/gcc_arm.ld")
+
+  if(SUPPORT_DEBUG_UART STREQUAL "none")
+    add_definitions(-DSUPPORT_DEBUG_UART_NONE)
+  endif()
+  if(SUPPORT_SEMIHOSTING)
+    add_definitions(-DSUPPORT_SEMIHOSTING)
+  endif()
+
+  # 'make run' starts the firmware on QEMU. The exit code of the application is returned
+  # through semihosting.
+  find_program(QEMU_SYSTEM_ARM qemu-system-arm)
+  set(QEMU_EXTRA_ARGS "" CACHE STRING "Additional arguments of qemu-system-arm (eg: '-icount shift=0').")
+  separate_arguments(_qemu_extra_args UNIX_COMMAND "${QEMU_EXTRA_ARGS}")
+  if(QEMU_SYSTEM_ARM)
+    set(Board_RUN_COMMAND ${QEMU_SYSTEM_ARM} -machine ${QEMU_MACHINE} -nographic
+                          -semihosting-config enable=on,target=native ${_qemu_extra_args} -kernel)
+  endif()
+endif()
 
 set(Board_LIBRARIES board_arm ${ARM_LIBRARIES})
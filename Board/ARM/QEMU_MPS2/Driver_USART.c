@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// CMSIS USART driver of the CMSDK UART0 (debug UART)
+//
+// The CMSDK UART has a single byte buffer in each direction. Without event callback, the
+// transfers are blocking. With a callback, they are driven by the TX and RX interrupts.
+//
+
+#include "board.h"
+#include "PolyMCU.h"
+#include "Driver_USART.h"
+
+#define ARM_USART_DRV_VERSION    ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0)  /* driver version */
+
+#ifndef DEBUG_UART_BAUDRATE
+  #define DEBUG_UART_BAUDRATE    115200
+#endif
+
+#define UART                     CMSDK_UART0
+
+void _ttywrch(int ch);
+
+/* Driver Version */
+static const ARM_DRIVER_VERSION DriverVersion = {
+    ARM_USART_API_VERSION,
+    ARM_USART_DRV_VERSION
+};
+
+/* Driver Capabilities */
+static const ARM_USART_CAPABILITIES DriverCapabilities = {
+    1, /* supports UART (Asynchronous) mode */
+    0, /* supports Synchronous Master mode */
+    0, /* supports Synchronous Slave mode */
+    0, /* supports UART Single-wire mode */
+    0, /* supports UART IrDA mode */
+    0, /* supports UART Smart Card mode */
+    0, /* Smart Card Clock generator available */
+    0, /* RTS Flow Control available */
+    0, /* CTS Flow Control available */
+    0, /* Transmit completed event: \ref ARM_USART_EVENT_TX_COMPLETE */
+    0, /* Signal receive character timeout event: \ref ARM_USART_EVENT_RX_TIMEOUT */
+    0, /* RTS Line: 0=not available, 1=available */
+    0, /* CTS Line: 0=not available, 1=available */
+    0, /* DTR Line: 0=not available, 1=available */
+    0, /* DSR Line: 0=not available, 1=available */
+    0, /* DCD Line: 0=not available, 1=available */
+    0, /* RI Line: 0=not available, 1=available */
+    0, /* Signal CTS change event: \ref ARM_USART_EVENT_CTS */
+    0, /* Signal DSR change event: \ref ARM_USART_EVENT_DSR */
+    0, /* Signal DCD change event: \ref ARM_USART_EVENT_DCD */
+    0  /* Signal RI change event: \ref ARM_USART_EVENT_RI */
+};
+
+static ARM_USART_SignalEvent_t m_SignalEvent;
+
+static const uint8_t* volatile m_tx_data;
+static volatile uint32_t m_tx_num;
+static volatile uint32_t m_tx_count;
+static uint8_t* volatile m_rx_data;
+static volatile uint32_t m_rx_num;
+static volatile uint32_t m_rx_count;
+
+//
+//   Functions
+//
+
+ARM_DRIVER_VERSION ARM_USART_GetVersion(void) {
+	return DriverVersion;
+}
+
+ARM_USART_CAPABILITIES ARM_USART_GetCapabilities(void) {
+	return DriverCapabilities;
+}
+
+static int32_t uart_set_baudrate(uint32_t baudrate) {
+	uint32_t divider;
+
+	if (baudrate == 0) {
+		return ARM_USART_ERROR_BAUDRATE;
+	}
+
+	divider = SystemCoreClock / baudrate;
+	if (divider < CMSDK_UART_BAUDDIV_MIN) {
+		return ARM_USART_ERROR_BAUDRATE;
+	}
+	UART->BAUDDIV = divider;
+	return ARM_DRIVER_OK;
+}
+
+int32_t ARM_USART_Initialize(ARM_USART_SignalEvent_t cb_event) {
+	UART->CTRL = 0;
+	uart_set_baudrate(DEBUG_UART_BAUDRATE);
+	// Clear the pending interrupts and the overrun errors
+	UART->INTSTATUS = CMSDK_UART_INT_TX | CMSDK_UART_INT_RX;
+	UART->STATE = CMSDK_UART_STATE_TXOR | CMSDK_UART_STATE_RXOR;
+	UART->CTRL = CMSDK_UART_CTRL_TXEN | CMSDK_UART_CTRL_RXEN;
+
+	m_SignalEvent = cb_event;
+	m_tx_num = m_tx_count = 0;
+	m_rx_num = m_rx_count = 0;
+
+	if (cb_event) {
+		NVIC_ClearPendingIRQ(CMSDK_UART0_TX_IRQn);
+		NVIC_ClearPendingIRQ(CMSDK_UART0_RX_IRQn);
+		NVIC_EnableIRQ(CMSDK_UART0_TX_IRQn);
+		NVIC_EnableIRQ(CMSDK_UART0_RX_IRQn);
+	}
+
+	return ARM_DRIVER_OK;
+}
+
+int32_t ARM_USART_Uninitialize(void) {
+	NVIC_DisableIRQ(CMSDK_UART0_TX_IRQn);
+	NVIC_DisableIRQ(CMSDK_UART0_RX_IRQn);
+	UART->CTRL = 0;
+	m_SignalEvent = NULL;
+	return ARM_DRIVER_OK;
+}
+
+int32_t ARM_USART_PowerControl(ARM_POWER_STATE state) {
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+void CMSDK_UART0_TX_IRQHandler(void) {
+	UART->INTSTATUS = CMSDK_UART_INT_TX;
+
+	if (m_tx_count < m_tx_num) {
+		UART->DATA = m_tx_data[m_tx_count++];
+	} else if (m_tx_num != 0) {
+		// The transfer is complete before signaling it so the callback can start a new one
+		UART->CTRL &= ~CMSDK_UART_CTRL_TXIRQEN;
+		m_tx_num = 0;
+		m_SignalEvent(ARM_USART_EVENT_SEND_COMPLETE);
+	}
+}
+
+void CMSDK_UART0_RX_IRQHandler(void) {
+	UART->INTSTATUS = CMSDK_UART_INT_RX;
+
+	while ((m_rx_count < m_rx_num) && (UART->STATE & CMSDK_UART_STATE_RXBF)) {
+		m_rx_data[m_rx_count++] = UART->DATA;
+	}
+	if ((m_rx_num != 0) && (m_rx_count == m_rx_num)) {
+		UART->CTRL &= ~CMSDK_UART_CTRL_RXIRQEN;
+		m_rx_num = 0;
+		m_SignalEvent(ARM_USART_EVENT_RECEIVE_COMPLETE);
+	}
+}
+
+static void uart_send_byte(uint8_t data) {
+	while (UART->STATE & CMSDK_UART_STATE_TXBF);
+	UART->DATA = data;
+}
+
+int32_t ARM_USART_Send(const void *data, uint32_t num) {
+	const uint8_t *ptr = data;
+	uint32_t i;
+
+	if (m_SignalEvent) {
+		if ((data == NULL) || (num == 0)) {
+			return ARM_DRIVER_ERROR_PARAMETER;
+		} else if (m_tx_num != 0) {
+			return ARM_DRIVER_ERROR_BUSY;
+		}
+
+		NVIC_DisableIRQ(CMSDK_UART0_TX_IRQn);
+		m_tx_data = data;
+		m_tx_num = num;
+		// The TX interrupt is only raised when a byte has been sent while it is enabled:
+		// enable it before sending the first byte. The next ones are sent by the interrupt.
+		UART->CTRL |= CMSDK_UART_CTRL_TXIRQEN;
+		uart_send_byte(ptr[0]);
+		m_tx_count = 1;
+		NVIC_EnableIRQ(CMSDK_UART0_TX_IRQn);
+		return ARM_DRIVER_OK;
+	}
+
+	for (i = 0; i < num; i++) {
+		uart_send_byte(ptr[i]);
+	}
+
+	// Ensure we return carriage
+	if ((num >= 2) && (ptr[num - 1] == '\n') && (ptr[num - 2] != '\r')) {
+		_ttywrch('\r');
+	}
+
+	return num;
+}
+
+int32_t ARM_USART_Receive(void *data, uint32_t num) {
+	uint8_t *ptr = data;
+	uint32_t count = 0;
+
+	if (m_SignalEvent) {
+		if ((data == NULL) || (num == 0)) {
+			return ARM_DRIVER_ERROR_PARAMETER;
+		} else if (m_rx_num != 0) {
+			return ARM_DRIVER_ERROR_BUSY;
+		}
+
+		NVIC_DisableIRQ(CMSDK_UART0_RX_IRQn);
+		m_rx_data = data;
+		m_rx_count = 0;
+		m_rx_num = num;
+		UART->CTRL |= CMSDK_UART_CTRL_RXIRQEN;
+		// A byte might have been received before the interrupt was enabled
+		NVIC_SetPendingIRQ(CMSDK_UART0_RX_IRQn);
+		NVIC_EnableIRQ(CMSDK_UART0_RX_IRQn);
+		return ARM_DRIVER_OK;
+	}
+
+	// Return the bytes already received
+	while ((count < num) && (UART->STATE & CMSDK_UART_STATE_RXBF)) {
+		ptr[count++] = UART->DATA;
+	}
+	return count;
+}
+
+int32_t ARM_USART_Transfer(const void *data_out, void *data_in, uint32_t num) {
+	return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+uint32_t ARM_USART_GetTxCount(void) {
+	return m_tx_count;
+}
+
+uint32_t ARM_USART_GetRxCount(void) {
+	return m_rx_count;
+}
+
+int32_t ARM_USART_Control(uint32_t control, uint32_t arg) {
+	// Only the 8N1 asynchronous mode is supported
+	if ((control & ARM_USART_CONTROL_Msk) != ARM_USART_MODE_ASYNCHRONOUS) {
+		return ARM_DRIVER_ERROR_UNSUPPORTED;
+	}
+	if ((control & ARM_USART_DATA_BITS_Msk) != ARM_USART_DATA_BITS_8) {
+		return ARM_USART_ERROR_DATA_BITS;
+	}
+	if ((control & ARM_USART_PARITY_Msk) != ARM_USART_PARITY_NONE) {
+		return ARM_USART_ERROR_PARITY;
+	}
+	if ((control & ARM_USART_STOP_BITS_Msk) != ARM_USART_STOP_BITS_1) {
+		return ARM_USART_ERROR_STOP_BITS;
+	}
+	if ((control & ARM_USART_FLOW_CONTROL_Msk) != ARM_USART_FLOW_CONTROL_NONE) {
+		return ARM_USART_ERROR_FLOW_CONTROL;
+	}
+
+	return uart_set_baudrate(arg);
+}
+
+ARM_USART_STATUS ARM_USART_GetStatus(void) {
+	ARM_USART_STATUS status = { 0 };
+	uint32_t state = UART->STATE;
+
+	if ((state & CMSDK_UART_STATE_TXBF) || (m_tx_num != 0)) {
+		status.tx_busy = 1;
+	}
+	if (m_rx_num != 0) {
+		status.rx_busy = 1;
+	}
+	if (state & CMSDK_UART_STATE_RXOR) {
+		status.rx_overflow = 1;
+	}
+
+	return status;
+}
+
+int32_t ARM_USART_SetModemControl(ARM_USART_MODEM_CONTROL control) {
+	return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+ARM_USART_MODEM_STATUS ARM_USART_GetModemStatus(void) {
+	ARM_USART_MODEM_STATUS status = { 0 };
+	DEBUG_NOT_IMPLEMENTED();
+	return status;
+}
+
+void ARM_USART_SignalEvent(uint32_t event) {
+	DEBUG_NOT_IMPLEMENTED();
+}
+
+// End USART Interface
+
+const ARM_DRIVER_USART Driver_UART_DEBUG = {
+    ARM_USART_GetVersion,
+    ARM_USART_GetCapabilities,
+    ARM_USART_Initialize,
+    ARM_USART_Uninitialize,
+    ARM_USART_PowerControl,
+    ARM_USART_Send,
+    ARM_USART_Receive,
+    ARM_USART_Transfer,
+    ARM_USART_GetTxCount,
+    ARM_USART_GetRxCount,
+    ARM_USART_Control,
+    ARM_USART_GetStatus,
+    ARM_USART_SetModemControl,
+    ARM_USART_GetModemStatus
+};
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "board.h"
+#include "PolyMCU.h"
+#include "Driver_USART.h"
+
+// The FPGA IO of the MPS2 drives the LEDs 'USERLED0' and 'USERLED1'
+#define LED_COUNT  2
+
+extern const ARM_DRIVER_USART Driver_UART_DEBUG;
+
+void hardware_init_hook(void) {
+	// Switch off the LEDs
+	CMSDK_FPGAIO->LED0 = 0;
+
+#ifndef SUPPORT_DEBUG_UART_NONE
+	// Initialize UART
+	Driver_UART_DEBUG.Initialize(POLYMCU_UART_DEBUG_EVENT);
+#endif
+
+	// Ensure SystemCoreClock is set
+	SystemCoreClockUpdate();
+
+#ifdef SUPPORT_WATCHDOG
+	polymcu_watchdog_init();
+#endif
+}
+
+void led_on(int led) {
+	if (led < LED_COUNT) {
+		CMSDK_FPGAIO->LED0 |= (1 << led);
+	}
+}
+
+void led_off(int led) {
+	if (led < LED_COUNT) {
+		CMSDK_FPGAIO->LED0 &= ~(1 << led);
+	}
+}
+
+void led_toggle(int led) {
+	if (led < LED_COUNT) {
+		CMSDK_FPGAIO->LED0 ^= (1 << led);
+	}
+}
+
+void led_set(int led, int value) {
+	if (value) {
+		led_on(led);
+	} else {
+		led_off(led);
+	}
+}
+
+int led_get(int led) {
+	if (led < LED_COUNT) {
+		return (CMSDK_FPGAIO->LED0 >> led) & 1;
+	} else {
+		return 0;
+	}
+}
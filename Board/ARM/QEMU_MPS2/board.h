@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+// Cortex-M core of the MPS2 FPGA image selected by QEMU_MACHINE
+#if defined(ARMCM7)
+  #include <ARMCM7.h>
+#elif defined(ARMCM4_FP)
+  #include <ARMCM4_FP.h>
+#elif defined(ARMCM4)
+  #include <ARMCM4.h>
+#else
+  #include <ARMCM3.h>
+#endif
+#include "../../board_common.h"
+
+/*
+ * CMSDK peripherals of the MPS2 FPGA images (AN385, AN386 and AN500)
+ */
+
+typedef struct {
+	__IOM uint32_t DATA;       // Offset: 0x000 Data Register
+	__IOM uint32_t STATE;      // Offset: 0x004 Status Register
+	__IOM uint32_t CTRL;       // Offset: 0x008 Control Register
+	__IOM uint32_t INTSTATUS;  // Offset: 0x00C Interrupt Status (read) / Interrupt Clear (write)
+	__IOM uint32_t BAUDDIV;    // Offset: 0x010 Baud Rate Divider Register
+} CMSDK_UART_TypeDef;
+
+#define CMSDK_UART_STATE_TXBF       (1UL << 0)  // TX buffer full
+#define CMSDK_UART_STATE_RXBF       (1UL << 1)  // RX buffer full
+#define CMSDK_UART_STATE_TXOR       (1UL << 2)  // TX buffer overrun (write 1 to clear)
+#define CMSDK_UART_STATE_RXOR       (1UL << 3)  // RX buffer overrun (write 1 to clear)
+
+#define CMSDK_UART_CTRL_TXEN        (1UL << 0)
+#define CMSDK_UART_CTRL_RXEN        (1UL << 1)
+#define CMSDK_UART_CTRL_TXIRQEN     (1UL << 2)
+#define CMSDK_UART_CTRL_RXIRQEN     (1UL << 3)
+
+#define CMSDK_UART_INT_TX           (1UL << 0)
+#define CMSDK_UART_INT_RX           (1UL << 1)
+
+// The baud rate divider must be at least 16
+#define CMSDK_UART_BAUDDIV_MIN      16
+
+typedef struct {
+	__IOM uint32_t LED0;       // Offset: 0x000 LEDs (bit per LED)
+} CMSDK_FPGAIO_TypeDef;
+
+#define CMSDK_UART0                 ((CMSDK_UART_TypeDef*)0x40004000UL)
+#define CMSDK_FPGAIO                ((CMSDK_FPGAIO_TypeDef*)0x40028000UL)
+
+// The Device/ARM vector tables follow the legacy V2M-MPS2 interrupt map. On the FPGA images
+// emulated by QEMU, the UART0 RX and TX interrupts are the external interrupts 0 and 1.
+#define CMSDK_UART0_RX_IRQn         ((IRQn_Type)0)
+#define CMSDK_UART0_TX_IRQn         ((IRQn_Type)1)
+#define CMSDK_UART0_RX_IRQHandler   WDT_IRQHandler
+#define CMSDK_UART0_TX_IRQHandler   RTC_IRQHandler
+
+/*
+ * Semihosting support
+ */
+
+/**
+ * Terminate the emulation with the exit code `status` (see `semihosting.c`).
+ * The application terminates it with `exit()` or by returning from `main()`.
+ */
+void semihosting_exit(int status) __attribute__((noreturn));
+
+/*
+ * FreeRTOS support
+ */
+
+/* The highest interrupt priority that can be used by any interrupt service
+routine that makes calls to interrupt safe FreeRTOS API functions.  DO NOT CALL
+INTERRUPT SAFE FREERTOS API FUNCTIONS FROM ANY INTERRUPT THAT HAS A HIGHER
+PRIORITY THAN THIS! (higher priorities are lower numeric values. */
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY	5
+
+/* !!!! configMAX_SYSCALL_INTERRUPT_PRIORITY must not be set to zero !!!!
+See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY 	( configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - __NVIC_PRIO_BITS) )
+
+#endif
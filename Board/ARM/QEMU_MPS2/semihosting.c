@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//
+// ARM semihosting: report the exit code of the firmware to the emulator
+//
+// QEMU must be started with '-semihosting-config enable=on,target=native' (see 'make run').
+// Without debugger or emulator attached, the 'BKPT' instruction raises a HardFault.
+//
+
+#include <stdint.h>
+#include "board.h"
+
+#define SEMIHOSTING_SYS_EXIT              0x18
+#define SEMIHOSTING_SYS_EXIT_EXTENDED     0x20
+
+#define ADP_STOPPED_RUN_TIME_ERROR        0x20023
+#define ADP_STOPPED_APPLICATION_EXIT      0x20026
+
+static int semihosting_call(int operation, void* arg) {
+	register int r0 __asm__("r0") = operation;
+	register void* r1 __asm__("r1") = arg;
+
+	__asm__ volatile ("bkpt 0xAB" : "+r" (r0) : "r" (r1) : "memory");
+	return r0;
+}
+
+void semihosting_exit(int status) {
+	uint32_t args[2] = { ADP_STOPPED_APPLICATION_EXIT, (uint32_t)status };
+
+	// SYS_EXIT_EXTENDED passes the exit code to the host
+	semihosting_call(SEMIHOSTING_SYS_EXIT_EXTENDED, args);
+
+	// The host does not support SYS_EXIT_EXTENDED. On 32-bit targets, SYS_EXIT only
+	// reports whether the application succeeded.
+	semihosting_call(SEMIHOSTING_SYS_EXIT,
+			(void*)(status == 0 ? ADP_STOPPED_APPLICATION_EXIT : ADP_STOPPED_RUN_TIME_ERROR));
+
+	while (1);
+}
+
+// Override the newlib stub to terminate the emulation on exit() and on return from main()
+void _exit(int status) {
+	semihosting_exit(status);
+}
@@ -75,7 +75,7 @@ void hardware_init_hook(void) {
 
 #ifndef SUPPORT_DEBUG_UART_NONE
 	// Initialize UART
-	Driver_UART_DEBUG.Initialize(NULL);
+	Driver_UART_DEBUG.Initialize(POLYMCU_UART_DEBUG_EVENT);
 #endif
 
 	// Ensure SystemCoreClock is set
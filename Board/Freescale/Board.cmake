@@ -41,3 +41,8 @@ set(SUPPORT_DEBUG_UART "lpsci" CACHE STRING "Debug UART Port")
 # Build options
 #
 set(CPU "ARM Cortex-M0plus")
+
+# In tickless mode, the LPTMR keeps counting in the low power modes where the SysTick stops
+if (SUPPORT_TIMER_TICKLESS OR SUPPORT_RTOS_TICKLESS)
+  set(SUPPORT_TIMER_SYSTICK 0)
+endif()
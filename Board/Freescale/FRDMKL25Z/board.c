@@ -28,6 +28,7 @@
 
 #include "board.h"
 #include "Driver_USART.h"
+#include "PolyMCU.h"
 
 #include "fsl_common.h"
 #include "fsl_gpio.h"
@@ -175,7 +176,7 @@ void hardware_init_hook(void) {
 #ifndef SUPPORT_DEBUG_UART_NONE
 	configure_lpsci_pins();
 
-	ret = Driver_UART_DEBUG.Initialize(NULL);
+	ret = Driver_UART_DEBUG.Initialize(POLYMCU_UART_DEBUG_EVENT);
 	assert(ret == ARM_DRIVER_OK);
 #endif
 }
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PolyMCU timer on the Low Power Timer (LPTMR) clocked by the 1kHz LPO. The LPTMR keeps
+ * counting in all the low power modes. The PolyMCU timer period must divide 1000.
+ */
+
+#include "PolyMCU.h"
+
+#include "fsl_common.h"
+
+#define LPO_FREQUENCY           1000
+// The LPTMR counter is only 16-bit long
+#define LPTMR_COUNTER_MAX       (LPTMR_CMR_COMPARE_MASK + 1UL)
+
+// Number of LPO cycles in one PolyMCU tick
+static uint32_t g_tick_cycles;
+
+#ifdef SUPPORT_TIMER_TICKLESS
+// Cycles of the current tick that have elapsed before the LPTMR has been programmed
+static uint32_t g_lptmr_offset;
+
+// Reading the counter requires to latch it first
+static inline uint32_t lptmr_get_counter(void) {
+	LPTMR0->CNR = 0;
+	return LPTMR0->CNR;
+}
+
+// Return the number of cycles since the LPTMR has been programmed
+static uint32_t lptmr_get_elapsed_cycles(void) {
+	uint32_t cycles = lptmr_get_counter();
+
+	if (LPTMR0->CSR & LPTMR_CSR_TCF_MASK) {
+		// The counter has been reset on the compare match (it might have been after we read it)
+		cycles = LPTMR0->CMR + 1UL + lptmr_get_counter();
+	}
+	return cycles;
+}
+
+// The LPTMR must be disabled to change the compare value. It also resets the counter
+static void lptmr_program(uint32_t cycles) {
+	LPTMR0->CSR = 0;
+	LPTMR0->CMR = cycles - 1UL;
+	LPTMR0->CSR = LPTMR_CSR_TIE_MASK | LPTMR_CSR_TEN_MASK;
+}
+#endif
+
+void LPTMR0_IRQHandler(void) {
+#ifndef SUPPORT_TIMER_TICKLESS
+	// In tickless mode, the compare flag is cleared when the LPTMR is programmed again
+	LPTMR0->CSR |= LPTMR_CSR_TCF_MASK;
+#endif
+	polymcu_timer_irq_handler();
+}
+
+int polymcu_timer_init(unsigned int period) {
+	if ((period == 0) || (LPO_FREQUENCY % period != 0)) {
+		return 1;
+	}
+	g_tick_cycles = LPO_FREQUENCY / period;
+
+	SIM->SCGC5 |= SIM_SCGC5_LPTMR_MASK;
+
+	// Time counter mode on the LPO (clock source 1) without prescaler
+	LPTMR0->CSR = 0;
+	LPTMR0->PSR = LPTMR_PSR_PCS(1) | LPTMR_PSR_PBYP_MASK;
+	LPTMR0->CMR = g_tick_cycles - 1UL;
+
+	NVIC_SetPriority(LPTMR0_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+	NVIC_ClearPendingIRQ(LPTMR0_IRQn);
+	NVIC_EnableIRQ(LPTMR0_IRQn);
+	return 0;
+}
+
+unsigned int polymcu_timer_get_period(void) {
+	return LPO_FREQUENCY / g_tick_cycles;
+}
+
+void polymcu_timer_hw_start(void) {
+#ifdef SUPPORT_TIMER_TICKLESS
+	g_lptmr_offset = 0;
+	lptmr_program(g_tick_cycles);
+#else
+	// Generate an interrupt every 'period'. The counter is reset on the compare match
+	LPTMR0->CSR = LPTMR_CSR_TIE_MASK | LPTMR_CSR_TEN_MASK;
+#endif
+}
+
+void polymcu_timer_hw_stop(void) {
+	LPTMR0->CSR = 0;
+	NVIC_ClearPendingIRQ(LPTMR0_IRQn);
+}
+
+#ifdef SUPPORT_TIMER_TICKLESS
+unsigned int polymcu_timer_hw_get_elapsed(void) {
+	return (lptmr_get_elapsed_cycles() + g_lptmr_offset) / g_tick_cycles;
+}
+
+unsigned int polymcu_timer_hw_set_next(unsigned int elapsed, unsigned int ticks) {
+	uint32_t max_ticks = LPTMR_COUNTER_MAX / g_tick_cycles;
+	uint32_t cycles;
+
+	if (ticks > max_ticks) {
+		ticks = max_ticks;
+	}
+
+	// Keep the cycles that have not been accounted yet. Disabling the LPTMR resets
+	// the counter
+	g_lptmr_offset = lptmr_get_elapsed_cycles() + g_lptmr_offset - (elapsed * g_tick_cycles);
+
+	cycles = ticks * g_tick_cycles;
+	if (cycles > g_lptmr_offset) {
+		cycles -= g_lptmr_offset;
+	} else {
+		// The deadline has already been reached
+		cycles = 1;
+	}
+	lptmr_program(cycles);
+	NVIC_ClearPendingIRQ(LPTMR0_IRQn);
+
+	return ticks;
+}
+#endif
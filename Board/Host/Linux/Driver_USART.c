@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "Driver_USART.h"
+#include "PolyMCU.h"
+
+#define ARM_USART_DRV_VERSION    ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0)  /* driver version */
+
+/* Driver Version */
+static const ARM_DRIVER_VERSION DriverVersion = {
+    ARM_USART_API_VERSION,
+    ARM_USART_DRV_VERSION
+};
+
+/* Driver Capabilities */
+static const ARM_USART_CAPABILITIES DriverCapabilities = {
+    1, /* supports UART (Asynchronous) mode */
+    0, /* supports Synchronous Master mode */
+    0, /* supports Synchronous Slave mode */
+    0, /* supports UART Single-wire mode */
+    0, /* supports UART IrDA mode */
+    0, /* supports UART Smart Card mode */
+    0, /* Smart Card Clock generator available */
+    0, /* RTS Flow Control available */
+    0, /* CTS Flow Control available */
+    0, /* Transmit completed event: \ref ARM_USART_EVENT_TX_COMPLETE */
+    0, /* Signal receive character timeout event: \ref ARM_USART_EVENT_RX_TIMEOUT */
+    0, /* RTS Line: 0=not available, 1=available */
+    0, /* CTS Line: 0=not available, 1=available */
+    0, /* DTR Line: 0=not available, 1=available */
+    0, /* DSR Line: 0=not available, 1=available */
+    0, /* DCD Line: 0=not available, 1=available */
+    0, /* RI Line: 0=not available, 1=available */
+    0, /* Signal CTS change event: \ref ARM_USART_EVENT_CTS */
+    0, /* Signal DSR change event: \ref ARM_USART_EVENT_DSR */
+    0, /* Signal DCD change event: \ref ARM_USART_EVENT_DCD */
+    0  /* Signal RI change event: \ref ARM_USART_EVENT_RI */
+};
+
+static ARM_USART_SignalEvent_t m_SignalEvent;
+
+// By default the debug UART is mapped on the process standard input/output
+static int m_tx_fd = STDOUT_FILENO;
+static int m_rx_fd = STDIN_FILENO;
+
+static uint32_t m_tx_count;
+static uint32_t m_rx_count;
+
+//
+//   Functions
+//
+
+ARM_DRIVER_VERSION ARM_USART_GetVersion(void) {
+	return DriverVersion;
+}
+
+ARM_USART_CAPABILITIES ARM_USART_GetCapabilities(void) {
+	return DriverCapabilities;
+}
+
+int32_t ARM_USART_Initialize(ARM_USART_SignalEvent_t cb_event) {
+	m_SignalEvent = cb_event;
+
+#ifdef HOST_UART_PTY
+	// Expose the debug UART as a pseudo-terminal a terminal emulator can be connected to
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if ((fd < 0) || (grantpt(fd) != 0) || (unlockpt(fd) != 0)) {
+		return ARM_DRIVER_ERROR;
+	}
+
+	fprintf(stderr, "Debug UART: %s\n", ptsname(fd));
+	m_tx_fd = fd;
+	m_rx_fd = fd;
+#endif
+
+	return ARM_DRIVER_OK;
+}
+
+int32_t ARM_USART_Uninitialize(void) {
+#ifdef HOST_UART_PTY
+	close(m_tx_fd);
+#endif
+	m_tx_fd = STDOUT_FILENO;
+	m_rx_fd = STDIN_FILENO;
+	return ARM_DRIVER_OK;
+}
+
+int32_t ARM_USART_PowerControl(ARM_POWER_STATE state) {
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+int32_t ARM_USART_Send(const void *data, uint32_t num) {
+	const char *ptr = data;
+	uint32_t sent = 0;
+	ssize_t ret;
+
+	while (sent < num) {
+		ret = write(m_tx_fd, ptr + sent, num - sent);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return ARM_DRIVER_ERROR;
+		}
+		sent += ret;
+	}
+
+	// Unlike the other drivers, the carriage return is not added: the host terminal does it
+
+	m_tx_count = num;
+	if (m_SignalEvent) {
+		m_SignalEvent(ARM_USART_EVENT_SEND_COMPLETE);
+	}
+	return num;
+}
+
+int32_t ARM_USART_Receive(void *data, uint32_t num) {
+	char *ptr = data;
+	uint32_t received = 0;
+	ssize_t ret;
+
+	while (received < num) {
+		ret = read(m_rx_fd, ptr + received, num - received);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return ARM_DRIVER_ERROR;
+		} else if (ret == 0) {
+			// End of file
+			break;
+		}
+		received += ret;
+	}
+
+	m_rx_count = received;
+	if (m_SignalEvent && (received == num)) {
+		m_SignalEvent(ARM_USART_EVENT_RECEIVE_COMPLETE);
+	}
+	return received;
+}
+
+int32_t ARM_USART_Transfer(const void *data_out, void *data_in, uint32_t num) {
+	return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+uint32_t ARM_USART_GetTxCount(void) {
+	return m_tx_count;
+}
+
+uint32_t ARM_USART_GetRxCount(void) {
+	return m_rx_count;
+}
+
+int32_t ARM_USART_Control(uint32_t control, uint32_t arg) {
+	// The host does not have any line settings
+	return ARM_DRIVER_OK;
+}
+
+ARM_USART_STATUS ARM_USART_GetStatus(void) {
+	ARM_USART_STATUS status = { 0 };
+	return status;
+}
+
+int32_t ARM_USART_SetModemControl(ARM_USART_MODEM_CONTROL control) {
+	return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+ARM_USART_MODEM_STATUS ARM_USART_GetModemStatus(void) {
+	ARM_USART_MODEM_STATUS status = { 0 };
+	DEBUG_NOT_IMPLEMENTED();
+	return status;
+}
+
+void ARM_USART_SignalEvent(uint32_t event) {
+	DEBUG_NOT_IMPLEMENTED();
+}
+
+// End USART Interface
+
+const ARM_DRIVER_USART Driver_UART_DEBUG = {
+    ARM_USART_GetVersion,
+    ARM_USART_GetCapabilities,
+    ARM_USART_Initialize,
+    ARM_USART_Uninitialize,
+    ARM_USART_PowerControl,
+    ARM_USART_Send,
+    ARM_USART_Receive,
+    ARM_USART_Transfer,
+    ARM_USART_GetTxCount,
+    ARM_USART_GetRxCount,
+    ARM_USART_Control,
+    ARM_USART_GetStatus,
+    ARM_USART_SetModemControl,
+    ARM_USART_GetModemStatus
+};
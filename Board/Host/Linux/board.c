@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "Driver_USART.h"
+#include "PolyMCU.h"
+
+#define LED_COUNT  4
+
+extern const ARM_DRIVER_USART Driver_UART_DEBUG;
+
+// Debug UART backend of PolyMCU (newlib system calls on the targets)
+int _write(int fd, char *ptr, int len);
+int _read(int fd, char *ptr, int len);
+
+uint32_t SystemCoreClock = 1000000000;
+
+// Emulated PRIMASK: held by the code in critical section and by the running interrupt
+static pthread_mutex_t g_host_irq_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread uint32_t g_host_ipsr;
+static __thread uint32_t g_host_critical_nesting;
+
+// Used by the emulated WFI to wait for the next interrupt
+static pthread_mutex_t g_host_wfi_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_host_wfi_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int g_host_irq_count;
+
+static int g_leds[LED_COUNT];
+
+static ssize_t host_stdout_write(void *cookie, const char *buf, size_t size) {
+	return _write(STDOUT_FILENO, (char*)buf, size);
+}
+
+static ssize_t host_stdin_read(void *cookie, char *buf, size_t size) {
+	return _read(STDIN_FILENO, buf, size);
+}
+
+// Equivalent of 'hardware_init_hook()' called by newlib on the targets
+__attribute__((constructor)) static void host_init(void) {
+	cookie_io_functions_t stdout_funcs = { .write = host_stdout_write };
+	cookie_io_functions_t stdin_funcs = { .read = host_stdin_read };
+
+	Driver_UART_DEBUG.Initialize(POLYMCU_UART_DEBUG_EVENT);
+
+	// Unlike newlib, the C library of the host does not call '_write()' and '_read()'.
+	// Redirect the standard streams to the PolyMCU debug UART support
+	stdout = fopencookie(NULL, "w", stdout_funcs);
+	setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+	stdin = fopencookie(NULL, "r", stdin_funcs);
+}
+
+void critical_section_enter(void) {
+	pthread_mutex_lock(&g_host_irq_lock);
+	g_host_critical_nesting++;
+}
+
+void critical_section_exit(void) {
+	g_host_critical_nesting--;
+	pthread_mutex_unlock(&g_host_irq_lock);
+}
+
+void host_irq_run(void (*handler)(void)) {
+	pthread_mutex_lock(&g_host_irq_lock);
+	g_host_ipsr = 16; // First external interrupt
+	handler();
+	g_host_ipsr = 0;
+	pthread_mutex_unlock(&g_host_irq_lock);
+
+	pthread_mutex_lock(&g_host_wfi_lock);
+	g_host_irq_count++;
+	pthread_cond_broadcast(&g_host_wfi_cond);
+	pthread_mutex_unlock(&g_host_wfi_lock);
+}
+
+void host_wait_for_interrupt(void) {
+	struct timespec timeout;
+	unsigned int irq_count;
+
+	// Like WFI, the wait is bounded: an interrupt might have been missed before the call
+	clock_gettime(CLOCK_REALTIME, &timeout);
+	timeout.tv_nsec += 1000000;
+	if (timeout.tv_nsec >= 1000000000) {
+		timeout.tv_sec++;
+		timeout.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&g_host_wfi_lock);
+	irq_count = g_host_irq_count;
+	while (irq_count == g_host_irq_count) {
+		if (pthread_cond_timedwait(&g_host_wfi_cond, &g_host_wfi_lock, &timeout) == ETIMEDOUT) {
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_host_wfi_lock);
+}
+
+uint32_t host_get_ipsr(void) {
+	return g_host_ipsr;
+}
+
+uint32_t host_get_primask(void) {
+	return g_host_critical_nesting != 0;
+}
+
+void* _sbrk_r(void *reent, ptrdiff_t incr) {
+	void* prev_heap_end = sbrk(incr);
+
+	if (prev_heap_end == (void*)-1) {
+		errno = ENOMEM;
+	}
+	return prev_heap_end;
+}
+
+void led_on(int led) {
+	led_set(led, 1);
+}
+
+void led_off(int led) {
+	led_set(led, 0);
+}
+
+void led_toggle(int led) {
+	led_set(led, !led_get(led));
+}
+
+void led_set(int led, int value) {
+	if ((led >= 0) && (led < LED_COUNT)) {
+		g_leds[led] = value;
+	}
+}
+
+int  led_get(int led) {
+	if ((led >= 0) && (led < LED_COUNT)) {
+		return g_leds[led];
+	} else {
+		return 0;
+	}
+}
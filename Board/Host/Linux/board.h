@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+#include <stdint.h>
+#include "../../board_common.h"
+
+/*
+ * Emulation of the Cortex-M core on a Linux host.
+ * The interrupts are run by host threads. They are serialized with the code in
+ * critical section by a recursive lock (the emulated PRIMASK).
+ */
+
+// One cycle per nanosecond
+extern uint32_t SystemCoreClock;
+
+// Run `handler` as an interrupt handler
+void host_irq_run(void (*handler)(void));
+
+// Wait for the next emulated interrupt (or 1ms)
+void host_wait_for_interrupt(void);
+
+uint32_t host_get_ipsr(void);
+uint32_t host_get_primask(void);
+
+#define __WFI()             host_wait_for_interrupt()
+#define __WFE()             host_wait_for_interrupt()
+#define __NOP()             do { } while (0)
+#define __DMB()             __sync_synchronize()
+#define __DSB()             __sync_synchronize()
+#define __ISB()             __sync_synchronize()
+#define __BKPT(value)       __builtin_trap()
+#define __get_IPSR()        host_get_ipsr()
+#define __get_PRIMASK()     host_get_primask()
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "PolyMCU.h"
+
+static int g_timer_fd = -1;
+static pthread_t g_timer_thread;
+
+static unsigned int g_period = 0;
+// Duration of one PolyMCU tick in nanoseconds
+static uint64_t g_tick_ns;
+
+#ifdef SUPPORT_TIMER_TICKLESS
+// Time of the last accounted PolyMCU tick in nanoseconds
+static uint64_t g_base;
+
+static uint64_t host_timer_now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+#endif
+
+static void host_timer_ns_to_timespec(uint64_t ns, struct timespec *ts) {
+	ts->tv_sec  = ns / 1000000000ULL;
+	ts->tv_nsec = ns % 1000000000ULL;
+}
+
+// Thread emulating the timer interrupt
+static void* host_timer_thread(void *arg) {
+	uint64_t expirations;
+
+	while (1) {
+		if (read(g_timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+			continue;
+		}
+
+		while (expirations--) {
+			host_irq_run(polymcu_timer_irq_handler);
+		}
+	}
+	return NULL;
+}
+
+// Generate an interrupt every 'period'
+int polymcu_timer_init(unsigned int period) {
+	if ((period == 0) || (period > 1000000000)) {
+		return 1;
+	}
+
+	g_timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
+	if (g_timer_fd < 0) {
+		return 1;
+	}
+
+	g_period  = period;
+	g_tick_ns = 1000000000ULL / period;
+
+	if (pthread_create(&g_timer_thread, NULL, host_timer_thread, NULL) != 0) {
+		close(g_timer_fd);
+		g_timer_fd = -1;
+		return 1;
+	}
+	return 0;
+}
+
+unsigned int polymcu_timer_get_period(void) {
+	return g_period;
+}
+
+void polymcu_timer_hw_start(void) {
+	struct itimerspec its;
+
+	memset(&its, 0, sizeof(its));
+	host_timer_ns_to_timespec(g_tick_ns, &its.it_value);
+#ifdef SUPPORT_TIMER_TICKLESS
+	g_base = host_timer_now();
+#else
+	its.it_interval = its.it_value;
+#endif
+	timerfd_settime(g_timer_fd, 0, &its, NULL);
+}
+
+void polymcu_timer_hw_stop(void) {
+	struct itimerspec its;
+
+	memset(&its, 0, sizeof(its));
+	timerfd_settime(g_timer_fd, 0, &its, NULL);
+}
+
+#ifdef SUPPORT_TIMER_TICKLESS
+unsigned int polymcu_timer_hw_get_elapsed(void) {
+	return (host_timer_now() - g_base) / g_tick_ns;
+}
+
+unsigned int polymcu_timer_hw_set_next(unsigned int elapsed, unsigned int ticks) {
+	struct itimerspec its;
+
+	g_base += elapsed * g_tick_ns;
+
+	// The deadline is absolute: it is not delayed by the time spent programming it.
+	// An absolute deadline in the past expires immediately
+	memset(&its, 0, sizeof(its));
+	host_timer_ns_to_timespec(g_base + (ticks * g_tick_ns), &its.it_value);
+	timerfd_settime(g_timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+
+	return ticks;
+}
+#endif
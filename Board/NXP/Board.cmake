@@ -53,4 +53,9 @@ set(MCU_DEVICE lpc_chip_175x_6x)
 # NXP LPC1768mbed contains a ARM Cortex-M3 r2p0
 add_definitions(-D__CM3_REV=0x0200)
 
+# In tickless mode, the 32-bit RIT counter sleeps longer than the 24-bit SysTick
+if (SUPPORT_TIMER_TICKLESS OR SUPPORT_RTOS_TICKLESS)
+  set(SUPPORT_TIMER_SYSTICK 0)
+endif()
+
 set(POST_BUILD_COMMANDS lpcrc $<TARGET_PROPERTY:Firmware,OUTPUT_NAME>.bin)
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * PolyMCU timer on the Repetitive Interrupt Timer (RIT) of the LPC17xx. Its 32-bit
+ * counter lets the core sleep for minutes in tickless mode where the 24-bit SysTick
+ * would wake it up every 174ms at 96MHz.
+ */
+
+#include "PolyMCU.h"
+
+#include "chip.h"
+
+#ifdef SUPPORT_TIMER_TICKLESS
+// Minimum number of cycles to program the RIT compare value for
+#define RIT_MIN_CYCLES	64
+#endif
+
+// Number of RIT cycles in one PolyMCU tick
+static uint32_t g_tick_cycles;
+
+#ifdef SUPPORT_TIMER_TICKLESS
+// RIT counter value of the last accounted PolyMCU tick
+static uint32_t g_base;
+#endif
+
+void RIT_IRQHandler(void) {
+	Chip_RIT_ClearInt(LPC_RITIMER);
+	polymcu_timer_irq_handler();
+}
+
+int polymcu_timer_init(unsigned int period) {
+	Chip_RIT_Init(LPC_RITIMER);
+	// The RIT is only enabled when the first timer task is started. Stop it on debug halt.
+	LPC_RITIMER->CTRL = RIT_CTRL_ENBR;
+
+	g_tick_cycles = Chip_Clock_GetPeripheralClockRate(SYSCTL_PCLK_RIT) / period;
+	if (g_tick_cycles == 0) {
+		return 1;
+	}
+
+#ifndef SUPPORT_TIMER_TICKLESS
+	// Generate an interrupt every 'period'. The counter is cleared on the match
+	Chip_RIT_SetCOMPVAL(LPC_RITIMER, g_tick_cycles - 1);
+	Chip_RIT_EnableCTRL(LPC_RITIMER, RIT_CTRL_ENCLR);
+#endif
+
+	NVIC_SetPriority(RITIMER_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+	NVIC_ClearPendingIRQ(RITIMER_IRQn);
+	NVIC_EnableIRQ(RITIMER_IRQn);
+	return 0;
+}
+
+unsigned int polymcu_timer_get_period(void) {
+	return Chip_Clock_GetPeripheralClockRate(SYSCTL_PCLK_RIT) / g_tick_cycles;
+}
+
+void polymcu_timer_hw_start(void) {
+	LPC_RITIMER->COUNTER = 0;
+#ifdef SUPPORT_TIMER_TICKLESS
+	g_base = 0;
+#endif
+	Chip_RIT_Enable(LPC_RITIMER);
+}
+
+void polymcu_timer_hw_stop(void) {
+	Chip_RIT_Disable(LPC_RITIMER);
+}
+
+#ifdef SUPPORT_TIMER_TICKLESS
+unsigned int polymcu_timer_hw_get_elapsed(void) {
+	return (Chip_RIT_GetCounter(LPC_RITIMER) - g_base) / g_tick_cycles;
+}
+
+unsigned int polymcu_timer_hw_set_next(unsigned int elapsed, unsigned int ticks) {
+	// Keep the deadlines within half of the 32-bit counter range
+	uint32_t max_ticks = (1UL << 31) / g_tick_cycles;
+	uint32_t compare, now;
+
+	if (ticks > max_ticks) {
+		ticks = max_ticks;
+	}
+
+	// The counter is free running, only the compare value moves
+	g_base += elapsed * g_tick_cycles;
+	compare = g_base + (ticks * g_tick_cycles);
+
+	// Ensure the deadline has not already been passed while programming it
+	now = Chip_RIT_GetCounter(LPC_RITIMER);
+	if ((int)(compare - now) < RIT_MIN_CYCLES) {
+		compare = now + RIT_MIN_CYCLES;
+	}
+	Chip_RIT_SetCOMPVAL(LPC_RITIMER, compare);
+
+	return ticks;
+}
+#endif
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include "board.h"
 #include "Driver_USART.h"
+#include "PolyMCU.h"
 #include "boards.h"
 #include "app_error.h"
 #if defined(__CMSIS_RTOS) && defined(SOFTDEVICE_PRESENT)
@@ -45,7 +46,7 @@ void hardware_init_hook(void) {
     LEDS_OFF(LEDS_MASK);
 
 	// Initialize UART
-	Driver_UART_DEBUG.Initialize(NULL);
+	Driver_UART_DEBUG.Initialize(POLYMCU_UART_DEBUG_EVENT);
 
 #if defined(__CMSIS_RTOS) && defined(SOFTDEVICE_PRESENT)
     // Initialize the SoftDevice handler module.
@@ -34,6 +34,13 @@ static const nrf_drv_timer_t POLYMCU_HW_TIMER = NRF_DRV_TIMER_INSTANCE(0);
 
 static int g_period = 0;
 
+#ifdef SUPPORT_TIMER_TICKLESS
+// Number of HW timer ticks in one PolyMCU tick
+static uint32_t g_tick_hw_ticks;
+// HW timer value of the last accounted PolyMCU tick
+static uint32_t g_base;
+#endif
+
 void polymcu_timer_event_handler(nrf_timer_event_t event_type, void* p_context) {
 	polymcu_timer_irq_handler();
 }
@@ -51,10 +58,15 @@ int polymcu_timer_init(unsigned int period) {
     } else {
     	g_period = period;
 
+#ifdef SUPPORT_TIMER_TICKLESS
+    	// The HW timer is free running. The compare channel is programmed for the next deadline
+    	g_tick_hw_ticks = nrf_drv_timer_us_to_ticks(&POLYMCU_HW_TIMER, 1000000 / period);
+#else
     	uint32_t time_ticks = nrf_drv_timer_ms_to_ticks(&POLYMCU_HW_TIMER, 1000 / period);
 
         nrf_drv_timer_extended_compare(
              &POLYMCU_HW_TIMER, NRF_TIMER_CC_CHANNEL0, time_ticks, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, true);
+#endif
 
     	nrf_drv_timer_power_on(&POLYMCU_HW_TIMER);
     }
@@ -66,9 +78,45 @@ unsigned int polymcu_timer_get_period(void) {
 }
 
 void polymcu_timer_hw_start(void) {
+#ifdef SUPPORT_TIMER_TICKLESS
+	nrf_drv_timer_clear(&POLYMCU_HW_TIMER);
+	g_base = 0;
+#endif
 	nrf_drv_timer_resume(&POLYMCU_HW_TIMER);
 }
 
 void polymcu_timer_hw_stop(void) {
 	nrf_drv_timer_pause(&POLYMCU_HW_TIMER);
 }
+
+#ifdef SUPPORT_TIMER_TICKLESS
+unsigned int polymcu_timer_hw_get_elapsed(void) {
+	// Channel 1 is only used to capture the current HW timer value
+	uint32_t now = nrf_drv_timer_capture(&POLYMCU_HW_TIMER, NRF_TIMER_CC_CHANNEL1);
+
+	return (now - g_base) / g_tick_hw_ticks;
+}
+
+unsigned int polymcu_timer_hw_set_next(unsigned int elapsed, unsigned int ticks) {
+	// Wake up at least every 2^30 CPU cycles to keep the 64-bit PolyMCU time up to date.
+	// It also keeps the deadlines within half of the 32-bit HW timer range
+	uint32_t max_ticks = nrf_drv_timer_us_to_ticks(&POLYMCU_HW_TIMER, (1UL << 30) / (SystemCoreClock / 1000000)) / g_tick_hw_ticks;
+	uint32_t compare, now;
+
+	if (ticks > max_ticks) {
+		ticks = max_ticks;
+	}
+
+	g_base += elapsed * g_tick_hw_ticks;
+	compare = g_base + (ticks * g_tick_hw_ticks);
+	nrf_drv_timer_compare(&POLYMCU_HW_TIMER, NRF_TIMER_CC_CHANNEL0, compare, true);
+
+	// Ensure the deadline has not already been passed while programming it
+	now = nrf_drv_timer_capture(&POLYMCU_HW_TIMER, NRF_TIMER_CC_CHANNEL1);
+	if ((int)(compare - now) <= 0) {
+		nrf_drv_timer_compare(&POLYMCU_HW_TIMER, NRF_TIMER_CC_CHANNEL0, now + 2, true);
+	}
+
+	return ticks;
+}
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tickless PolyMCU timer on the RTC. Unlike TIMER0, the RTC runs from the 32kHz clock
+ * and does not keep the high frequency clock running while the core sleeps.
+ * The RTC1 is used on nRF51 (it cannot be used with 'app_timer') and RTC2 on nRF52.
+ */
+
+#include "PolyMCU.h"
+
+#include "nrf.h"
+#include "nrf_drv_clock.h"
+
+#ifndef SUPPORT_TIMER_TICKLESS
+  #error "The RTC PolyMCU timer only supports the tickless mode"
+#endif
+
+#ifdef NRF52
+  #define POLYMCU_RTC             NRF_RTC2
+  #define POLYMCU_RTC_IRQn        RTC2_IRQn
+  #define POLYMCU_RTC_IRQHandler  RTC2_IRQHandler
+#else
+  #define POLYMCU_RTC             NRF_RTC1
+  #define POLYMCU_RTC_IRQn        RTC1_IRQn
+  #define POLYMCU_RTC_IRQHandler  RTC1_IRQHandler
+#endif
+
+#define RTC_FREQUENCY           32768
+#define RTC_COUNTER_MASK        0xFFFFFF
+// The RTC misses a compare value closer than 2 cycles to the counter
+#define RTC_MIN_CYCLES          2
+// Keep the deadlines within half of the 24-bit counter range
+#define RTC_MAX_CYCLES          (RTC_COUNTER_MASK / 2)
+
+static unsigned int g_period;
+// RTC counter value of the last accounted PolyMCU tick (rounded down)
+static uint32_t g_base;
+// Fraction of RTC cycle of the last accounted tick after 'g_base' (in 1/g_period cycle).
+// A PolyMCU tick is rarely a whole number of 32kHz cycles.
+static uint32_t g_base_remainder;
+
+void POLYMCU_RTC_IRQHandler(void) {
+	POLYMCU_RTC->EVENTS_COMPARE[0] = 0;
+	polymcu_timer_irq_handler();
+}
+
+int polymcu_timer_init(unsigned int period) {
+	uint32_t err_code;
+
+	if ((period == 0) || (period > RTC_FREQUENCY)) {
+		return 1;
+	}
+
+	// The RTC requires the low frequency clock
+	err_code = nrf_drv_clock_init();
+	if ((err_code != NRF_SUCCESS) && (err_code != MODULE_ALREADY_INITIALIZED)) {
+		return err_code;
+	}
+	nrf_drv_clock_lfclk_request(NULL);
+
+	g_period = period;
+
+	POLYMCU_RTC->TASKS_STOP = 1;
+	POLYMCU_RTC->PRESCALER = 0;
+	POLYMCU_RTC->EVTENSET = RTC_EVTENSET_COMPARE0_Msk;
+	POLYMCU_RTC->INTENSET = RTC_INTENSET_COMPARE0_Msk;
+
+	NVIC_SetPriority(POLYMCU_RTC_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+	NVIC_ClearPendingIRQ(POLYMCU_RTC_IRQn);
+	NVIC_EnableIRQ(POLYMCU_RTC_IRQn);
+	return 0;
+}
+
+unsigned int polymcu_timer_get_period(void) {
+	return g_period;
+}
+
+void polymcu_timer_hw_start(void) {
+	POLYMCU_RTC->TASKS_CLEAR = 1;
+	g_base = 0;
+	g_base_remainder = 0;
+	POLYMCU_RTC->TASKS_START = 1;
+}
+
+void polymcu_timer_hw_stop(void) {
+	POLYMCU_RTC->TASKS_STOP = 1;
+	POLYMCU_RTC->EVENTS_COMPARE[0] = 0;
+	NVIC_ClearPendingIRQ(POLYMCU_RTC_IRQn);
+}
+
+unsigned int polymcu_timer_hw_get_elapsed(void) {
+	uint64_t cycles = (POLYMCU_RTC->COUNTER - g_base) & RTC_COUNTER_MASK;
+	uint64_t position = cycles * g_period;
+
+	if (position < g_base_remainder) {
+		return 0;
+	} else {
+		return (position - g_base_remainder) / RTC_FREQUENCY;
+	}
+}
+
+unsigned int polymcu_timer_hw_set_next(unsigned int elapsed, unsigned int ticks) {
+	unsigned int max_ticks = ((uint64_t)RTC_MAX_CYCLES * g_period) / RTC_FREQUENCY;
+	uint64_t position;
+	uint32_t compare, now;
+
+	if (ticks > max_ticks) {
+		ticks = max_ticks;
+	}
+
+	// Move the base to the last accounted tick
+	position = g_base_remainder + ((uint64_t)elapsed * RTC_FREQUENCY);
+	g_base = (g_base + (uint32_t)(position / g_period)) & RTC_COUNTER_MASK;
+	g_base_remainder = position % g_period;
+
+	// Round the deadline up to the next RTC cycle
+	position = g_base_remainder + ((uint64_t)ticks * RTC_FREQUENCY);
+	compare = (g_base + (uint32_t)((position + g_period - 1) / g_period)) & RTC_COUNTER_MASK;
+
+	// Ensure the deadline has not already been passed while programming it
+	now = POLYMCU_RTC->COUNTER;
+	if (((compare - now) & RTC_COUNTER_MASK) < RTC_MIN_CYCLES ||
+		((compare - now) & RTC_COUNTER_MASK) > RTC_MAX_CYCLES)
+	{
+		compare = (now + RTC_MIN_CYCLES) & RTC_COUNTER_MASK;
+	}
+	POLYMCU_RTC->CC[0] = compare;
+
+	return ticks;
+}
@@ -28,6 +28,7 @@
 #include "stm32l4xx_hal.h"
 #include "stm32l4xx_nucleo.h"
 #include "Driver_USART.h"
+#include "PolyMCU.h"
 
 extern const ARM_DRIVER_USART Driver_UART_DEBUG;
 
@@ -110,7 +111,7 @@ void hardware_init_hook(void) {
 	SystemClock_Config();
 
 	// Initialize UART
-	Driver_UART_DEBUG.Initialize(NULL);
+	Driver_UART_DEBUG.Initialize(POLYMCU_UART_DEBUG_EVENT);
 
 	// Ensure SystemCoreClock is set
 	SystemCoreClockUpdate();
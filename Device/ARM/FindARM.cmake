@@ -26,12 +26,11 @@
 
 find_package(CMSIS)
 
-# Extract the CPU from the Board
-string(REGEX REPLACE "ARM/" "" _board_cpu ${BOARD})
+# The CPU ('ARM_DEVICE') is selected by the Board
 
 # MCU specific definitions
-set(MCU_EXE_LINKER_FLAGS "-T ${CMAKE_CURRENT_LIST_DIR}/${_board_cpu}/Source/GCC/gcc_arm.ld")
+set(MCU_EXE_LINKER_FLAGS "-T ${CMAKE_CURRENT_LIST_DIR}/${ARM_DEVICE}/Source/GCC/gcc_arm.ld")
 
-include_directories(${CMAKE_CURRENT_LIST_DIR}/${_board_cpu}/Include)
+include_directories(${CMAKE_CURRENT_LIST_DIR}/${ARM_DEVICE}/Include)
 
 set(ARM_LIBRARIES device_arm)
@@ -253,7 +253,7 @@ int32_t ARM_USART_Send(const void *data, uint32_t num) {
 	const char *ptr = data; int len = num;
 	char* new_data;
 	VCOM_DATA_T *pVcom = &g_vCOM;
-	uint32_t ret = 0;
+	int32_t ret = ARM_DRIVER_ERROR_BUSY;
 
 	if ( (pVcom->tx_flags & VCOM_TX_CONNECTED) && ((pVcom->tx_flags & VCOM_TX_BUSY) == 0) ) {
 		pVcom->tx_flags |= VCOM_TX_BUSY;
@@ -53,6 +53,11 @@
   #define Chip_UART_Read           Chip_UART0_Read
   #define Chip_UART_ReadLineStatus Chip_UART0_ReadLineStatus
   #define Chip_UART_DeInit         Chip_UART0_DeInit
+  #define Chip_UART_SendByte       Chip_UART0_SendByte
+  #define Chip_UART_ReadByte       Chip_UART0_ReadByte
+  #define Chip_UART_IntEnable      Chip_UART0_IntEnable
+  #define Chip_UART_IntDisable     Chip_UART0_IntDisable
+  #define Chip_UART_ReadIntIDReg   Chip_UART0_ReadIntIDReg
 
   #define UART_LCR_WLEN8           UART0_LCR_WLEN8
   #define UART_LCR_SBS_1BIT        UART0_LCR_SBS_1BIT
@@ -73,11 +78,29 @@
   #define UART_LSR_BI              UART0_LSR_BI
   #define UART_LSR_FE              UART0_LSR_FE
   #define UART_LSR_PE              UART0_LSR_PE
+  #define UART_LSR_THRE            UART0_LSR_THRE
+  #define UART_IER_RBRINT          UART0_IER_RBRINT
+  #define UART_IER_THREINT         UART0_IER_THREINT
+  #define UART_IIR_INTSTAT_PEND    UART0_IIR_INTSTAT_PEND
+  #define UART_IIR_INTID_MASK      UART0_IIR_INTID_MASK
+  #define UART_IIR_INTID_RLS       UART0_IIR_INTID_RLS
+  #define UART_IIR_INTID_RDA       UART0_IIR_INTID_RDA
+  #define UART_IIR_INTID_CTI       UART0_IIR_INTID_CTI
+  #define UART_IIR_INTID_THRE      UART0_IIR_INTID_THRE
+  #define UART_TX_FIFO_SIZE        UART0_TX_FIFO_SIZE
 
 #elif CHIP_LPC175X_6X
   #define LPC_UART      LPC_UART0
 #endif
 
+#ifdef CHIP_LPC11U6X
+  #define LPC_UART_IRQn            USART0_IRQn
+  #define LPC_UART_IRQHandler      UART0_IRQHandler
+#else
+  #define LPC_UART_IRQn            UART0_IRQn
+  #define LPC_UART_IRQHandler      UART_IRQHandler
+#endif
+
 void _ttywrch(int ch);
 
 /* Driver Version */
@@ -113,6 +136,16 @@ static const ARM_USART_CAPABILITIES DriverCapabilities = {
 
 static ARM_USART_SignalEvent_t m_SignalEvent;
 
+// When an event callback is registered, Send() and Receive() only start the transfer.
+// The data is then moved by the UART interrupt and the completion is signaled with
+// the callback. Without callback, the transfers are blocking.
+static const uint8_t* volatile m_tx_data;
+static volatile uint32_t m_tx_num;
+static volatile uint32_t m_tx_count;
+static uint8_t* volatile m_rx_data;
+static volatile uint32_t m_rx_num;
+static volatile uint32_t m_rx_count;
+
 //
 //   Functions
 //
@@ -148,11 +181,21 @@ int32_t ARM_USART_Initialize(ARM_USART_SignalEvent_t cb_event) {
 	Chip_UART_TXEnable(LPC_UART);
 
 	m_SignalEvent = cb_event;
+	m_tx_num = m_tx_count = 0;
+	m_rx_num = m_rx_count = 0;
+
+	if (cb_event) {
+		NVIC_ClearPendingIRQ(LPC_UART_IRQn);
+		NVIC_EnableIRQ(LPC_UART_IRQn);
+	}
 
 	return ARM_DRIVER_OK;
 }
 
 int32_t ARM_USART_Uninitialize(void) {
+	NVIC_DisableIRQ(LPC_UART_IRQn);
+	Chip_UART_IntDisable(LPC_UART, UART_IER_RBRINT | UART_IER_THREINT);
+	m_SignalEvent = NULL;
 	Chip_UART_DeInit(LPC_UART);
 	return ARM_DRIVER_OK;
 }
@@ -161,7 +204,78 @@ int32_t ARM_USART_PowerControl(ARM_POWER_STATE state) {
     return ARM_DRIVER_ERROR_UNSUPPORTED;
 }
 
+// Push the pending bytes into the TX FIFO. The FIFO can only be refilled once empty.
+static void uart_tx_fill(void) {
+	uint32_t i;
+
+	if (Chip_UART_ReadLineStatus(LPC_UART) & UART_LSR_THRE) {
+		for (i = 0; (i < UART_TX_FIFO_SIZE) && (m_tx_count < m_tx_num); i++) {
+			Chip_UART_SendByte(LPC_UART, m_tx_data[m_tx_count++]);
+		}
+	}
+}
+
+// Move the received bytes from the RX FIFO into the receive buffer.
+// Return 1 when the receive buffer is full.
+static int uart_rx_drain(void) {
+	while ((m_rx_count < m_rx_num) && (Chip_UART_ReadLineStatus(LPC_UART) & UART_LSR_RDR)) {
+		m_rx_data[m_rx_count++] = Chip_UART_ReadByte(LPC_UART);
+	}
+	return (m_rx_num != 0) && (m_rx_count == m_rx_num);
+}
+
+void LPC_UART_IRQHandler(void) {
+	uint32_t iir;
+
+	while (((iir = Chip_UART_ReadIntIDReg(LPC_UART)) & UART_IIR_INTSTAT_PEND) == 0) {
+		switch (iir & UART_IIR_INTID_MASK) {
+		case UART_IIR_INTID_RLS:
+			// Reading the line status clears the error
+			Chip_UART_ReadLineStatus(LPC_UART);
+			break;
+		case UART_IIR_INTID_RDA:
+		case UART_IIR_INTID_CTI:
+			if (uart_rx_drain()) {
+				// The transfer is complete before signaling it so the callback can start a new one
+				Chip_UART_IntDisable(LPC_UART, UART_IER_RBRINT);
+				m_rx_num = 0;
+				m_SignalEvent(ARM_USART_EVENT_RECEIVE_COMPLETE);
+			}
+			break;
+		case UART_IIR_INTID_THRE:
+			if (m_tx_count < m_tx_num) {
+				uart_tx_fill();
+			} else {
+				Chip_UART_IntDisable(LPC_UART, UART_IER_THREINT);
+				m_tx_num = 0;
+				m_SignalEvent(ARM_USART_EVENT_SEND_COMPLETE);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
 int32_t ARM_USART_Send(const void *data, uint32_t num) {
+	if (m_SignalEvent) {
+		if ((data == NULL) || (num == 0)) {
+			return ARM_DRIVER_ERROR_PARAMETER;
+		} else if (m_tx_num != 0) {
+			return ARM_DRIVER_ERROR_BUSY;
+		}
+
+		NVIC_DisableIRQ(LPC_UART_IRQn);
+		m_tx_data = data;
+		m_tx_count = 0;
+		m_tx_num = num;
+		// Prime the FIFO; the THRE interrupt refills it and signals the completion
+		uart_tx_fill();
+		Chip_UART_IntEnable(LPC_UART, UART_IER_THREINT);
+		NVIC_EnableIRQ(LPC_UART_IRQn);
+		return ARM_DRIVER_OK;
+	}
+
 	const char *ptr = data; int len = num;
 	int32_t sent = Chip_UART_SendBlocking(LPC_UART, data, num);
 
@@ -170,19 +284,27 @@ int32_t ARM_USART_Send(const void *data, uint32_t num) {
 		_ttywrch('\r');
 	}
 
-	if (m_SignalEvent) {
-		m_SignalEvent(ARM_USART_EVENT_SEND_COMPLETE);
-	}
 	return sent;
 }
 
 int32_t ARM_USART_Receive(void *data, uint32_t num) {
-	int32_t ret = Chip_UART_Read(LPC_UART, data, num);
-
 	if (m_SignalEvent) {
-		m_SignalEvent(ARM_USART_EVENT_RECEIVE_COMPLETE);
+		if ((data == NULL) || (num == 0)) {
+			return ARM_DRIVER_ERROR_PARAMETER;
+		} else if (m_rx_num != 0) {
+			return ARM_DRIVER_ERROR_BUSY;
+		}
+
+		NVIC_DisableIRQ(LPC_UART_IRQn);
+		m_rx_data = data;
+		m_rx_count = 0;
+		m_rx_num = num;
+		Chip_UART_IntEnable(LPC_UART, UART_IER_RBRINT);
+		NVIC_EnableIRQ(LPC_UART_IRQn);
+		return ARM_DRIVER_OK;
 	}
-	return ret;
+
+	return Chip_UART_Read(LPC_UART, data, num);
 }
 
 int32_t ARM_USART_Transfer(const void *data_out, void *data_in, uint32_t num) {
@@ -190,13 +312,11 @@ int32_t ARM_USART_Transfer(const void *data_out, void *data_in, uint32_t num) {
 }
 
 uint32_t ARM_USART_GetTxCount(void) {
-	DEBUG_NOT_IMPLEMENTED();
-	return 0;
+	return m_tx_count;
 }
 
 uint32_t ARM_USART_GetRxCount(void) {
-	DEBUG_NOT_IMPLEMENTED();
-	return 0;
+	return m_rx_count;
 }
 
 int32_t ARM_USART_Control(uint32_t control, uint32_t arg) {
@@ -153,7 +153,7 @@ int32_t ARM_USART_Send(const void *data, uint32_t num) {
 	}
 
 	// Add a return carriage
-	if (*(p_char - 1) == '\n') {
+	if ((num >= 2) && (*(p_char - 1) == '\n') && (*(p_char - 2) != '\r')) {
 		do {
 			err_code = app_uart_put('\r');
 		} while (err_code != NRF_SUCCESS);
@@ -210,7 +210,7 @@ int32_t ARM_USART_Send(const void *data, uint32_t num) {
 
 		return num;
 	} else {
-		return 0;
+		return ARM_DRIVER_ERROR;
 	}
 }
 
@@ -35,26 +35,39 @@
 //
 // Mailbox support
 //
+// Entries are linked into a free list (`link[]`) for allocation and their indexes
+// are queued into a ring (`fifo[]`) of `count + 1` slots so that a full ring can
+// be distinguished from an empty one. All the operations are constant time.
+// A zero-initialized mailbox is valid: all its entries are free.
+// On ARMv7-M/ARMv8-M Mainline, the free list and the ring indexes are updated with
+// LDREX/STREX instead of masking the interrupts. Any number of producers and consumers
+// is supported: a producer first reserves its ring slot, then publishes the entry into
+// it. polymcu_mailbox_get() returns NULL when the first entry is not published yet
+// (its producer has been preempted between the two steps) or is being got by a preempted
+// context, even if polymcu_mailbox_length() is not zero.
+//
 typedef struct {
 	uint32_t type_size;
 	uint32_t count;
 	uint8_t* buffer;
-	uint8_t* status;
-	uint32_t** fifo;
-	uint32_t fifo_head; // FIFO Head Index
+	uint32_t* link;              // Free list link (or entry state) of each entry
+	uint32_t* fifo;              // Ring of published entries ('index + 1', 0 when empty)
+	volatile uint32_t free_head; // Index of the first free entry
+	volatile uint32_t fifo_head; // FIFO Head Index
+	volatile uint32_t fifo_tail; // FIFO Tail Index
 } polymcu_mailbox_t;
 
 #define POLYMCU_MAILBOX_DEFINE(name, type, count) \
   struct { \
-	  uint32_t fifo[count]; \
+	  uint32_t fifo[(count) + 1]; \
+	  uint32_t link[count]; \
 	  type entries[count]; \
-  	  uint8_t status[count]; \
   } polymcu_mailbox_##name; \
   polymcu_mailbox_t polymcu_mailbox_##name##_def = { sizeof(type), count, \
-		  (uint8_t*)&polymcu_mailbox_##name + (sizeof(uint32_t) * count), \
-		  (uint8_t*)&polymcu_mailbox_##name + ((sizeof(uint32_t) + sizeof(type)) * count), \
-		  (uint32_t**)((uint8_t*)&polymcu_mailbox_##name), \
-		  0};
+		  (uint8_t*)polymcu_mailbox_##name.entries, \
+		  polymcu_mailbox_##name.link, \
+		  polymcu_mailbox_##name.fifo, \
+		  0, 0, 0 };
 
 #define POLYMCU_MAILBOX_DECLARE_EXTERN(name)	extern polymcu_mailbox_t polymcu_mailbox_##name##_def
 #define POLYMCU_MAILBOX_NAME(name)				&polymcu_mailbox_##name##_def
@@ -67,9 +80,133 @@ void* polymcu_mailbox_get(polymcu_mailbox_t *mail);
 int polymcu_mailbox_insert_first(polymcu_mailbox_t *mail, void* buffer);
 uint32_t polymcu_mailbox_length(polymcu_mailbox_t *mail);
 
+//
+// Buffer pool support
+//
+// Fixed-size, reference-counted buffers that can be handed from a driver to the
+// application (e.g. through a mailbox of `polymcu_pbuf_t*`) without copying the data.
+// A packet larger than a buffer is a chain of buffers linked by `next`: `tot_len` is the
+// length of the data from this buffer to the end of the chain. The headroom reserved at
+// allocation lets the upper layers prepend their headers with `polymcu_pbuf_header()`.
+// Allocating, referencing and freeing can be done from any context.
+//
+typedef struct polymcu_pbuf polymcu_pbuf_t;
+typedef struct polymcu_pbuf_pool polymcu_pbuf_pool_t;
+
+struct polymcu_pbuf {
+	polymcu_pbuf_t*      next;     // Next buffer of the chain
+	polymcu_pbuf_pool_t* pool;
+	uint8_t*             payload;  // Start of the data
+	uint16_t             len;      // Length of the data in this buffer
+	uint16_t             tot_len;  // Length of the data in this buffer and the rest of the chain
+	volatile uint32_t    ref;
+} __attribute__((aligned(8)));
+
+struct polymcu_pbuf_pool {
+	uint32_t block_size;           // Size of a buffer with its header
+	uint32_t size;                 // Size of the data of a buffer
+	uint32_t count;
+	uint8_t* blocks;
+	polymcu_pbuf_t* volatile free_head;
+};
+
+#define POLYMCU_PBUF_POOL_DEFINE(name, size, count) \
+  struct { \
+	  polymcu_pbuf_t header; \
+	  uint8_t data[((size) + 7) & ~7]; \
+  } polymcu_pbuf_pool_##name##_blocks[count]; \
+  polymcu_pbuf_pool_t polymcu_pbuf_pool_##name##_def = { \
+		  sizeof(polymcu_pbuf_pool_##name##_blocks[0]), size, count, \
+		  (uint8_t*)polymcu_pbuf_pool_##name##_blocks, NULL };
+
+#define POLYMCU_PBUF_POOL_DECLARE_EXTERN(name)	extern polymcu_pbuf_pool_t polymcu_pbuf_pool_##name##_def
+#define POLYMCU_PBUF_POOL_NAME(name)			&polymcu_pbuf_pool_##name##_def
+
+void polymcu_pbuf_pool_init(polymcu_pbuf_pool_t *pool);
+
+// Allocate a chain of buffers for `length` bytes. `headroom` bytes are reserved before the
+// data of the first buffer. Return NULL if the pool does not have enough buffers.
+polymcu_pbuf_t* polymcu_pbuf_alloc(polymcu_pbuf_pool_t *pool, uint32_t length, uint32_t headroom);
+void polymcu_pbuf_ref(polymcu_pbuf_t* p);
+// Release a reference. The buffers of the chain that are not referenced anymore go back to the pool.
+void polymcu_pbuf_free(polymcu_pbuf_t* p);
+// Append `tail` to the chain of `head`. The reference of the caller on `tail` is given to the chain.
+void polymcu_pbuf_chain(polymcu_pbuf_t* head, polymcu_pbuf_t* tail);
+// Move the start of the data of the first buffer by `size` bytes: a positive `size` adds a
+// header in the headroom, a negative one removes it. Return 0 on success.
+int polymcu_pbuf_header(polymcu_pbuf_t* p, int size);
+// Return the space available after the start of the data of this buffer
+uint32_t polymcu_pbuf_space(polymcu_pbuf_t* p);
+// Set the length of the chain (e.g. after a receive). The buffers that are not needed anymore
+// are released. Return 0 on success.
+int polymcu_pbuf_set_length(polymcu_pbuf_t* p, uint32_t length);
+// Copy up to `length` bytes from `offset` in the chain. Return the number of bytes copied.
+uint32_t polymcu_pbuf_copy(const polymcu_pbuf_t* p, uint32_t offset, void* data, uint32_t length);
+
+//
+// Critical section support
+//
+
+// LDREX/STREX are available on ARMv7-M and ARMv8-M Mainline. Build with
+// `-DNO_EXCLUSIVE_ACCESS` to always mask the interrupts instead.
+#if (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)) && !defined(NO_EXCLUSIVE_ACCESS)
+  #define POLYMCU_USE_EXCLUSIVE_ACCESS
+#endif
+
+// The DWT cycle counter is available on ARMv7-M and ARMv8-M Mainline
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+  #define POLYMCU_HAS_CYCLE_COUNTER
+#endif
+
+// BASEPRI is available on ARMv7-M and ARMv8-M Mainline. When CRITICAL_SECTION_PRIORITY
+// is set, the critical sections only mask the interrupts with a priority value greater
+// or equal to it. The ISRs of the more urgent interrupts must not call the PolyMCU API.
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+  #define POLYMCU_HAS_BASEPRI
+#endif
+
 void critical_section_enter(void);
 void critical_section_exit(void);
 
+#ifdef SUPPORT_CRITICAL_SECTION_STATS
+// Longest interval spent with the interrupts masked by the outermost critical section
+typedef struct {
+	uint32_t count;          // Number of outermost critical sections
+	uint32_t max_cycles;     // Longest masked interval (in CPU cycles)
+	void*    max_enter_site; // Return address of the critical_section_enter() of the longest interval
+	void*    max_exit_site;  // Return address of its critical_section_exit()
+} polymcu_critical_section_stats_t;
+
+void polymcu_critical_section_get_stats(polymcu_critical_section_stats_t* stats);
+void polymcu_critical_section_reset_stats(void);
+#endif
+
+//
+// Time support
+//
+
+/*
+ * Return the number of CPU cycles since the time support has been started (on the first call).
+ * It is based on the DWT cycle counter when available. Otherwise it combines the PolyMCU
+ * timer tick with the SysTick counter (the resolution is one tick when the PolyMCU timer
+ * does not use the SysTick or is tickless).
+ * These functions can be called from any context and do not mask the interrupts (except on
+ * ARMv6-M every 2^31 counts).
+ * The 32-bit counter is extended to 64-bit as long as the time is read at least every 2^31
+ * counts. The PolyMCU timer interrupt does it when the timer is running. Otherwise call
+ * `polymcu_time_update()` periodically.
+ */
+uint64_t polymcu_time_cycles(void);
+uint64_t polymcu_time_us(void);
+void polymcu_time_update(void);
+
+/*
+ * Wait for `delay` microseconds. When the PolyMCU timer is enabled (it must have been
+ * initialized with `polymcu_timer_init()`) the core sleeps until the last tick of the delay.
+ * It only busy-waits for the remainder. Long delays must not be called from interrupt context.
+ */
+void polymcu_delay_us(unsigned int delay);
+
 #ifdef SUPPORT_TIMER
 
 #define TIMER_PERIOD_MILLISECOND    1000
@@ -99,6 +236,24 @@ int polymcu_timer_start_task(polymcu_timer_task_t task);
 int polymcu_timer_stop_task(polymcu_timer_task_t task);
 int polymcu_timer_task_is_scheduled(polymcu_timer_task_t task);
 
+/*
+ * Allow the expiration of the task to be delayed by up to `slack` ticks. The expirations that
+ * fall within each other's slack are batched into a single wakeup (a single interrupt in
+ * tickless mode). The slack of a periodic task is limited to its period minus one tick. It
+ * does not accumulate: the next period is still relative to the nominal deadline.
+ */
+int polymcu_timer_set_task_slack(polymcu_timer_task_t task, unsigned int slack);
+
+typedef struct {
+	uint32_t ticks;        // Ticks elapsed since the statistics have been reset
+	uint32_t wakeups;      // Timer interrupts
+	uint32_t batches;      // Timer interrupts that expired tasks
+	uint32_t expirations;  // Expired tasks
+} polymcu_timer_stats_t;
+
+void polymcu_timer_get_stats(polymcu_timer_stats_t* stats);
+void polymcu_timer_reset_stats(void);
+
 /*
  * Wait number of `period`. `period` is defined when calling `polymcu_timer_init()`
  */
@@ -117,6 +272,28 @@ void polymcu_timer_hw_start(void);
 // Board specific function to stop HW timer
 void polymcu_timer_hw_stop(void);
 
+#ifdef SUPPORT_TIMER_TICKLESS
+/*
+ * Tickless support: the HW timer only interrupts at the next deadline instead of every tick.
+ * `polymcu_timer_hw_start()` restarts the count of elapsed ticks from zero.
+ */
+
+// Board specific function returning the number of ticks elapsed since the HW timer has been
+// programmed (or started). It must still count the ticks after the programmed deadline.
+unsigned int polymcu_timer_hw_get_elapsed(void);
+
+// Board specific function to program the HW timer to interrupt `ticks` ticks after the
+// `elapsed` first elapsed ticks. The elapsed ticks are counted again from this point.
+// Return the number of ticks actually programmed as the HW timer might not be able to
+// count that far.
+unsigned int polymcu_timer_hw_set_next(unsigned int elapsed, unsigned int ticks);
+
+// Optional board specific functions called by the RTOS tickless idle around the sleep of the
+// core (eg: to gate clocks). `ticks` is the expected idle time. Interrupts are disabled.
+void polymcu_timer_hw_pre_sleep(unsigned int ticks);
+void polymcu_timer_hw_post_sleep(unsigned int ticks);
+#endif
+
 #endif
 
 #ifdef SUPPORT_WATCHDOG
@@ -127,8 +304,325 @@ void polymcu_watchdog_restore_default_timeout(void);
 void polymcu_watchdog_trigger(void);
 #endif
 
+//
+// Event dispatcher support
+//
+// Run-to-completion dispatcher for bare-metal applications. An event is bound to a
+// handler and a static priority (0 is the most urgent, EVENT_PRIORITY_MAX - 1 the least).
+// Posting an event is constant time and can be done from any context: it accumulates
+// the signals and queues the event (once) at the tail of its priority queue. The handlers
+// run at thread level from `polymcu_event_run()`, one at a time, most urgent first. The
+// core sleeps when no event is ready.
+//
+#ifdef SUPPORT_EVENT
+
+typedef struct polymcu_event polymcu_event_t;
+typedef void (*polymcu_event_handler_t)(polymcu_event_t* event, uint32_t signals);
+
+struct polymcu_event {
+	polymcu_event_t*        next;     // Next event in its priority queue
+	polymcu_event_handler_t handler;
+	void*                   arg;
+	uint8_t                 priority;
+	uint8_t                 queued;
+	volatile uint32_t       signals;  // Signals posted since the last dispatch
+};
+
+void polymcu_event_init(polymcu_event_t* event, polymcu_event_handler_t handler, unsigned int priority, void* arg);
+void polymcu_event_post(polymcu_event_t* event, uint32_t signals);
+
+// Run the most urgent ready event. Return 0 if no event was ready.
+int polymcu_event_dispatch(void);
+// Dispatch the events forever. The core sleeps until the next interrupt when none is ready.
+void polymcu_event_run(void) __attribute__((noreturn));
+
+#ifdef SUPPORT_TIMER
+// Signal posted by the timer tasks created with `polymcu_event_create_timer()`
+#define POLYMCU_EVENT_SIGNAL_TIMER    (1UL << 31)
+
+/*
+ * Create a timer task that posts POLYMCU_EVENT_SIGNAL_TIMER to `event` when it expires.
+ * The expiration is handled by the event handler at thread level instead of the timer
+ * interrupt. The task is started with `polymcu_timer_start_task()`.
+ */
+polymcu_timer_task_t polymcu_event_create_timer(polymcu_event_t* event, unsigned int delay, int periodic);
+#endif
+
+#endif
+
+//
+// Debug UART support
+//
+// With SUPPORT_DEBUG_UART_BUFFERED, the console writes are queued into a ring and
+// never wait for the UART. Boards must pass POLYMCU_UART_DEBUG_EVENT to
+// `Driver_UART_DEBUG.Initialize()`.
+//
+#ifdef SUPPORT_DEBUG_UART_BUFFERED
+#define POLYMCU_UART_DEBUG_EVENT    polymcu_uart_debug_event
+
+void polymcu_uart_debug_event(uint32_t event);
+
+/**
+ * Wait for the queued characters to be sent.
+ * From an interrupt, it only succeeds with a blocking UART driver.
+ */
+void polymcu_uart_flush(void);
+
+/**
+ * Return the number of characters dropped because the TX or RX ring was full.
+ */
+unsigned int polymcu_uart_get_dropped(void);
+#else
+#define POLYMCU_UART_DEBUG_EVENT    NULL
+#endif
+
+/**
+ * Write binary data to the debug output without any character translation.
+ * Return the number of bytes accepted.
+ */
+int polymcu_uart_write_raw(const void* data, int len);
+
 void print_buffer_hex(uint8_t* ptr, size_t size);
 
+//
+// ITM support
+//
+// With `SUPPORT_DEBUG_UART=itm`, the debug output is sent on the ITM stimulus ports
+// with 32-bit writes. Each stream has its own port so they do not starve each other.
+// The writes never wait for the ITM FIFO: the data are dropped when it is full.
+//
+#ifdef SUPPORT_DEBUG_UART_ITM
+#define POLYMCU_ITM_PORT_STDOUT     0   // printf(), puts()
+#define POLYMCU_ITM_PORT_LOG        1   // Binary log records
+#define POLYMCU_ITM_PORT_PROFILE    2   // Profiling samples
+#define POLYMCU_ITM_PORT_RTOS       3   // RTOS events
+#define POLYMCU_ITM_PORT_DEBUG      8   // First port of the DEBUG_PRINTF() messages
+
+// Port of the DEBUG_PRINTF() messages: one port per subsystem (8: board, 9: RTOS,
+// 10: CMSIS, 11: USB, 12: application, 13: libraries). The other errors and warnings
+// go to the standard output. The other messages go to port 14.
+#define POLYMCU_ITM_DEBUG_PORT(level) \
+  (((level) & DEBUG_BOARD) ? POLYMCU_ITM_PORT_DEBUG + 0 : \
+   ((level) & DEBUG_RTOS)  ? POLYMCU_ITM_PORT_DEBUG + 1 : \
+   ((level) & DEBUG_CMSIS) ? POLYMCU_ITM_PORT_DEBUG + 2 : \
+   ((level) & DEBUG_USB)   ? POLYMCU_ITM_PORT_DEBUG + 3 : \
+   ((level) & DEBUG_APP)   ? POLYMCU_ITM_PORT_DEBUG + 4 : \
+   ((level) & DEBUG_LIB)   ? POLYMCU_ITM_PORT_DEBUG + 5 : \
+   ((level) & (DEBUG_ERROR | DEBUG_WARN)) ? POLYMCU_ITM_PORT_STDOUT : POLYMCU_ITM_PORT_DEBUG + 6)
+
+/**
+ * Write 'len' bytes on the stimulus 'port'. Return the number of bytes written
+ * (the data are discarded when the port is disabled).
+ */
+int polymcu_itm_write(unsigned int port, const void* data, int len);
+
+/**
+ * Format and write a message (up to ITM_PRINTF_BUFFER_SIZE characters) on 'port'.
+ */
+int polymcu_itm_printf(unsigned int port, const char* format, ...);
+
+/**
+ * Return the number of bytes dropped because the ITM FIFO was full.
+ */
+unsigned int polymcu_itm_get_dropped(void);
+#endif
+
+//
+// Binary log support
+//
+#ifdef SUPPORT_DEBUG_LOG_BINARY
+/**
+ * Queue a log record made of the format string identifier and 'nargs' 32-bit
+ * arguments. Never blocks: the record is dropped if the log ring is full.
+ */
+void polymcu_log_write(uint32_t id, unsigned int nargs, ...);
+
+/**
+ * Send the queued log records to the debug output.
+ * It is called on every record logged from a thread.
+ */
+void polymcu_log_flush(void);
+#endif
+
+//
+// Heap support
+//
+// With `SUPPORT_HEAP=tlsf`, the memory is allocated by a TLSF allocator: malloc()
+// and free() run in bounded time (in critical section). The default heap backs
+// newlib `malloc()` and FreeRTOS `pvPortMalloc()`. Additional heaps (arenas) can be
+// created on any memory region.
+//
+#ifdef SUPPORT_HEAP_TLSF
+typedef struct polymcu_heap polymcu_heap_t;
+
+typedef struct {
+	size_t total_size;           // Size of the heap (including the block headers)
+	size_t used_size;            // Size of the allocated blocks (including their header)
+	size_t peak_used_size;
+	size_t free_size;
+	size_t largest_free_block;   // Largest allocation that can succeed
+	unsigned int fragmentation;  // Percentage of the free memory not usable by the largest allocation
+	uint32_t alloc_count;        // Number of allocated blocks
+	uint32_t failure_count;      // Number of allocations that have failed
+} polymcu_heap_stats_t;
+
+/**
+ * Create a heap on the given memory region. The heap descriptor is stored at the
+ * beginning of the region. Return NULL if the region is too small.
+ */
+polymcu_heap_t* polymcu_heap_create(void* memory, size_t size);
+
+/**
+ * Return the default heap. It covers the memory between the end of the data and the
+ * bottom of the main stack (`__HeapBase` and `__StackLimit`).
+ */
+polymcu_heap_t* polymcu_heap_default(void);
+
+// When 'heap' is NULL, the default heap is used
+void* polymcu_heap_malloc(polymcu_heap_t* heap, size_t size);
+void* polymcu_heap_memalign(polymcu_heap_t* heap, size_t alignment, size_t size);
+void* polymcu_heap_realloc(polymcu_heap_t* heap, void* ptr, size_t size);
+void polymcu_heap_free(polymcu_heap_t* heap, void* ptr);
+void polymcu_heap_get_stats(polymcu_heap_t* heap, polymcu_heap_stats_t* stats);
+#endif
+
+//
+// Profiling support
+//
+// A zone measures the CPU cycles spent between `PROFILE_ZONE_BEGIN(name)` and
+// `PROFILE_ZONE_END(name)` (in the same block). Each zone records its count, min, max,
+// total and a log2 histogram: bucket `n` counts the durations in [2^n, 2^(n+1)) cycles.
+// The zones are registered on their first use. Without SUPPORT_PROFILE, the macros
+// compile out.
+//
+#ifdef SUPPORT_PROFILE
+
+#define POLYMCU_PROFILE_HISTOGRAM_SIZE  32
+
+typedef struct polymcu_profile_zone {
+	const char* name;
+	struct polymcu_profile_zone* next;
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint32_t histogram[POLYMCU_PROFILE_HISTOGRAM_SIZE];
+	uint32_t registered;
+} polymcu_profile_zone_t;
+
+// 32-bit cycle counter used to time the zones
+#ifdef POLYMCU_HAS_CYCLE_COUNTER
+  #define POLYMCU_PROFILE_CYCLES()      DWT->CYCCNT
+#else
+  #define POLYMCU_PROFILE_CYCLES()      ((uint32_t)polymcu_time_cycles())
+#endif
+
+#define PROFILE_ZONE_BEGIN(name) \
+  static polymcu_profile_zone_t polymcu_profile_zone_##name = { #name, NULL, 0, UINT32_MAX }; \
+  uint32_t polymcu_profile_start_##name = POLYMCU_PROFILE_CYCLES()
+#define PROFILE_ZONE_END(name) \
+  polymcu_profile_record(&polymcu_profile_zone_##name, POLYMCU_PROFILE_CYCLES() - polymcu_profile_start_##name)
+
+/**
+ * Start the cycle counter. It must be called before the first zone is entered.
+ */
+void polymcu_profile_init(void);
+
+/**
+ * Account `cycles` to `zone`. It can be called from any context.
+ */
+void polymcu_profile_record(polymcu_profile_zone_t* zone, uint32_t cycles);
+
+/**
+ * Print the statistics and the histogram of all the zones on the standard output
+ * (debug UART or ITM). It must not be called from interrupt context.
+ */
+void polymcu_profile_dump(void);
+
+/**
+ * Clear the statistics of all the zones.
+ */
+void polymcu_profile_reset(void);
+#else
+  #define PROFILE_ZONE_BEGIN(name)      do { } while (0)
+  #define PROFILE_ZONE_END(name)        do { } while (0)
+#endif
+
+//
+// Thread CPU usage support
+//
+// The RTOS accounts the CPU cycles of each thread on every context switch (the time spent
+// in the interrupts is accounted to the interrupted thread). The load of a thread is its
+// share of the CPU over the last complete window of RTOS_CPU_USAGE_WINDOW_MS. The records
+// are owned by the RTOS support (see RTOS/<RTOS>/cpu_usage.c) and identified by the native
+// thread of the kernel. The applications use `osThreadGetCpuUsage()` or the functions below.
+//
+#ifdef SUPPORT_RTOS_CPU_USAGE
+
+#define POLYMCU_CPU_USAGE_IDLE          (1 << 0)  // Idle thread of the kernel
+// `stack_free` when the kernel does not fill the stacks with a known pattern
+#define POLYMCU_CPU_USAGE_NO_STACK      UINT32_MAX
+
+typedef struct polymcu_cpu_usage {
+	struct polymcu_cpu_usage* next;
+	const char* name;
+	void*       thread;         // Native thread of the kernel
+	void*       stack;          // Lowest address of the stack (if known by the RTOS support)
+	uint32_t    flags;
+	uint32_t    load;           // Load over the last window (in 1/100 %)
+	uint64_t    cycles;         // CPU cycles the thread has run for
+	uint64_t    window_cycles;  // `cycles` at the start of the current window
+} polymcu_cpu_usage_t;
+
+typedef struct polymcu_cpu_usage_stats {
+	uint64_t cycles;            // CPU cycles the thread has run for since its creation
+	uint32_t load;              // Load over the last window (in 1/100 %)
+	uint32_t stack_free;        // Stack that has never been used (in bytes)
+} polymcu_cpu_usage_stats_t;
+
+/**
+ * Called by the RTOS support when a thread is created or deleted. They can be called with
+ * the interrupts masked.
+ */
+void polymcu_cpu_usage_add(polymcu_cpu_usage_t* usage, const char* name, void* thread, void* stack, uint32_t flags);
+void polymcu_cpu_usage_remove(polymcu_cpu_usage_t* usage);
+
+/**
+ * Account the cycles since the last call to `running` (NULL if they belong to no thread).
+ * Called by the RTOS support on every context switch with the interrupts masked.
+ */
+void polymcu_cpu_usage_switch(polymcu_cpu_usage_t* running);
+
+/**
+ * Get the CPU usage of `thread` (native thread of the kernel, NULL for the calling thread).
+ * Return 0 on success.
+ */
+int polymcu_cpu_usage_get(void* thread, polymcu_cpu_usage_stats_t* stats);
+
+/**
+ * Return the load of the idle thread over the last window (in 1/100 %).
+ */
+uint32_t polymcu_cpu_usage_get_idle(void);
+
+/**
+ * Print the CPU usage of all the threads on the standard output (debug UART or ITM).
+ * It must not be called from interrupt context.
+ */
+void polymcu_cpu_usage_dump(void);
+
+/**
+ * Start a thread at the highest priority of the RTOS that dumps the CPU usage every
+ * `period_ms` milliseconds (implemented by the RTOS support). Return 0 on success.
+ */
+int polymcu_cpu_usage_start_report(unsigned int period_ms);
+
+// Implemented by the RTOS support: record of `thread` (NULL for the calling thread), record
+// of the running thread (called with the interrupts masked) and unused stack of a thread
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_find(void* thread);
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_running(void);
+uint32_t polymcu_rtos_cpu_usage_stack_free(const polymcu_cpu_usage_t* usage);
+#endif
+
 //
 // PolyMCU Debug Support
 //
@@ -149,7 +643,60 @@ void print_buffer_hex(uint8_t* ptr, size_t size);
 #define DEBUG_APP_LEVEL   16
 #define DEBUG_LIB_LEVEL   24
 
-#if DEBUG_MASK > 0
+#if (DEBUG_MASK > 0) && defined(SUPPORT_DEBUG_LOG_BINARY)
+  // Binary logging: the format strings are kept in the '.polymcu_log' section that
+  // is not loaded on the target. Only the string address and the arguments (as
+  // 32-bit words) are logged. See 'Lib/PolyMCU/tools/decode_log.py'.
+  #if defined(__clang__)
+    // Clang does not let us set the section flags: the strings are loaded
+    #define POLYMCU_LOG_SECTION        __attribute__((section(".polymcu_log"), used))
+  #elif defined(__arm__)
+    #define POLYMCU_LOG_SECTION        __attribute__((section(".polymcu_log,\"\",%progbits @"), used))
+  #else
+    #define POLYMCU_LOG_SECTION        __attribute__((section(".polymcu_log,\"\",@progbits #"), used))
+  #endif
+
+  // The arguments are logged as 32-bit words: floating point values and arguments wider than
+  // 32 bits would be silently truncated. They are rejected at compile time.
+  #define POLYMCU_LOG_ARG_VALID(a)     _Generic((a), float: 0, double: 0, long double: 0, \
+                                                default: sizeof((void)0, (a)) <= sizeof(uint32_t))
+  #define POLYMCU_LOG_ARG(a)           ((void)sizeof(struct { _Static_assert(POLYMCU_LOG_ARG_VALID(a), \
+                                            "DEBUG_PRINTF() argument is not a 32-bit integer or pointer: " #a); int dummy; }), \
+                                        (uint32_t)(uintptr_t)(a))
+  #define POLYMCU_LOG_ARGS_0()
+  #define POLYMCU_LOG_ARGS_1(a)        , POLYMCU_LOG_ARG(a)
+  #define POLYMCU_LOG_ARGS_2(a, ...)   , POLYMCU_LOG_ARG(a) POLYMCU_LOG_ARGS_1(__VA_ARGS__)
+  #define POLYMCU_LOG_ARGS_3(a, ...)   , POLYMCU_LOG_ARG(a) POLYMCU_LOG_ARGS_2(__VA_ARGS__)
+  #define POLYMCU_LOG_ARGS_4(a, ...)   , POLYMCU_LOG_ARG(a) POLYMCU_LOG_ARGS_3(__VA_ARGS__)
+  #define POLYMCU_LOG_ARGS_5(a, ...)   , POLYMCU_LOG_ARG(a) POLYMCU_LOG_ARGS_4(__VA_ARGS__)
+  #define POLYMCU_LOG_ARGS_6(a, ...)   , POLYMCU_LOG_ARG(a) POLYMCU_LOG_ARGS_5(__VA_ARGS__)
+  #define POLYMCU_LOG_ARGS_7(a, ...)   , POLYMCU_LOG_ARG(a) POLYMCU_LOG_ARGS_6(__VA_ARGS__)
+  #define POLYMCU_LOG_ARGS_8(a, ...)   , POLYMCU_LOG_ARG(a) POLYMCU_LOG_ARGS_7(__VA_ARGS__)
+  #define POLYMCU_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+  #define POLYMCU_LOG_NARGS(args...)   POLYMCU_LOG_NARGS_(0, ##args, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+  #define POLYMCU_LOG_CONCAT_(a, b)    a##b
+  #define POLYMCU_LOG_CONCAT(a, b)     POLYMCU_LOG_CONCAT_(a, b)
+
+  #define DEBUG_PRINTF(level, fmt, args...) do { \
+      if ((level) & DEBUG_MASK) { \
+        static const char polymcu_log_fmt[] POLYMCU_LOG_SECTION = fmt; \
+        polymcu_log_write(POLYMCU_LOG_ARG(polymcu_log_fmt), POLYMCU_LOG_NARGS(args) \
+                          POLYMCU_LOG_CONCAT(POLYMCU_LOG_ARGS_, POLYMCU_LOG_NARGS(args))(args)); \
+      } \
+    } while (0)
+  #define DEBUG_PUTS(level, txt)		DEBUG_PRINTF(level, "%s\n", txt)
+
+  #define DEBUG_NOT_IMPLEMENTED() assert(0)
+  #define DEBUG_NOT_SUPPORTED() assert(0)
+  #define DEBUG_NOT_VALID() assert(0)
+#elif (DEBUG_MASK > 0) && defined(SUPPORT_DEBUG_UART_ITM)
+  #define DEBUG_PRINTF(level, args...)	if ((level) & DEBUG_MASK) polymcu_itm_printf(POLYMCU_ITM_DEBUG_PORT(level), args)
+  #define DEBUG_PUTS(level, txt)		if ((level) & DEBUG_MASK) polymcu_itm_printf(POLYMCU_ITM_DEBUG_PORT(level), "%s\n", txt)
+
+  #define DEBUG_NOT_IMPLEMENTED() assert(0)
+  #define DEBUG_NOT_SUPPORTED() assert(0)
+  #define DEBUG_NOT_VALID() assert(0)
+#elif DEBUG_MASK > 0
   #define DEBUG_PRINTF(level, args...)	if (level & DEBUG_MASK) printf(args)
   #define DEBUG_PUTS(level, txt)		if (level & DEBUG_MASK) puts(txt)
 
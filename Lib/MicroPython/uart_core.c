@@ -31,6 +31,23 @@
 
 extern const ARM_DRIVER_USART Driver_UART_DEBUG;
 
+#ifdef SUPPORT_DEBUG_UART_BUFFERED
+int _write(int fd, char *ptr, int len);
+int _read(int fd, char *ptr, int len);
+
+// Receive single character
+__attribute__((weak)) int mp_hal_stdin_rx_chr(void) {
+    char c = 0;
+    while (_read(STDIN_FILENO, &c, 1) <= 0);
+    return (unsigned char)c;
+}
+
+// Send string of given length
+__attribute__((weak)) void mp_hal_stdout_tx_strn(const char *str, mp_uint_t len) {
+	// Go through the console ring to not wait for the UART
+	_write(STDOUT_FILENO, (char *)str, len);
+}
+#else
 // Receive single character
 __attribute__((weak)) int mp_hal_stdin_rx_chr(void) {
     unsigned char c = 0;
@@ -42,6 +59,7 @@ __attribute__((weak)) int mp_hal_stdin_rx_chr(void) {
 __attribute__((weak)) void mp_hal_stdout_tx_strn(const char *str, mp_uint_t len) {
 	Driver_UART_DEBUG.Send(str, len);
 }
+#endif
 
 // Send "cooked" string of given length, where every occurance of
 // LF character is replaced with CR LF.
@@ -30,7 +30,9 @@ if(SUPPORT_RTOS)
   find_package(RTOS)
 endif()
 
-if (CMAKE_C_COMPILER_ID STREQUAL "GNU")
+if (POLYMCU_HOST_BUILD)
+  # The host C library provides the system calls
+elseif (CMAKE_C_COMPILER_ID STREQUAL "GNU")
   set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -specs=nano.specs -specs=nosys.specs")
 elseif (CMAKE_C_COMPILER_ID STREQUAL "Clang")
   set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -specs=nano.specs -specs=nosys.specs")
@@ -45,6 +47,48 @@ endif()
 
 if(SUPPORT_TIMER)
   add_definitions(-DSUPPORT_TIMER)
+
+  if(SUPPORT_TIMER_TICKLESS)
+    add_definitions(-DSUPPORT_TIMER_TICKLESS)
+  endif()
+endif()
+
+if(SUPPORT_DEBUG_UART STREQUAL "itm")
+  add_definitions(-DSUPPORT_DEBUG_UART_ITM)
+endif()
+
+# The buffered console requires a CMSIS USART driver
+if(SUPPORT_DEBUG_UART_BUFFERED AND NOT (SUPPORT_DEBUG_UART STREQUAL "none" OR SUPPORT_DEBUG_UART STREQUAL "itm"))
+  add_definitions(-DSUPPORT_DEBUG_UART_BUFFERED)
+endif()
+
+if(SUPPORT_DEBUG_LOG_BINARY)
+  if(POLYMCU_HOST_BUILD)
+    # The addresses of the format strings identify the log records as 32-bit words
+    message(FATAL_ERROR "SUPPORT_DEBUG_LOG_BINARY is not supported on the host.")
+  endif()
+  add_definitions(-DSUPPORT_DEBUG_LOG_BINARY)
+endif()
+
+if(SUPPORT_HEAP STREQUAL "tlsf")
+  add_definitions(-DSUPPORT_HEAP_TLSF)
+endif()
+
+if(SUPPORT_PROFILE)
+  add_definitions(-DSUPPORT_PROFILE)
+endif()
+
+if(SUPPORT_EVENT)
+  add_definitions(-DSUPPORT_EVENT)
+endif()
+
+# The CPU usage accounting is done by the context switch hooks of the RTOS
+if(SUPPORT_RTOS_CPU_USAGE AND SUPPORT_RTOS)
+  add_definitions(-DSUPPORT_RTOS_CPU_USAGE)
+endif()
+
+if(SUPPORT_CRITICAL_SECTION_STATS)
+  add_definitions(-DSUPPORT_CRITICAL_SECTION_STATS)
 endif()
 
 if(SUPPORT_WATCHDOG)
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "PolyMCU.h"
+
+#ifndef RTOS_CPU_USAGE_WINDOW_MS
+  #define RTOS_CPU_USAGE_WINDOW_MS  1000
+#endif
+
+// Threads whose CPU usage is accounted
+static polymcu_cpu_usage_t* volatile g_cpu_usage_list;
+// Cycle counter at the last accounting and at the start of the current window
+static uint64_t g_cpu_usage_last;
+static uint64_t g_cpu_usage_window_start;
+static int g_cpu_usage_started;
+
+// Must be called with the interrupts masked
+static void cpu_usage_start(void) {
+	if (!g_cpu_usage_started) {
+		g_cpu_usage_last = polymcu_time_cycles();
+		g_cpu_usage_window_start = g_cpu_usage_last;
+		g_cpu_usage_started = 1;
+	}
+}
+
+// The load of all the threads is computed at the end of the window. Must be called with
+// the interrupts masked
+static void cpu_usage_close_window(uint64_t now) {
+	uint64_t length = now - g_cpu_usage_window_start;
+	polymcu_cpu_usage_t* usage;
+
+	for (usage = g_cpu_usage_list; usage != NULL; usage = usage->next) {
+		usage->load = (uint32_t)(((usage->cycles - usage->window_cycles) * 10000) / length);
+		usage->window_cycles = usage->cycles;
+	}
+	g_cpu_usage_window_start = now;
+}
+
+void polymcu_cpu_usage_switch(polymcu_cpu_usage_t* running) {
+	uint64_t now = polymcu_time_cycles();
+	uint64_t window = ((uint64_t)SystemCoreClock * RTOS_CPU_USAGE_WINDOW_MS) / 1000;
+
+	cpu_usage_start();
+
+	if (running != NULL) {
+		running->cycles += now - g_cpu_usage_last;
+	}
+	g_cpu_usage_last = now;
+
+	if (now - g_cpu_usage_window_start >= window) {
+		cpu_usage_close_window(now);
+	}
+}
+
+void polymcu_cpu_usage_add(polymcu_cpu_usage_t* usage, const char* name, void* thread, void* stack, uint32_t flags) {
+	critical_section_enter();
+	cpu_usage_start();
+	usage->name          = name;
+	usage->thread        = thread;
+	usage->stack         = stack;
+	usage->flags         = flags;
+	usage->load          = 0;
+	usage->cycles        = 0;
+	usage->window_cycles = 0;
+	usage->next          = g_cpu_usage_list;
+	g_cpu_usage_list     = usage;
+	critical_section_exit();
+}
+
+void polymcu_cpu_usage_remove(polymcu_cpu_usage_t* usage) {
+	polymcu_cpu_usage_t* volatile* prev;
+
+	critical_section_enter();
+	for (prev = &g_cpu_usage_list; *prev != NULL; prev = &(*prev)->next) {
+		if (*prev == usage) {
+			// 'usage->next' is kept for a dump that would be reading this record
+			*prev = usage->next;
+			break;
+		}
+	}
+	critical_section_exit();
+}
+
+// Account the cycles of the running thread up to now. Must be called with the interrupts masked
+static void cpu_usage_update(void) {
+	polymcu_cpu_usage_switch(polymcu_rtos_cpu_usage_running());
+}
+
+int polymcu_cpu_usage_get(void* thread, polymcu_cpu_usage_stats_t* stats) {
+	polymcu_cpu_usage_t* usage = polymcu_rtos_cpu_usage_find(thread);
+
+	if ((usage == NULL) || (stats == NULL)) {
+		return 1;
+	}
+
+	critical_section_enter();
+	cpu_usage_update();
+	stats->cycles = usage->cycles;
+	stats->load   = usage->load;
+	critical_section_exit();
+
+	stats->stack_free = polymcu_rtos_cpu_usage_stack_free(usage);
+	return 0;
+}
+
+uint32_t polymcu_cpu_usage_get_idle(void) {
+	polymcu_cpu_usage_t* usage;
+	uint32_t load = 0;
+
+	critical_section_enter();
+	cpu_usage_update();
+	for (usage = g_cpu_usage_list; usage != NULL; usage = usage->next) {
+		if (usage->flags & POLYMCU_CPU_USAGE_IDLE) {
+			load = usage->load;
+			break;
+		}
+	}
+	critical_section_exit();
+	return load;
+}
+
+// newlib-nano printf does not support 64-bit integers
+static const char* cpu_usage_u64_to_str(uint64_t value, char* str, size_t size) {
+	char* ptr = str + size - 1;
+
+	*ptr = '\0';
+	do {
+		*--ptr = '0' + (value % 10);
+		value /= 10;
+	} while ((value != 0) && (ptr != str));
+
+	return ptr;
+}
+
+void polymcu_cpu_usage_dump(void) {
+	polymcu_cpu_usage_t* usage;
+	polymcu_cpu_usage_t copy;
+	char cycles_str[21];
+	char name_str[11];
+	uint32_t stack_free;
+	uint32_t idle = polymcu_cpu_usage_get_idle();
+
+	printf("CPU usage (last %u ms, idle %u.%02u%%)\n", (unsigned int)RTOS_CPU_USAGE_WINDOW_MS,
+			(unsigned int)(idle / 100), (unsigned int)(idle % 100));
+	printf("%-10s %8s %20s %10s\n", "thread", "load", "cycles", "stack free");
+
+	critical_section_enter();
+	usage = g_cpu_usage_list;
+	critical_section_exit();
+
+	while (usage != NULL) {
+		// Take a consistent snapshot of the record
+		critical_section_enter();
+		memcpy(&copy, usage, sizeof(copy));
+		critical_section_exit();
+
+		if (copy.name == NULL) {
+			snprintf(name_str, sizeof(name_str), "0x%08x", (unsigned int)(uintptr_t)copy.thread);
+			copy.name = name_str;
+		}
+
+		stack_free = polymcu_rtos_cpu_usage_stack_free(usage);
+		if (stack_free == POLYMCU_CPU_USAGE_NO_STACK) {
+			printf("%-10.10s %5u.%02u%% %20s %10s\n", copy.name,
+					(unsigned int)(copy.load / 100), (unsigned int)(copy.load % 100),
+					cpu_usage_u64_to_str(copy.cycles, cycles_str, sizeof(cycles_str)), "-");
+		} else {
+			printf("%-10.10s %5u.%02u%% %20s %10u\n", copy.name,
+					(unsigned int)(copy.load / 100), (unsigned int)(copy.load % 100),
+					cpu_usage_u64_to_str(copy.cycles, cycles_str, sizeof(cycles_str)), (unsigned int)stack_free);
+		}
+
+		usage = copy.next;
+	}
+}
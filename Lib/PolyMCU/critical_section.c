@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PolyMCU.h"
+
+/*
+ * With CRITICAL_SECTION_PRIORITY, the critical sections raise BASEPRI: only the
+ * interrupts with a priority value greater or equal to CRITICAL_SECTION_PRIORITY are
+ * masked. The more urgent interrupts stay live (they must not call the PolyMCU API).
+ * Otherwise (and on ARMv6-M that does not have BASEPRI) all the interrupts are masked
+ * with PRIMASK.
+ */
+#if defined(CRITICAL_SECTION_PRIORITY) && (CRITICAL_SECTION_PRIORITY > 0)
+  #ifndef POLYMCU_HAS_BASEPRI
+    #warning BASEPRI is not available on this core. The critical sections use PRIMASK.
+    #undef CRITICAL_SECTION_PRIORITY
+  #elif CRITICAL_SECTION_PRIORITY >= (1 << __NVIC_PRIO_BITS)
+    #error CRITICAL_SECTION_PRIORITY is greater than the lowest priority of the NVIC
+  #else
+    #define CRITICAL_SECTION_BASEPRI    (CRITICAL_SECTION_PRIORITY << (8 - __NVIC_PRIO_BITS))
+  #endif
+#endif
+
+static uint32_t m_in_critical_section = 0;
+// Interrupt mask (BASEPRI or PRIMASK) to restore when leaving the outermost critical section
+static uint32_t m_critical_section_mask;
+
+#ifdef SUPPORT_CRITICAL_SECTION_STATS
+static polymcu_critical_section_stats_t m_critical_section_stats;
+static uint32_t m_critical_section_start;
+static void* m_critical_section_enter_site;
+
+#ifdef POLYMCU_HAS_CYCLE_COUNTER
+  #define CRITICAL_SECTION_CYCLES()    DWT->CYCCNT
+#else
+  // It might use critical sections itself: it must be called while the section is nested
+  #define CRITICAL_SECTION_CYCLES()    ((uint32_t)polymcu_time_cycles())
+#endif
+
+static void critical_section_stats_enter(void* site) {
+	m_critical_section_enter_site = site;
+	m_critical_section_start = CRITICAL_SECTION_CYCLES();
+}
+
+static void critical_section_stats_exit(void* site) {
+	uint32_t cycles = CRITICAL_SECTION_CYCLES() - m_critical_section_start;
+
+	m_critical_section_stats.count++;
+	if (cycles > m_critical_section_stats.max_cycles) {
+		m_critical_section_stats.max_cycles     = cycles;
+		m_critical_section_stats.max_enter_site = m_critical_section_enter_site;
+		m_critical_section_stats.max_exit_site  = site;
+	}
+}
+
+void polymcu_critical_section_get_stats(polymcu_critical_section_stats_t* stats) {
+	critical_section_enter();
+	*stats = m_critical_section_stats;
+	critical_section_exit();
+}
+
+void polymcu_critical_section_reset_stats(void) {
+	critical_section_enter();
+	m_critical_section_stats.count          = 0;
+	m_critical_section_stats.max_cycles     = 0;
+	m_critical_section_stats.max_enter_site = NULL;
+	m_critical_section_stats.max_exit_site  = NULL;
+	critical_section_exit();
+}
+#endif
+
+__attribute__((weak)) void critical_section_enter(void) {
+#ifdef CRITICAL_SECTION_BASEPRI
+	uint32_t mask = __get_BASEPRI();
+	// Only raise the masking priority (BASEPRI might already be more restrictive)
+	__set_BASEPRI_MAX(CRITICAL_SECTION_BASEPRI);
+	__ISB();
+#else
+	uint32_t mask = __get_PRIMASK();
+	__disable_irq();
+#endif
+
+	if (m_in_critical_section++ == 0) {
+		m_critical_section_mask = mask;
+#ifdef SUPPORT_CRITICAL_SECTION_STATS
+		m_in_critical_section++;
+		critical_section_stats_enter(__builtin_return_address(0));
+		m_in_critical_section--;
+#endif
+	}
+}
+
+__attribute__((weak)) void critical_section_exit(void) {
+#ifdef SUPPORT_CRITICAL_SECTION_STATS
+	if (m_in_critical_section == 1) {
+		critical_section_stats_exit(__builtin_return_address(0));
+	}
+#endif
+
+	m_in_critical_section--;
+	if (m_in_critical_section == 0) {
+#ifdef CRITICAL_SECTION_BASEPRI
+		__set_BASEPRI(m_critical_section_mask);
+#else
+		__set_PRIMASK(m_critical_section_mask);
+#endif
+	}
+}
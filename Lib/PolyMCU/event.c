@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PolyMCU.h"
+
+#if EVENT_PRIORITY_MAX > 32
+  #error EVENT_PRIORITY_MAX cannot be greater than 32
+#endif
+
+struct polymcu_event_queue {
+	polymcu_event_t* head;
+	polymcu_event_t* tail;
+};
+
+static struct polymcu_event_queue g_event_queues[EVENT_PRIORITY_MAX];
+// Bit `n` is set when the queue of priority `n` is not empty
+static volatile uint32_t g_event_ready;
+
+void polymcu_event_init(polymcu_event_t* event, polymcu_event_handler_t handler, unsigned int priority, void* arg) {
+	assert(priority < EVENT_PRIORITY_MAX);
+
+	event->next     = NULL;
+	event->handler  = handler;
+	event->arg      = arg;
+	event->priority = priority;
+	event->queued   = 0;
+	event->signals  = 0;
+}
+
+void polymcu_event_post(polymcu_event_t* event, uint32_t signals) {
+	struct polymcu_event_queue* queue = &g_event_queues[event->priority];
+
+	critical_section_enter();
+	event->signals |= signals;
+	if (!event->queued) {
+		event->queued = 1;
+		event->next = NULL;
+		if (queue->tail != NULL) {
+			queue->tail->next = event;
+		} else {
+			queue->head = event;
+		}
+		queue->tail = event;
+		g_event_ready |= 1UL << event->priority;
+	}
+	critical_section_exit();
+}
+
+int polymcu_event_dispatch(void) {
+	struct polymcu_event_queue* queue;
+	polymcu_event_t* event;
+	uint32_t signals;
+
+	critical_section_enter();
+	if (g_event_ready == 0) {
+		critical_section_exit();
+		return 0;
+	}
+
+	// The lowest priority value is the most urgent
+	queue = &g_event_queues[__builtin_ctz(g_event_ready)];
+	event = queue->head;
+	queue->head = event->next;
+	if (queue->head == NULL) {
+		queue->tail = NULL;
+		g_event_ready &= ~(1UL << event->priority);
+	}
+
+	// The event can be posted again while its handler runs
+	event->queued = 0;
+	signals = event->signals;
+	event->signals = 0;
+	critical_section_exit();
+
+	event->handler(event, signals);
+	return 1;
+}
+
+void polymcu_event_run(void) {
+	while (1) {
+		while (polymcu_event_dispatch());
+
+#ifdef POLYMCU_HOST
+		if (g_event_ready == 0) {
+			__WFI();
+		}
+#else
+		// The pending interrupts wake up the core even when they are masked by PRIMASK. It
+		// prevents from missing an event posted between the check and WFI.
+		__disable_irq();
+		if (g_event_ready == 0) {
+			__WFI();
+		}
+		__enable_irq();
+#endif
+	}
+}
+
+#ifdef SUPPORT_TIMER
+static void polymcu_event_timer_expired(void* arg) {
+	polymcu_event_post((polymcu_event_t*)arg, POLYMCU_EVENT_SIGNAL_TIMER);
+}
+
+polymcu_timer_task_t polymcu_event_create_timer(polymcu_event_t* event, unsigned int delay, int periodic) {
+	if (periodic) {
+		return polymcu_timer_create_periodic_task(polymcu_event_timer_expired, delay, event);
+	} else {
+		return polymcu_timer_create_one_time_task(polymcu_event_timer_expired, delay, event);
+	}
+}
+#endif
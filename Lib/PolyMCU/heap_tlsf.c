@@ -0,0 +1,627 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Two-Level Segregated Fit (TLSF) allocator: malloc() and free() run in bounded time.
+ *
+ * The free blocks are segregated by size into lists. The first level splits the sizes
+ * into powers of two, the second level splits each power of two into HEAP_SL_COUNT
+ * linear ranges. Two levels of bitmaps give the first non-empty list with a size at
+ * least as large as the request in constant time. The adjacent free blocks are merged
+ * on free().
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include "PolyMCU.h"
+
+#ifndef HEAP_TLSF_FL_INDEX_MAX
+  // Largest block: 2^HEAP_TLSF_FL_INDEX_MAX bytes
+  #define HEAP_TLSF_FL_INDEX_MAX   20
+#endif
+
+#define HEAP_ALIGN_LOG2          3
+#define HEAP_ALIGN               (1U << HEAP_ALIGN_LOG2)
+
+#define HEAP_SL_INDEX_LOG2       3
+#define HEAP_SL_COUNT            (1U << HEAP_SL_INDEX_LOG2)
+#define HEAP_FL_INDEX_SHIFT      (HEAP_SL_INDEX_LOG2 + HEAP_ALIGN_LOG2)
+#define HEAP_FL_COUNT            (HEAP_TLSF_FL_INDEX_MAX - HEAP_FL_INDEX_SHIFT + 1)
+#define HEAP_SMALL_BLOCK_SIZE    (1U << HEAP_FL_INDEX_SHIFT)
+
+// The size of the blocks is a multiple of HEAP_ALIGN. The lower bits are flags
+#define HEAP_BLOCK_FREE          (1U << 0)
+#define HEAP_BLOCK_PREV_FREE     (1U << 1)
+#define HEAP_BLOCK_FLAGS         (HEAP_BLOCK_FREE | HEAP_BLOCK_PREV_FREE)
+
+typedef struct heap_block {
+	struct heap_block* prev_phys;   // Previous block in memory
+	size_t size;                    // Size of the payload and flags
+	// The following fields are only used by the free blocks (first bytes of the payload)
+	struct heap_block* next_free;
+	struct heap_block* prev_free;
+} heap_block_t;
+
+#define HEAP_BLOCK_HEADER        offsetof(heap_block_t, next_free)
+#define HEAP_BLOCK_SIZE_MIN      (sizeof(heap_block_t) - HEAP_BLOCK_HEADER)
+#define HEAP_BLOCK_SIZE_MAX      ((size_t)1 << HEAP_TLSF_FL_INDEX_MAX)
+
+struct polymcu_heap {
+	uint32_t fl_bitmap;
+	uint32_t sl_bitmap[HEAP_FL_COUNT];
+	heap_block_t* blocks[HEAP_FL_COUNT][HEAP_SL_COUNT];
+
+	size_t total_size;
+	size_t used_size;
+	size_t peak_used_size;
+	uint32_t alloc_count;
+	uint32_t failure_count;
+};
+
+#ifdef POLYMCU_HOST
+static uint8_t g_heap_memory[HEAP_SIZE] __attribute__((aligned(HEAP_ALIGN)));
+#endif
+
+static polymcu_heap_t* g_heap_default;
+
+//
+// Bit operations
+//
+static inline unsigned int heap_fls(size_t value) {
+	// Index of the most significant bit set
+	return (sizeof(unsigned long) * 8) - 1 - __builtin_clzl(value);
+}
+
+static inline unsigned int heap_ffs(uint32_t value) {
+	// Index of the least significant bit set
+	return __builtin_ctz(value);
+}
+
+//
+// Block helpers
+//
+static inline size_t heap_block_size(const heap_block_t* block) {
+	return block->size & ~(size_t)HEAP_BLOCK_FLAGS;
+}
+
+static inline void heap_block_set_size(heap_block_t* block, size_t size) {
+	block->size = size | (block->size & HEAP_BLOCK_FLAGS);
+}
+
+static inline int heap_block_is_free(const heap_block_t* block) {
+	return block->size & HEAP_BLOCK_FREE;
+}
+
+static inline int heap_block_is_last(const heap_block_t* block) {
+	// The sentinel block at the end of the heap has a null size
+	return heap_block_size(block) == 0;
+}
+
+static inline void* heap_block_to_ptr(const heap_block_t* block) {
+	return (uint8_t*)block + HEAP_BLOCK_HEADER;
+}
+
+static inline heap_block_t* heap_block_from_ptr(const void* ptr) {
+	return (heap_block_t*)((uint8_t*)ptr - HEAP_BLOCK_HEADER);
+}
+
+static inline heap_block_t* heap_block_next(const heap_block_t* block) {
+	return (heap_block_t*)((uint8_t*)heap_block_to_ptr(block) + heap_block_size(block));
+}
+
+// Update the flags of the block and of the next block
+static void heap_block_mark_free(heap_block_t* block) {
+	heap_block_t* next = heap_block_next(block);
+
+	block->size |= HEAP_BLOCK_FREE;
+	next->prev_phys = block;
+	next->size |= HEAP_BLOCK_PREV_FREE;
+}
+
+static void heap_block_mark_used(heap_block_t* block) {
+	heap_block_t* next = heap_block_next(block);
+
+	block->size &= ~(size_t)HEAP_BLOCK_FREE;
+	next->size &= ~(size_t)HEAP_BLOCK_PREV_FREE;
+}
+
+static inline size_t heap_align_up(size_t size) {
+	return (size + (HEAP_ALIGN - 1)) & ~(size_t)(HEAP_ALIGN - 1);
+}
+
+// Size of the block to allocate for a request of 'size' bytes. Return 0 if too large
+static size_t heap_adjust_size(size_t size) {
+	if (size >= HEAP_BLOCK_SIZE_MAX) {
+		return 0;
+	} else if (size < HEAP_BLOCK_SIZE_MIN) {
+		return HEAP_BLOCK_SIZE_MIN;
+	} else {
+		return heap_align_up(size);
+	}
+}
+
+//
+// Size to list mapping
+//
+static void heap_mapping_insert(size_t size, unsigned int* fl, unsigned int* sl) {
+	if (size < HEAP_SMALL_BLOCK_SIZE) {
+		*fl = 0;
+		*sl = size / (HEAP_SMALL_BLOCK_SIZE / HEAP_SL_COUNT);
+	} else {
+		unsigned int index = heap_fls(size);
+		*sl = (size >> (index - HEAP_SL_INDEX_LOG2)) ^ HEAP_SL_COUNT;
+		*fl = index - (HEAP_FL_INDEX_SHIFT - 1);
+	}
+}
+
+// Round up the size to the next list so any block of this list is large enough
+static void heap_mapping_search(size_t size, unsigned int* fl, unsigned int* sl) {
+	if (size >= HEAP_SMALL_BLOCK_SIZE) {
+		size += ((size_t)1 << (heap_fls(size) - HEAP_SL_INDEX_LOG2)) - 1;
+	}
+	heap_mapping_insert(size, fl, sl);
+}
+
+// Smallest block size of the list. It is also the largest allocation served by the list:
+// larger requests are rounded up to the next list by heap_mapping_search().
+static size_t heap_mapping_size(unsigned int fl, unsigned int sl) {
+	if (fl == 0) {
+		return sl * (HEAP_SMALL_BLOCK_SIZE / HEAP_SL_COUNT);
+	} else {
+		unsigned int index = fl + (HEAP_FL_INDEX_SHIFT - 1);
+		return ((size_t)1 << index) + ((size_t)sl << (index - HEAP_SL_INDEX_LOG2));
+	}
+}
+
+//
+// Free lists
+//
+static void heap_remove_free_block(polymcu_heap_t* heap, heap_block_t* block, unsigned int fl, unsigned int sl) {
+	heap_block_t* prev = block->prev_free;
+	heap_block_t* next = block->next_free;
+
+	if (next) {
+		next->prev_free = prev;
+	}
+	if (prev) {
+		prev->next_free = next;
+	} else {
+		// The block was the head of the list
+		heap->blocks[fl][sl] = next;
+		if (next == NULL) {
+			heap->sl_bitmap[fl] &= ~(1UL << sl);
+			if (heap->sl_bitmap[fl] == 0) {
+				heap->fl_bitmap &= ~(1UL << fl);
+			}
+		}
+	}
+}
+
+static void heap_insert_free_block(polymcu_heap_t* heap, heap_block_t* block) {
+	unsigned int fl, sl;
+
+	heap_mapping_insert(heap_block_size(block), &fl, &sl);
+
+	block->prev_free = NULL;
+	block->next_free = heap->blocks[fl][sl];
+	if (block->next_free) {
+		block->next_free->prev_free = block;
+	}
+	heap->blocks[fl][sl] = block;
+	heap->fl_bitmap |= 1UL << fl;
+	heap->sl_bitmap[fl] |= 1UL << sl;
+}
+
+static void heap_remove_block(polymcu_heap_t* heap, heap_block_t* block) {
+	unsigned int fl, sl;
+
+	heap_mapping_insert(heap_block_size(block), &fl, &sl);
+	heap_remove_free_block(heap, block, fl, sl);
+}
+
+// Return the first free block of at least 'size' bytes (already removed from its list)
+static heap_block_t* heap_find_free_block(polymcu_heap_t* heap, size_t size) {
+	unsigned int fl, sl;
+	uint32_t sl_map, fl_map;
+	heap_block_t* block;
+
+	heap_mapping_search(size, &fl, &sl);
+	if (fl >= HEAP_FL_COUNT) {
+		return NULL;
+	}
+
+	sl_map = heap->sl_bitmap[fl] & (~0UL << sl);
+	if (sl_map == 0) {
+		// Look for a larger size class
+		fl_map = (fl + 1 < 32) ? heap->fl_bitmap & (~0UL << (fl + 1)) : 0;
+		if (fl_map == 0) {
+			return NULL;
+		}
+		fl = heap_ffs(fl_map);
+		sl_map = heap->sl_bitmap[fl];
+	}
+	sl = heap_ffs(sl_map);
+
+	block = heap->blocks[fl][sl];
+	heap_remove_free_block(heap, block, fl, sl);
+	return block;
+}
+
+//
+// Split and merge
+//
+
+// Split 'block' to keep 'size' bytes. Return the remainder (or NULL if too small)
+static heap_block_t* heap_block_split(heap_block_t* block, size_t size) {
+	heap_block_t* remaining;
+	size_t remaining_size;
+
+	if (heap_block_size(block) < size + sizeof(heap_block_t)) {
+		return NULL;
+	}
+
+	remaining = (heap_block_t*)((uint8_t*)heap_block_to_ptr(block) + size);
+	remaining_size = heap_block_size(block) - size - HEAP_BLOCK_HEADER;
+	remaining->prev_phys = block;
+	remaining->size = remaining_size;
+	heap_block_next(remaining)->prev_phys = remaining;
+	heap_block_set_size(block, size);
+	return remaining;
+}
+
+// Merge the free 'block' with its free neighbours. Return the resulting block
+static heap_block_t* heap_block_merge(polymcu_heap_t* heap, heap_block_t* block) {
+	heap_block_t* next;
+
+	if (block->size & HEAP_BLOCK_PREV_FREE) {
+		heap_block_t* prev = block->prev_phys;
+		heap_remove_block(heap, prev);
+		heap_block_set_size(prev, heap_block_size(prev) + HEAP_BLOCK_HEADER + heap_block_size(block));
+		block = prev;
+		heap_block_next(block)->prev_phys = block;
+	}
+
+	next = heap_block_next(block);
+	if (heap_block_is_free(next)) {
+		heap_remove_block(heap, next);
+		heap_block_set_size(block, heap_block_size(block) + HEAP_BLOCK_HEADER + heap_block_size(next));
+		heap_block_next(block)->prev_phys = block;
+	}
+
+	return block;
+}
+
+// Give back the end of the used 'block' beyond 'size' bytes
+static void heap_block_trim_used(polymcu_heap_t* heap, heap_block_t* block, size_t size) {
+	heap_block_t* remaining = heap_block_split(block, size);
+
+	if (remaining) {
+		// 'block' is used: the remainder cannot be merged with it
+		remaining->size &= ~(size_t)HEAP_BLOCK_PREV_FREE;
+		heap_block_mark_free(remaining);
+		remaining = heap_block_merge(heap, remaining);
+		heap_insert_free_block(heap, remaining);
+	}
+}
+
+//
+// Public API
+//
+polymcu_heap_t* polymcu_heap_create(void* memory, size_t size) {
+	uintptr_t start = ((uintptr_t)memory + HEAP_ALIGN - 1) & ~(uintptr_t)(HEAP_ALIGN - 1);
+	uintptr_t end = ((uintptr_t)memory + size) & ~(uintptr_t)(HEAP_ALIGN - 1);
+	polymcu_heap_t* heap = (polymcu_heap_t*)start;
+	heap_block_t *block, *sentinel;
+	size_t block_size;
+
+	start += heap_align_up(sizeof(polymcu_heap_t));
+	// Room for the first block and the sentinel
+	if ((end < start) || (end - start < HEAP_BLOCK_HEADER + HEAP_BLOCK_SIZE_MIN + HEAP_BLOCK_HEADER)) {
+		return NULL;
+	}
+
+	memset(heap, 0, sizeof(polymcu_heap_t));
+
+	block_size = end - start - (2 * HEAP_BLOCK_HEADER);
+	if (block_size >= HEAP_BLOCK_SIZE_MAX) {
+		block_size = HEAP_BLOCK_SIZE_MAX - HEAP_ALIGN;
+	}
+
+	block = (heap_block_t*)start;
+	block->prev_phys = NULL;
+	block->size = block_size;
+
+	// The sentinel is a used block of null size. It prevents merging beyond the heap
+	sentinel = heap_block_next(block);
+	sentinel->size = 0;
+
+	heap_block_mark_free(block);
+	heap_insert_free_block(heap, block);
+
+	heap->total_size = block_size + HEAP_BLOCK_HEADER;
+	return heap;
+}
+
+polymcu_heap_t* polymcu_heap_default(void) {
+	if (g_heap_default == NULL) {
+		critical_section_enter();
+		if (g_heap_default == NULL) {
+#ifdef POLYMCU_HOST
+			g_heap_default = polymcu_heap_create(g_heap_memory, sizeof(g_heap_memory));
+#else
+			// From the end of the data to the bottom of the stack. '_sbrk_r()' fails with TLSF
+			extern uint8_t __HeapBase, __StackLimit;	/* Defined by the linker */
+			g_heap_default = polymcu_heap_create(&__HeapBase, &__StackLimit - &__HeapBase);
+#endif
+		}
+		critical_section_exit();
+	}
+	return g_heap_default;
+}
+
+void* polymcu_heap_malloc(polymcu_heap_t* heap, size_t size) {
+	size_t adjusted_size = heap_adjust_size(size);
+	heap_block_t* block;
+
+	if (heap == NULL) {
+		heap = polymcu_heap_default();
+	}
+	critical_section_enter();
+	block = adjusted_size ? heap_find_free_block(heap, adjusted_size) : NULL;
+	if (block == NULL) {
+		heap->failure_count++;
+		critical_section_exit();
+		return NULL;
+	}
+
+	heap_block_mark_used(block);
+	heap_block_trim_used(heap, block, adjusted_size);
+
+	heap->alloc_count++;
+	heap->used_size += heap_block_size(block) + HEAP_BLOCK_HEADER;
+	if (heap->used_size > heap->peak_used_size) {
+		heap->peak_used_size = heap->used_size;
+	}
+	critical_section_exit();
+
+	return heap_block_to_ptr(block);
+}
+
+void* polymcu_heap_memalign(polymcu_heap_t* heap, size_t alignment, size_t size) {
+	size_t adjusted_size = heap_adjust_size(size);
+	heap_block_t *block, *aligned;
+	uintptr_t ptr, aligned_ptr;
+	void* memory;
+
+	// The alignment must be a power of two
+	if (alignment & (alignment - 1)) {
+		return NULL;
+	} else if (alignment <= HEAP_ALIGN) {
+		return polymcu_heap_malloc(heap, size);
+	} else if ((adjusted_size == 0) || (adjusted_size + alignment + sizeof(heap_block_t) >= HEAP_BLOCK_SIZE_MAX)) {
+		return NULL;
+	}
+
+	if (heap == NULL) {
+		heap = polymcu_heap_default();
+	}
+
+	// Allocate enough to fit a free block in front of the aligned payload
+	memory = polymcu_heap_malloc(heap, adjusted_size + alignment + sizeof(heap_block_t));
+	if (memory == NULL) {
+		return NULL;
+	}
+
+	ptr = (uintptr_t)memory;
+	aligned_ptr = (ptr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	if (aligned_ptr == ptr) {
+		return memory;
+	}
+	while (aligned_ptr - ptr < sizeof(heap_block_t)) {
+		aligned_ptr += alignment;
+	}
+
+	critical_section_enter();
+	block = heap_block_from_ptr(memory);
+	heap->used_size -= heap_block_size(block) + HEAP_BLOCK_HEADER;
+
+	// Split the leading gap into a block that is freed
+	aligned = heap_block_split(block, aligned_ptr - ptr - HEAP_BLOCK_HEADER);
+	aligned->size &= ~(size_t)HEAP_BLOCK_FLAGS;
+	heap_block_mark_free(block);
+	block = heap_block_merge(heap, block);
+	heap_insert_free_block(heap, block);
+
+	// Give back the end of the block that is not needed
+	heap_block_trim_used(heap, aligned, adjusted_size);
+	heap->used_size += heap_block_size(aligned) + HEAP_BLOCK_HEADER;
+	critical_section_exit();
+
+	return heap_block_to_ptr(aligned);
+}
+
+void polymcu_heap_free(polymcu_heap_t* heap, void* ptr) {
+	heap_block_t* block;
+
+	if (ptr == NULL) {
+		return;
+	}
+	if (heap == NULL) {
+		heap = polymcu_heap_default();
+	}
+
+	block = heap_block_from_ptr(ptr);
+	assert(!heap_block_is_free(block));
+
+	critical_section_enter();
+	heap->alloc_count--;
+	heap->used_size -= heap_block_size(block) + HEAP_BLOCK_HEADER;
+
+	heap_block_mark_free(block);
+	block = heap_block_merge(heap, block);
+	heap_insert_free_block(heap, block);
+	critical_section_exit();
+}
+
+void* polymcu_heap_realloc(polymcu_heap_t* heap, void* ptr, size_t size) {
+	size_t adjusted_size = heap_adjust_size(size);
+	heap_block_t *block, *next;
+	size_t current_size;
+	void* new_ptr;
+
+	if (ptr == NULL) {
+		return polymcu_heap_malloc(heap, size);
+	} else if (size == 0) {
+		polymcu_heap_free(heap, ptr);
+		return NULL;
+	} else if (adjusted_size == 0) {
+		return NULL;
+	}
+	if (heap == NULL) {
+		heap = polymcu_heap_default();
+	}
+
+	block = heap_block_from_ptr(ptr);
+
+	critical_section_enter();
+	current_size = heap_block_size(block);
+	next = heap_block_next(block);
+
+	if ((adjusted_size > current_size) && heap_block_is_free(next) &&
+		(current_size + HEAP_BLOCK_HEADER + heap_block_size(next) >= adjusted_size)) {
+		// Grow in place by absorbing the next free block
+		heap_remove_block(heap, next);
+		heap_block_set_size(block, current_size + HEAP_BLOCK_HEADER + heap_block_size(next));
+		heap_block_mark_used(block);
+		heap_block_next(block)->prev_phys = block;
+	}
+
+	if (adjusted_size <= heap_block_size(block)) {
+		heap->used_size -= current_size;
+		heap_block_trim_used(heap, block, adjusted_size);
+		heap->used_size += heap_block_size(block);
+		if (heap->used_size > heap->peak_used_size) {
+			heap->peak_used_size = heap->used_size;
+		}
+		critical_section_exit();
+		return ptr;
+	}
+	critical_section_exit();
+
+	// Move the data to a new block
+	new_ptr = polymcu_heap_malloc(heap, size);
+	if (new_ptr) {
+		memcpy(new_ptr, ptr, current_size);
+		polymcu_heap_free(heap, ptr);
+	}
+	return new_ptr;
+}
+
+void polymcu_heap_get_stats(polymcu_heap_t* heap, polymcu_heap_stats_t* stats) {
+	unsigned int fl, sl;
+	size_t largest = 0;
+
+	if (heap == NULL) {
+		heap = polymcu_heap_default();
+	}
+
+	critical_section_enter();
+	// The largest allocation is served by the highest non-empty list. The blocks of this
+	// list might be larger but a larger request is looked up in the next lists.
+	if (heap->fl_bitmap) {
+		fl = heap_fls(heap->fl_bitmap);
+		sl = heap_fls(heap->sl_bitmap[fl]);
+		largest = heap_mapping_size(fl, sl);
+	}
+
+	stats->total_size         = heap->total_size;
+	stats->used_size          = heap->used_size;
+	stats->peak_used_size     = heap->peak_used_size;
+	stats->free_size          = heap->total_size - heap->used_size;
+	stats->largest_free_block = largest;
+	stats->alloc_count        = heap->alloc_count;
+	stats->failure_count      = heap->failure_count;
+	critical_section_exit();
+
+	// Share of the free memory that cannot be used by the largest allocation
+	if (stats->free_size && largest) {
+		stats->fragmentation = 100 - ((uint64_t)(largest + HEAP_BLOCK_HEADER) * 100 / stats->free_size);
+	} else {
+		stats->fragmentation = 0;
+	}
+}
+
+#ifndef POLYMCU_HOST
+#include <reent.h>
+
+//
+// newlib memory allocator. Replace the one based on '_sbrk_r()'
+//
+void* _malloc_r(struct _reent* reent, size_t size) {
+	void* ptr = polymcu_heap_malloc(NULL, size);
+	if (ptr == NULL) {
+		reent->_errno = ENOMEM;
+	}
+	return ptr;
+}
+
+void _free_r(struct _reent* reent, void* ptr) {
+	polymcu_heap_free(NULL, ptr);
+}
+
+void* _calloc_r(struct _reent* reent, size_t count, size_t size) {
+	size_t total = count * size;
+	void* ptr;
+
+	if ((size != 0) && (total / size != count)) {
+		reent->_errno = ENOMEM;
+		return NULL;
+	}
+
+	ptr = _malloc_r(reent, total);
+	if (ptr) {
+		memset(ptr, 0, total);
+	}
+	return ptr;
+}
+
+void* _realloc_r(struct _reent* reent, void* ptr, size_t size) {
+	void* new_ptr = polymcu_heap_realloc(NULL, ptr, size);
+	if ((new_ptr == NULL) && (size != 0)) {
+		reent->_errno = ENOMEM;
+	}
+	return new_ptr;
+}
+
+void* _memalign_r(struct _reent* reent, size_t alignment, size_t size) {
+	void* ptr = polymcu_heap_memalign(NULL, alignment, size);
+	if (ptr == NULL) {
+		reent->_errno = ENOMEM;
+	}
+	return ptr;
+}
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include "PolyMCU.h"
+
+//
+// Binary log ring
+//
+// A record is made of little-endian 32-bit words:
+//   - header: POLYMCU_LOG_SYNC | (nargs << 8) | (sequence << 16)
+//   - identifier of the format string (its address in the '.polymcu_log' section)
+//   - 'nargs' arguments
+// The sequence number lets the decoder detect the dropped records.
+//
+// The ring is exported as 'polymcu_log' so a debugger can also read it from the
+// memory (with DEBUG_LOG_MEMORY, the records are only kept in memory).
+//
+
+#ifndef DEBUG_LOG_BUFFER_SIZE
+  #define DEBUG_LOG_BUFFER_SIZE    1024
+#endif
+
+#if (DEBUG_LOG_BUFFER_SIZE & (DEBUG_LOG_BUFFER_SIZE - 1)) != 0
+  #error "DEBUG_LOG_BUFFER_SIZE must be a power of two"
+#endif
+
+#define POLYMCU_LOG_SYNC         0xA5
+#define POLYMCU_LOG_MAX_ARGS     8
+#define POLYMCU_LOG_MASK         (DEBUG_LOG_BUFFER_SIZE - 1)
+
+struct {
+	char magic[12];                 // "POLYMCU LOG" to locate the ring from a debugger
+	uint32_t size;                  // Size of 'buffer'
+	volatile uint32_t head;         // Free running write index
+	volatile uint32_t tail;         // Free running read index
+	volatile uint32_t dropped;      // Number of dropped records
+	uint8_t buffer[DEBUG_LOG_BUFFER_SIZE];
+} polymcu_log = { "POLYMCU LOG", DEBUG_LOG_BUFFER_SIZE, 0, 0, 0, { 0 } };
+
+static uint16_t g_log_sequence;
+static volatile unsigned int g_log_flushing;
+
+void polymcu_log_write(uint32_t id, unsigned int nargs, ...) {
+	uint32_t record[POLYMCU_LOG_MAX_ARGS + 2];
+	unsigned int i, size;
+	va_list ap;
+
+	if (nargs > POLYMCU_LOG_MAX_ARGS) {
+		nargs = POLYMCU_LOG_MAX_ARGS;
+	}
+
+	record[1] = id;
+	va_start(ap, nargs);
+	for (i = 0; i < nargs; i++) {
+		record[i + 2] = va_arg(ap, uint32_t);
+	}
+	va_end(ap);
+	size = (nargs + 2) * sizeof(uint32_t);
+
+	critical_section_enter();
+	// The sequence number is also incremented for the dropped records
+	record[0] = POLYMCU_LOG_SYNC | (nargs << 8) | ((uint32_t)g_log_sequence++ << 16);
+	if (DEBUG_LOG_BUFFER_SIZE - (polymcu_log.head - polymcu_log.tail) < size) {
+		polymcu_log.dropped++;
+		critical_section_exit();
+		return;
+	}
+	for (i = 0; i < size; i++) {
+		polymcu_log.buffer[polymcu_log.head++ & POLYMCU_LOG_MASK] = ((uint8_t*)record)[i];
+	}
+	critical_section_exit();
+
+#ifndef DEBUG_LOG_MEMORY
+	// The debug output might wait for the UART, do not do it from an interrupt
+	if (__get_IPSR() == 0) {
+		polymcu_log_flush();
+	}
+#endif
+}
+
+void polymcu_log_flush(void) {
+#ifndef DEBUG_LOG_MEMORY
+	uint32_t tail, len;
+	int written;
+
+	critical_section_enter();
+	if (g_log_flushing) {
+		critical_section_exit();
+		return;
+	}
+	g_log_flushing = 1;
+	critical_section_exit();
+
+	while (polymcu_log.head != polymcu_log.tail) {
+		tail = polymcu_log.tail & POLYMCU_LOG_MASK;
+		len = polymcu_log.head - polymcu_log.tail;
+		if (len > DEBUG_LOG_BUFFER_SIZE - tail) {
+			len = DEBUG_LOG_BUFFER_SIZE - tail;
+		}
+
+		written = polymcu_uart_write_raw(&polymcu_log.buffer[tail], len);
+		if (written <= 0) {
+			// The debug output is full, the records will be sent on the next flush
+			break;
+		}
+		polymcu_log.tail += written;
+	}
+
+	g_log_flushing = 0;
+#endif
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015, Lab A Part
+ * Copyright (c) 2015-2017, Lab A Part
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -28,215 +28,239 @@
 #include <strings.h>
 #include "PolyMCU.h"
 
-#define POLYMCU_MAIL_ENTRY_STATUS_FREE         0
-#define POLYMCU_MAIL_ENTRY_STATUS_ALLOCATED	(1 << 0)
-#define POLYMCU_MAIL_ENTRY_STATUS_PUSHED		(1 << 2)
+// Values of 'link[]' for the entries that are not in the free list
+#define POLYMCU_MAIL_ENTRY_ALLOCATED	0x80000000
+#define POLYMCU_MAIL_ENTRY_PUSHED		0x80000001
 
-void polymcu_mailbox_init(polymcu_mailbox_t *mail) {
-	bzero(mail->buffer, mail->type_size * mail->count);
-	bzero(mail->status, sizeof(uint8_t) * mail->count);
-	bzero(mail->fifo, sizeof(uint32_t) * mail->count);
-	mail->fifo_head = 0;
+// Free entries store the index of the next free entry relatively to their own
+// successor. It means a zero-initialized 'link[]' is a valid free list where
+// entry 'i' links to entry 'i + 1'. The index 'count' marks the end of the list.
+static inline uint32_t link_encode(uint32_t index, uint32_t next) {
+	return next - index - 1;
 }
 
-void* polymcu_mailbox_allocate(polymcu_mailbox_t *mail) {
-	int i;
-
-	critical_section_enter();
-	for (i = 0; i < mail->count; i++) {
-		if (mail->status[i] == POLYMCU_MAIL_ENTRY_STATUS_FREE) {
-			mail->status[i] = POLYMCU_MAIL_ENTRY_STATUS_ALLOCATED;
-			critical_section_exit();
+static inline uint32_t link_decode(uint32_t index, uint32_t link) {
+	return link + index + 1;
+}
 
-			return mail->buffer + (i * mail->type_size);
-		}
-	}
-	critical_section_exit();
+// Ring slots hold 'index + 1' once the entry is published. A zero slot is either free or
+// reserved by a producer that has not stored its entry yet.
+#define POLYMCU_MAIL_SLOT_EMPTY			0
 
-	return NULL;
+static inline uint32_t slot_encode(uint32_t index) {
+	return index + 1;
 }
 
-void polymcu_mailbox_free(polymcu_mailbox_t *mail, void* buffer) {
-	uint32_t offset = (uint32_t)buffer - (uint32_t)mail->buffer;
+static inline uint32_t slot_decode(uint32_t slot) {
+	return slot - 1;
+}
 
-	if (offset % mail->type_size != 0) {
-		// The buffer must be a multiple of 'type_size'
-		DEBUG_NOT_VALID();
-	} else {
-		assert(mail->status[offset / mail->type_size] == POLYMCU_MAIL_ENTRY_STATUS_ALLOCATED);
-		mail->status[offset / mail->type_size] = POLYMCU_MAIL_ENTRY_STATUS_FREE;
-	}
+// The ring has 'count + 1' slots
+static inline uint32_t fifo_next(polymcu_mailbox_t *mail, uint32_t fifo_index) {
+	return (fifo_index == mail->count) ? 0 : fifo_index + 1;
 }
 
-static void check_fifo(polymcu_mailbox_t *mail, void* buffer) {
-	for (int i = 0; i < mail->count; i++) {
-		assert(mail->fifo[i] != buffer);
-	}
+static inline uint32_t fifo_previous(polymcu_mailbox_t *mail, uint32_t fifo_index) {
+	return (fifo_index == 0) ? mail->count : fifo_index - 1;
 }
 
-int polymcu_mailbox_put(polymcu_mailbox_t *mail, void* buffer) {
-	uint32_t offset = (uint32_t)buffer - (uint32_t)mail->buffer;
-	uint32_t index, fifo_index;
-	uint32_t found;
+static int get_entry_index(polymcu_mailbox_t *mail, void* buffer, uint32_t* index) {
+	uint32_t offset = (uint8_t*)buffer - mail->buffer;
 
-	check_fifo(mail, buffer);
 	assert(buffer != NULL);
-	assert(((uint32_t)buffer >= (uint32_t)mail->buffer) &&
-			((uint32_t)buffer < (uint32_t)(mail->buffer + (mail->type_size * mail->count))));
+	assert(offset < mail->type_size * mail->count);
 
 	if (offset % mail->type_size != 0) {
 		// The buffer must be a multiple of 'type_size'
 		DEBUG_NOT_VALID();
 		return -1;
 	} else {
-		index = offset / mail->type_size;
+		*index = offset / mail->type_size;
+		return 0;
+	}
+}
 
-		assert(mail->status[index] == POLYMCU_MAIL_ENTRY_STATUS_ALLOCATED);
+void polymcu_mailbox_init(polymcu_mailbox_t *mail) {
+	bzero(mail->buffer, mail->type_size * mail->count);
+	bzero(mail->link, sizeof(uint32_t) * mail->count);
+	bzero(mail->fifo, sizeof(uint32_t) * (mail->count + 1));
+	mail->free_head = 0;
+	mail->fifo_head = 0;
+	mail->fifo_tail = 0;
+}
 
-		critical_section_enter();
-		// Add to the FIFO
-		if (mail->fifo[mail->fifo_head] == NULL) {
-			// Case the FIFO is empty
-			mail->fifo[mail->fifo_head] = buffer;
-			found = 1;
-		} else {
-			//
-			// Find the next free entry
-			//
-			found = 0;
-
-			// Look for the entries [fifo_head + 1; count - 1]
-			for (fifo_index = mail->fifo_head + 1; fifo_index < mail->count; fifo_index++) {
-				if (mail->fifo[fifo_index] == NULL) {
-					mail->fifo[fifo_index] = buffer;
-					found = 1;
-					break;
-				}
-			}
-
-			// If an entry has not been found look between [0; fifo_head - 1]
-			if (found == 0) {
-				for (fifo_index = 0; fifo_index < mail->fifo_head; fifo_index++) {
-					if (mail->fifo[fifo_index] == NULL) {
-						mail->fifo[fifo_index] = buffer;
-						found = 1;
-						break;
-					}
-				}
-			}
-		}
-		if (found) {
-			// Mark as pushed
-			mail->status[index] = POLYMCU_MAIL_ENTRY_STATUS_PUSHED;
-			critical_section_exit();
-			return 0;
-		} else {
-			DEBUG_NOT_VALID();
-			critical_section_exit();
-			return -2;
+void* polymcu_mailbox_allocate(polymcu_mailbox_t *mail) {
+	uint32_t index;
+
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	do {
+		index = __LDREXW(&mail->free_head);
+		if (index == mail->count) {
+			__CLREX();
+			return NULL;
 		}
+	} while (__STREXW(link_decode(index, mail->link[index]), &mail->free_head));
+#else
+	critical_section_enter();
+	index = mail->free_head;
+	if (index == mail->count) {
+		critical_section_exit();
+		return NULL;
 	}
+	mail->free_head = link_decode(index, mail->link[index]);
+	critical_section_exit();
+#endif
+
+	mail->link[index] = POLYMCU_MAIL_ENTRY_ALLOCATED;
+	return mail->buffer + (index * mail->type_size);
 }
 
-int polymcu_mailbox_insert_first(polymcu_mailbox_t *mail, void* buffer) {
-	uint32_t offset = (uint32_t)buffer - (uint32_t)mail->buffer;
-	uint32_t index, fifo_index;
+void polymcu_mailbox_free(polymcu_mailbox_t *mail, void* buffer) {
+	uint32_t index, free_head;
 
-	check_fifo(mail, buffer);
-	assert(buffer != NULL);
-	assert(((uint32_t)buffer >= (uint32_t)mail->buffer) &&
-			((uint32_t)buffer < (uint32_t)(mail->buffer + (mail->type_size * mail->count))));
+	if (get_entry_index(mail, buffer, &index) != 0) {
+		return;
+	}
+	assert(mail->link[index] == POLYMCU_MAIL_ENTRY_ALLOCATED);
+
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	do {
+		do {
+			free_head = mail->free_head;
+			mail->link[index] = link_encode(index, free_head);
+			__DMB();
+		} while (free_head != __LDREXW(&mail->free_head));
+	} while (__STREXW(index, &mail->free_head));
+#else
+	critical_section_enter();
+	free_head = mail->free_head;
+	mail->link[index] = link_encode(index, free_head);
+	mail->free_head = index;
+	critical_section_exit();
+#endif
+}
 
-	if (offset % mail->type_size != 0) {
-		// The buffer must be a multiple of 'type_size'
-		DEBUG_NOT_VALID();
-		return -1;
-	} else {
-		index = offset / mail->type_size;
+int polymcu_mailbox_put(polymcu_mailbox_t *mail, void* buffer) {
+	uint32_t index, fifo_tail;
 
-		assert(mail->status[index] == POLYMCU_MAIL_ENTRY_STATUS_ALLOCATED);
+	if (get_entry_index(mail, buffer, &index) != 0) {
+		return -1;
+	}
+	// Also catch the buffers that are already in the FIFO
+	assert(mail->link[index] == POLYMCU_MAIL_ENTRY_ALLOCATED);
+
+	// Mark as pushed before the entry becomes visible to the consumer
+	mail->link[index] = POLYMCU_MAIL_ENTRY_PUSHED;
+
+	// The ring cannot be full as it has one more slot than the number of entries
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	// Reserve the slot first. Another producer can only reserve the next one.
+	do {
+		fifo_tail = __LDREXW(&mail->fifo_tail);
+	} while (__STREXW(fifo_next(mail, fifo_tail), &mail->fifo_tail));
+
+	// Publish the entry into the reserved slot
+	__DMB();
+	assert(mail->fifo[fifo_tail] == POLYMCU_MAIL_SLOT_EMPTY);
+	mail->fifo[fifo_tail] = slot_encode(index);
+#else
+	critical_section_enter();
+	fifo_tail = mail->fifo_tail;
+	mail->fifo[fifo_tail] = slot_encode(index);
+	mail->fifo_tail = fifo_next(mail, fifo_tail);
+	critical_section_exit();
+#endif
+	return 0;
+}
 
-		critical_section_enter();
-		// Add to the FIFO
-		if (mail->fifo[mail->fifo_head] == NULL) {
-			// Case the FIFO is empty
-			mail->fifo[mail->fifo_head] = buffer;
-		} else {
-			if (mail->fifo_head == 0) {
-				fifo_index = mail->count - 1;
-			} else {
-				fifo_index = mail->fifo_head - 1;
-			}
-
-			assert(mail->fifo[fifo_index] == NULL);
-			mail->fifo[fifo_index] = buffer;
-			mail->fifo_head = fifo_index;
-		}
+int polymcu_mailbox_insert_first(polymcu_mailbox_t *mail, void* buffer) {
+	uint32_t index, fifo_head;
 
-		// Mark as pushed
-		mail->status[index] = POLYMCU_MAIL_ENTRY_STATUS_PUSHED;
-		critical_section_exit();
-		return 0;
+	if (get_entry_index(mail, buffer, &index) != 0) {
+		return -1;
 	}
+	// Also catch the buffers that are already in the FIFO
+	assert(mail->link[index] == POLYMCU_MAIL_ENTRY_ALLOCATED);
+
+	// Mark as pushed before the entry becomes visible to the consumer
+	mail->link[index] = POLYMCU_MAIL_ENTRY_PUSHED;
+
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	// Reserve the slot preceding the head, then publish the entry into it
+	do {
+		fifo_head = fifo_previous(mail, __LDREXW(&mail->fifo_head));
+	} while (__STREXW(fifo_head, &mail->fifo_head));
+
+	__DMB();
+	assert(mail->fifo[fifo_head] == POLYMCU_MAIL_SLOT_EMPTY);
+	mail->fifo[fifo_head] = slot_encode(index);
+#else
+	critical_section_enter();
+	fifo_head = fifo_previous(mail, mail->fifo_head);
+	mail->fifo[fifo_head] = slot_encode(index);
+	mail->fifo_head = fifo_head;
+	critical_section_exit();
+#endif
+	return 0;
 }
 
 void* polymcu_mailbox_get(polymcu_mailbox_t *mail) {
-	void* buffer = mail->fifo[mail->fifo_head];
-	uint32_t offset, index;
+	uint32_t index, slot, fifo_head;
 
-	if (buffer == NULL) {
-		// Case the FIFO is empty
-		return NULL;
-	} else {
-		offset = (uint32_t)buffer - (uint32_t)mail->buffer;
-		index = offset / mail->type_size;
-
-		critical_section_enter();
-		// Free the FIFO
-		mail->fifo[mail->fifo_head] = NULL;
-
-		// Update the fifo_index
-		mail->fifo_head++;
-		if (mail->fifo_head == mail->count) {
-			mail->fifo_head = 0; // Start again at the beginning
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	while (1) {
+		fifo_head = __LDREXW(&mail->fifo_head);
+		if (fifo_head == mail->fifo_tail) {
+			// Case the FIFO is empty
+			__CLREX();
+			return NULL;
+		}
+		slot = mail->fifo[fifo_head];
+		if (slot == POLYMCU_MAIL_SLOT_EMPTY) {
+			// The producer that reserved the slot has not published its entry yet
+			__CLREX();
+			return NULL;
 		}
 
-		assert(mail->status[index] == POLYMCU_MAIL_ENTRY_STATUS_PUSHED);
-		// Mark the buffer as allocated
-		mail->status[index] = POLYMCU_MAIL_ENTRY_STATUS_ALLOCATED;
-
+		// Free the slot before releasing it to the producers. Nobody can move the head
+		// past an empty slot, so the slot cannot be reserved again until the head moves.
+		mail->fifo[fifo_head] = POLYMCU_MAIL_SLOT_EMPTY;
+		if (__STREXW(fifo_next(mail, fifo_head), &mail->fifo_head) == 0) {
+			break;
+		}
+		// Another context ran in between: the slot is still in the FIFO, restore it
+		mail->fifo[fifo_head] = slot;
+	}
+	__DMB();
+#else
+	critical_section_enter();
+	fifo_head = mail->fifo_head;
+	if (fifo_head == mail->fifo_tail) {
+		// Case the FIFO is empty
 		critical_section_exit();
-		return buffer;
+		return NULL;
 	}
+	slot = mail->fifo[fifo_head];
+	mail->fifo[fifo_head] = POLYMCU_MAIL_SLOT_EMPTY;
+	mail->fifo_head = fifo_next(mail, fifo_head);
+	critical_section_exit();
+#endif
+
+	index = slot_decode(slot);
+	assert(mail->link[index] == POLYMCU_MAIL_ENTRY_PUSHED);
+	// Mark the buffer as allocated
+	mail->link[index] = POLYMCU_MAIL_ENTRY_ALLOCATED;
+
+	return mail->buffer + (index * mail->type_size);
 }
 
 uint32_t polymcu_mailbox_length(polymcu_mailbox_t *mail) {
-	if (mail->fifo[mail->fifo_head] == NULL) {
-		return 0;
-	} else {
-		uint32_t fifo_index, length = 1;
-
-		critical_section_enter();
-		// Look for the entries [fifo_head + 1; count - 1]
-		for (fifo_index = mail->fifo_head + 1; fifo_index < mail->count; fifo_index++) {
-			if (mail->fifo[fifo_index] == NULL) {
-				critical_section_exit();
-				return length;
-			} else {
-				length++;
-			}
-		}
+	uint32_t fifo_head = mail->fifo_head;
+	uint32_t fifo_tail = mail->fifo_tail;
 
-		// Look between [0; fifo_head - 1]
-		for (fifo_index = 0; fifo_index < mail->fifo_head; fifo_index++) {
-			if (mail->fifo[fifo_index] == NULL) {
-				critical_section_exit();
-				return length;
-			} else {
-				length++;
-			}
-		}
-		critical_section_exit();
-		return length;
+	if (fifo_tail >= fifo_head) {
+		return fifo_tail - fifo_head;
+	} else {
+		return fifo_tail + (mail->count + 1) - fifo_head;
 	}
 }
@@ -30,12 +30,19 @@
 #include <unistd.h>
 #include "PolyMCU.h"
 
+#if defined(SUPPORT_HEAP_TLSF) && !defined(POLYMCU_HOST)
+#include <errno.h>
+#include <reent.h>
+#endif
+
 #ifndef NDEBUG
   #define PRINT_DEBUG(str) write(1, str, strlen(str))
 #else
   #define PRINT_DEBUG(str)
 #endif
 
+// The host board relies on its C library and emulates the Cortex-M core
+#ifndef POLYMCU_HOST
 __attribute__((weak, noreturn)) void polymcu_watchdog_trigger(void) {
 	NVIC_SystemReset();
 	// We should never reach this line...
@@ -48,6 +55,14 @@ void abort(void) {
 	}
 }
 
+#ifdef SUPPORT_HEAP_TLSF
+// The region between the data and the stack belongs to the TLSF heap. Growing it from
+// '_sbrk_r()' would corrupt the heap: fail the request of any remaining newlib user.
+caddr_t _sbrk_r(void *reent, size_t incr) {
+	((struct _reent*)reent)->_errno = ENOMEM;
+	return (caddr_t)-1;
+}
+#else
 caddr_t _sbrk_r(void *reent, size_t incr) {
 	extern uint8_t __HeapBase, __StackLimit;	/* Defined by the linker */
 	static uint8_t* heap_end;
@@ -68,6 +83,8 @@ caddr_t _sbrk_r(void *reent, size_t incr) {
 	heap_end += incr;
 	return (caddr_t) prev_heap_end;
 }
+#endif
+#endif
 
 void print_buffer_hex(uint8_t* ptr, size_t size) {
 	for (unsigned int i = 0; i < size; i++) {
@@ -103,7 +120,7 @@ static void print_int(int i) {
 }
 #endif
 
-#ifndef NDEBUG
+#if !defined(NDEBUG) && !defined(POLYMCU_HOST)
 static void print_hex(uint32_t i) {
 	unsigned digit_count = 0;
 	char c;
@@ -147,12 +164,16 @@ void __assert_func(const char *filename, int line, const char *function, const c
 
 #ifdef SUPPORT_WATCHDOG
 	polymcu_watchdog_trigger();
+#elif defined(SUPPORT_SEMIHOSTING)
+	// Terminate the emulation with a failure instead of waiting for a debugger
+	_exit(1);
 #else
 	__BKPT(0);
 	while(1);
 #endif
 }
 
+#ifndef POLYMCU_HOST
 #if defined (__GNUC__) &&  !defined(__clang__)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-but-set-variable"
@@ -191,8 +212,12 @@ void prvGetRegistersFromStack(uint32_t *pulFaultStackAddress) {
 	PRINT_DEBUG("\r\n");
 #endif
 
+#ifdef SUPPORT_SEMIHOSTING
+	_exit(1);
+#else
 	__BKPT(0);
 	for( ;; );
+#endif
 }
 #if defined (__GNUC__) &&  !defined(__clang__)
 #pragma GCC diagnostic pop
@@ -221,17 +246,4 @@ __attribute__((naked)) void HardFault_Handler(void) {
 	);
 #endif
 }
-
-static uint32_t m_in_critical_section = 0;
-
-__attribute__((weak)) void critical_section_enter(void) {
-	__disable_irq();
-	m_in_critical_section++;
-}
-
-__attribute__((weak)) void critical_section_exit(void) {
-	m_in_critical_section--;
-	if (m_in_critical_section == 0) {
-		__enable_irq();
-	}
-}
+#endif
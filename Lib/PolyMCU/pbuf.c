@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "PolyMCU.h"
+
+static inline uint8_t* pbuf_data(polymcu_pbuf_t* p) {
+	return (uint8_t*)(p + 1);
+}
+
+static polymcu_pbuf_t* pbuf_pool_get(polymcu_pbuf_pool_t *pool) {
+	polymcu_pbuf_t* p;
+
+	// The free list is LIFO. The buffer used the most recently is likely to be in the cache
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	do {
+		p = (polymcu_pbuf_t*)__LDREXW((volatile uint32_t*)&pool->free_head);
+		if (p == NULL) {
+			__CLREX();
+			return NULL;
+		}
+	} while (__STREXW((uint32_t)p->next, (volatile uint32_t*)&pool->free_head));
+#else
+	critical_section_enter();
+	p = pool->free_head;
+	if (p != NULL) {
+		pool->free_head = p->next;
+	}
+	critical_section_exit();
+#endif
+	return p;
+}
+
+static void pbuf_pool_put(polymcu_pbuf_t* p) {
+	polymcu_pbuf_pool_t *pool = p->pool;
+
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	polymcu_pbuf_t* free_head;
+
+	do {
+		do {
+			free_head = pool->free_head;
+			p->next = free_head;
+			__DMB();
+		} while ((uint32_t)free_head != __LDREXW((volatile uint32_t*)&pool->free_head));
+	} while (__STREXW((uint32_t)p, (volatile uint32_t*)&pool->free_head));
+#else
+	critical_section_enter();
+	p->next = pool->free_head;
+	pool->free_head = p;
+	critical_section_exit();
+#endif
+}
+
+// Return the new reference count
+static uint32_t pbuf_ref_add(polymcu_pbuf_t* p, int32_t value) {
+	uint32_t ref;
+
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+	do {
+		ref = __LDREXW(&p->ref) + value;
+	} while (__STREXW(ref, &p->ref));
+#else
+	critical_section_enter();
+	ref = p->ref + value;
+	p->ref = ref;
+	critical_section_exit();
+#endif
+	return ref;
+}
+
+void polymcu_pbuf_pool_init(polymcu_pbuf_pool_t *pool) {
+	polymcu_pbuf_t* p;
+
+	pool->free_head = NULL;
+	for (uint32_t i = 0; i < pool->count; i++) {
+		p = (polymcu_pbuf_t*)(pool->blocks + ((pool->count - 1 - i) * pool->block_size));
+		p->pool = pool;
+		p->next = pool->free_head;
+		pool->free_head = p;
+	}
+}
+
+polymcu_pbuf_t* polymcu_pbuf_alloc(polymcu_pbuf_pool_t *pool, uint32_t length, uint32_t headroom) {
+	polymcu_pbuf_t *head = NULL, *tail = NULL, *p;
+	uint32_t offset = headroom;
+	uint32_t remaining = length;
+
+	if ((headroom >= pool->size) || (length > UINT16_MAX)) {
+		DEBUG_NOT_VALID();
+		return NULL;
+	}
+
+	do {
+		p = pbuf_pool_get(pool);
+		if (p == NULL) {
+			if (head != NULL) {
+				polymcu_pbuf_free(head);
+			}
+			return NULL;
+		}
+
+		p->next    = NULL;
+		p->payload = pbuf_data(p) + offset;
+		p->len     = (remaining < pool->size - offset) ? remaining : pool->size - offset;
+		p->tot_len = remaining;
+		p->ref     = 1;
+		remaining -= p->len;
+		offset = 0;
+
+		if (tail != NULL) {
+			tail->next = p;
+		} else {
+			head = p;
+		}
+		tail = p;
+	} while (remaining > 0);
+
+	return head;
+}
+
+void polymcu_pbuf_ref(polymcu_pbuf_t* p) {
+	assert(p->ref > 0);
+	pbuf_ref_add(p, 1);
+}
+
+void polymcu_pbuf_free(polymcu_pbuf_t* p) {
+	polymcu_pbuf_t* next;
+
+	// Each buffer of the chain holds a reference on the next one
+	while (p != NULL) {
+		assert(p->ref > 0);
+		if (pbuf_ref_add(p, -1) != 0) {
+			break;
+		}
+		next = p->next;
+		pbuf_pool_put(p);
+		p = next;
+	}
+}
+
+void polymcu_pbuf_chain(polymcu_pbuf_t* head, polymcu_pbuf_t* tail) {
+	assert((uint32_t)head->tot_len + tail->tot_len <= UINT16_MAX);
+
+	while (head->next != NULL) {
+		head->tot_len += tail->tot_len;
+		head = head->next;
+	}
+	head->tot_len += tail->tot_len;
+	head->next = tail;
+}
+
+int polymcu_pbuf_header(polymcu_pbuf_t* p, int size) {
+	uint8_t* payload = p->payload - size;
+
+	if ((payload < pbuf_data(p)) || (size + p->len < 0) || (size + p->tot_len > UINT16_MAX)) {
+		return -1;
+	}
+
+	p->payload = payload;
+	p->len += size;
+	p->tot_len += size;
+	return 0;
+}
+
+uint32_t polymcu_pbuf_space(polymcu_pbuf_t* p) {
+	return p->pool->size - (p->payload - pbuf_data(p));
+}
+
+int polymcu_pbuf_set_length(polymcu_pbuf_t* p, uint32_t length) {
+	polymcu_pbuf_t *q, *next;
+	uint32_t remaining = length;
+	uint32_t space = 0;
+
+	if (length > UINT16_MAX) {
+		return -1;
+	}
+	for (q = p; q != NULL; q = q->next) {
+		space += polymcu_pbuf_space(q);
+	}
+	if (length > space) {
+		return -1;
+	}
+
+	for (q = p; ; q = q->next) {
+		space = polymcu_pbuf_space(q);
+		q->len = (remaining < space) ? remaining : space;
+		q->tot_len = remaining;
+		remaining -= q->len;
+
+		if ((remaining == 0) || (q->next == NULL)) {
+			break;
+		}
+	}
+
+	// Release the rest of the chain
+	next = q->next;
+	q->next = NULL;
+	if (next != NULL) {
+		polymcu_pbuf_free(next);
+	}
+	return 0;
+}
+
+uint32_t polymcu_pbuf_copy(const polymcu_pbuf_t* p, uint32_t offset, void* data, uint32_t length) {
+	uint32_t copied = 0, chunk;
+
+	for (; (p != NULL) && (copied < length); p = p->next) {
+		if (offset >= p->len) {
+			offset -= p->len;
+			continue;
+		}
+		chunk = p->len - offset;
+		if (chunk > length - copied) {
+			chunk = length - copied;
+		}
+		memcpy((uint8_t*)data + copied, p->payload + offset, chunk);
+		copied += chunk;
+		offset = 0;
+	}
+	return copied;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "PolyMCU.h"
+
+// List of the zones that have been entered at least once
+static polymcu_profile_zone_t* volatile g_profile_zones;
+
+void polymcu_profile_init(void) {
+	// Enable the cycle counter
+	(void)polymcu_time_cycles();
+}
+
+static unsigned int profile_log2(uint32_t cycles) {
+	if (cycles == 0) {
+		return 0;
+	} else {
+		return 31 - __builtin_clz(cycles);
+	}
+}
+
+void polymcu_profile_record(polymcu_profile_zone_t* zone, uint32_t cycles) {
+	unsigned int bucket = profile_log2(cycles);
+
+	// The same zone might be used by several contexts
+	critical_section_enter();
+	if (zone->count == 0) {
+		// Register the zone on its first use (it stays registered after a reset)
+		if (!zone->registered) {
+			zone->next = g_profile_zones;
+			g_profile_zones = zone;
+			zone->registered = 1;
+		}
+		zone->min = cycles;
+		zone->max = cycles;
+	} else if (cycles < zone->min) {
+		zone->min = cycles;
+	} else if (cycles > zone->max) {
+		zone->max = cycles;
+	}
+	zone->count++;
+	zone->total += cycles;
+	zone->histogram[bucket]++;
+	critical_section_exit();
+
+#if defined(SUPPORT_DEBUG_UART_ITM) && defined(PROFILE_ITM_SAMPLES)
+	// Stream the sample: the zone is identified by the address of its descriptor
+	uint32_t sample[2] = { (uint32_t)(uintptr_t)zone, cycles };
+	polymcu_itm_write(POLYMCU_ITM_PORT_PROFILE, sample, sizeof(sample));
+#endif
+}
+
+// newlib-nano printf does not support 64-bit integers
+static const char* profile_u64_to_str(uint64_t value, char* str, size_t size) {
+	char* ptr = str + size - 1;
+
+	*ptr = '\0';
+	do {
+		*--ptr = '0' + (value % 10);
+		value /= 10;
+	} while ((value != 0) && (ptr != str));
+
+	return ptr;
+}
+
+void polymcu_profile_dump(void) {
+	polymcu_profile_zone_t* zone;
+	polymcu_profile_zone_t copy;
+	char total_str[21];
+	unsigned int i;
+
+	printf("Profile (cycles at %u Hz)\n", (unsigned int)SystemCoreClock);
+	printf("%-20s %10s %10s %10s %10s %20s\n", "zone", "count", "min", "max", "avg", "total");
+
+	for (zone = g_profile_zones; zone != NULL; zone = zone->next) {
+		// Take a consistent snapshot of the zone
+		critical_section_enter();
+		memcpy(&copy, zone, sizeof(copy));
+		critical_section_exit();
+
+		if (copy.count == 0) {
+			printf("%-20s %10u\n", copy.name, 0U);
+			continue;
+		}
+
+		printf("%-20s %10u %10u %10u %10u %20s\n", copy.name,
+				(unsigned int)copy.count, (unsigned int)copy.min, (unsigned int)copy.max,
+				(unsigned int)(copy.total / copy.count),
+				profile_u64_to_str(copy.total, total_str, sizeof(total_str)));
+
+		for (i = 0; i < POLYMCU_PROFILE_HISTOGRAM_SIZE; i++) {
+			if (copy.histogram[i]) {
+				printf("  [2^%u, 2^%u) %10u\n", i, i + 1, (unsigned int)copy.histogram[i]);
+			}
+		}
+	}
+}
+
+void polymcu_profile_reset(void) {
+	polymcu_profile_zone_t* zone;
+
+	for (zone = g_profile_zones; zone != NULL; zone = zone->next) {
+		critical_section_enter();
+		zone->count = 0;
+		zone->min   = UINT32_MAX;
+		zone->max   = 0;
+		zone->total = 0;
+		memset(zone->histogram, 0, sizeof(zone->histogram));
+		critical_section_exit();
+	}
+}
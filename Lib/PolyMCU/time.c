@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PolyMCU.h"
+
+#ifdef POLYMCU_HOST
+  #include <time.h>
+#endif
+
+#ifdef POLYMCU_HOST
+// The host clock is already 64-bit
+#elif defined(POLYMCU_HAS_CYCLE_COUNTER)
+// Number of half-periods of the DWT cycle counter. Its LSB is the expected MSB of the counter
+static volatile uint32_t g_time_epoch;
+#elif defined(SUPPORT_TIMER)
+// Number of half-periods of the PolyMCU tick counter
+static volatile uint32_t g_time_epoch;
+#endif
+
+#if !defined(POLYMCU_HOST) && (defined(POLYMCU_HAS_CYCLE_COUNTER) || defined(SUPPORT_TIMER))
+/*
+ * Extend a 32-bit counter to 64-bit without masking the interrupts.
+ * `epoch` must be read before `low`. The epoch is only updated when the counter has
+ * crossed a half-period. It means the counter must be read at least every 2^31 counts.
+ */
+static uint64_t time_extend(uint32_t epoch, uint32_t low) {
+	if ((low >> 31) != (epoch & 1)) {
+		uint32_t new_epoch = epoch + 1;
+
+#ifdef POLYMCU_USE_EXCLUSIVE_ACCESS
+		// If the update fails, another context has already updated the epoch
+		if (__LDREXW(&g_time_epoch) == epoch) {
+			__STREXW(new_epoch, &g_time_epoch);
+		} else {
+			__CLREX();
+		}
+#else
+		critical_section_enter();
+		if (g_time_epoch == epoch) {
+			g_time_epoch = new_epoch;
+		}
+		critical_section_exit();
+#endif
+		epoch = new_epoch;
+	}
+
+	return ((uint64_t)(epoch >> 1) << 32) | low;
+}
+#endif
+
+#ifdef POLYMCU_HOST
+uint64_t polymcu_time_cycles(void) {
+	static uint64_t start_ns;
+	struct timespec now;
+	uint64_t now_ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	now_ns = ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+	if (start_ns == 0) {
+		start_ns = now_ns;
+	}
+
+	return ((now_ns - start_ns) * (SystemCoreClock / 1000000)) / 1000;
+}
+#elif defined(POLYMCU_HAS_CYCLE_COUNTER)
+static void time_cycle_counter_init(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if (__CORTEX_M == 7)
+	// Unlock the DWT registers
+	DWT->LAR = 0xC5ACCE55;
+#endif
+	// The cycle counter is optional
+	assert((DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk) == 0);
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint64_t polymcu_time_cycles(void) {
+	uint32_t epoch;
+
+	if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0) {
+		time_cycle_counter_init();
+	}
+
+	epoch = g_time_epoch;
+	return time_extend(epoch, DWT->CYCCNT);
+}
+#elif defined(SUPPORT_TIMER)
+uint64_t polymcu_time_cycles(void) {
+	uint32_t epoch, tick;
+
+#if defined(SUPPORT_TIMER_SYSTICK) && !defined(SUPPORT_TIMER_TICKLESS)
+	uint32_t cycles_per_tick = SysTick->LOAD + 1UL;
+	uint32_t value;
+
+	// Combine the tick counter with the current SysTick value. Read them again
+	// if the tick interrupt has been serviced in the meantime
+	do {
+		epoch = g_time_epoch;
+		tick  = polymcu_timer_get_value();
+		value = SysTick->VAL;
+		if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+			// The tick interrupt is pending (the interrupts might be masked).
+			// The counter has been reloaded
+			value = SysTick->VAL;
+			tick++;
+			break;
+		}
+	} while (tick != polymcu_timer_get_value());
+
+	return (time_extend(epoch, tick) * cycles_per_tick) + (cycles_per_tick - 1UL - value);
+#else
+	// The resolution is limited to the PolyMCU tick
+	epoch = g_time_epoch;
+	tick  = polymcu_timer_get_value();
+	return time_extend(epoch, tick) * (SystemCoreClock / polymcu_timer_get_period());
+#endif
+}
+#else
+uint64_t polymcu_time_cycles(void) {
+	// Neither a cycle counter nor the PolyMCU timer are available
+	DEBUG_NOT_SUPPORTED();
+	return 0;
+}
+#endif
+
+void polymcu_time_update(void) {
+	(void)polymcu_time_cycles();
+}
+
+uint64_t polymcu_time_us(void) {
+	return polymcu_time_cycles() / (SystemCoreClock / 1000000);
+}
+
+void polymcu_delay_us(unsigned int delay) {
+	uint32_t cycles_per_us = SystemCoreClock / 1000000;
+	uint64_t end = polymcu_time_cycles() + ((uint64_t)delay * cycles_per_us);
+
+#ifdef SUPPORT_TIMER
+	// Sleep on the PolyMCU timer for the whole ticks. The current tick has already
+	// partially elapsed so we wait one tick less than the delay
+	unsigned int tick_us = 1000000 / polymcu_timer_get_period();
+	if (delay >= 2 * tick_us) {
+		polymcu_wait((delay / tick_us) - 1);
+	}
+#endif
+
+	// Busy-wait for the remainder
+	while (polymcu_time_cycles() < end);
+}
@@ -32,49 +32,230 @@
 #define POLYMCU_TIMER_ONE_TIME	(1 << 2)
 
 struct polymcu_timer_task {
+	struct polymcu_timer_task* next; // Next task in the deadline-ordered list (or in the free list)
 	unsigned int              attributes;
 	polymcu_timer_task_func_t function;
 	void*                     arg;
 	unsigned int              delta;
 	unsigned int              next_tick;
+	unsigned int              slack;     // Ticks the expiration can be delayed to be batched with others
 };
 
 static struct polymcu_timer_task g_polymcu_timer_tasks[TIMER_TASK_MAX];
+// List of the free timer tasks
+static polymcu_timer_task_t g_timer_free_tasks;
+static uint32_t g_timer_free_tasks_initialized;
+// List of the started timer tasks ordered by deadline
+static polymcu_timer_task_t g_timer_scheduled_tasks;
 static uint32_t g_counter;
 // Keep track of how many instance are using the timer
 static uint32_t g_timer_user = 0;
+static polymcu_timer_stats_t g_timer_stats;
+static unsigned int g_timer_stats_start;
+
+#ifdef SUPPORT_TIMER_TICKLESS
+// Ticks elapsed since the HW timer has been programmed that have already been
+// added to 'g_counter'
+static unsigned int g_timer_hw_accounted;
+#endif
+
+/*
+ * The tick counter wraps around. The deadlines are compared relatively to the
+ * current tick. It means a deadline cannot be more than INT_MAX ticks away.
+ */
+static inline int timer_tick_is_reached(unsigned int tick, unsigned int deadline) {
+	return (int)(tick - deadline) >= 0;
+}
+
+// Return the number of ticks until `deadline` (0 if it has already been reached)
+static inline unsigned int timer_get_delay(unsigned int deadline) {
+	int delay = (int)(deadline - g_counter);
+	return (delay > 0) ? delay : 0;
+}
+
+// Must be called with the critical section held
+static void timer_insert_task(polymcu_timer_task_t task) {
+	polymcu_timer_task_t* prev = &g_timer_scheduled_tasks;
+	unsigned int delay = timer_get_delay(task->next_tick);
+
+	// Tasks with the same deadline are kept in the order they have been inserted
+	while ((*prev != NULL) && (timer_get_delay((*prev)->next_tick) <= delay)) {
+		prev = &(*prev)->next;
+	}
+	task->next = *prev;
+	*prev = task;
+}
+
+// Must be called with the critical section held
+static void timer_remove_task(polymcu_timer_task_t task) {
+	polymcu_timer_task_t* prev = &g_timer_scheduled_tasks;
+
+	while (*prev != NULL) {
+		if (*prev == task) {
+			*prev = task->next;
+			task->next = NULL;
+			return;
+		}
+		prev = &(*prev)->next;
+	}
+}
+
+/*
+ * Return the tick at which the tasks at the head of the list must be expired: the earliest
+ * deadline plus slack of the tasks that would be expired at this tick. All the tasks whose
+ * deadline has been reached at this tick are expired together.
+ * Must be called with the critical section held and a non-empty list.
+ */
+static unsigned int timer_get_batch_tick(void) {
+	polymcu_timer_task_t task = g_timer_scheduled_tasks;
+	unsigned int batch_tick = task->next_tick + task->slack;
+
+	for (task = task->next; task != NULL; task = task->next) {
+		// The list is ordered by deadline
+		if (!timer_tick_is_reached(batch_tick, task->next_tick)) {
+			break;
+		}
+		if (timer_get_delay(task->next_tick + task->slack) < timer_get_delay(batch_tick)) {
+			batch_tick = task->next_tick + task->slack;
+		}
+	}
+	return batch_tick;
+}
+
+#ifdef SUPPORT_TIMER_TICKLESS
+// Account the ticks elapsed since the HW timer has been programmed. Must be
+// called with the critical section held
+static void timer_hw_update_counter(void) {
+	unsigned int elapsed = polymcu_timer_hw_get_elapsed();
+
+	g_counter += elapsed - g_timer_hw_accounted;
+	g_timer_hw_accounted = elapsed;
+}
+
+// Program the HW timer for the next deadline. Must be called with the critical section held
+static void timer_hw_program(void) {
+	unsigned int ticks;
+
+	// The delay is counted from the current tick: account the elapsed ticks first
+	timer_hw_update_counter();
+	if (g_timer_scheduled_tasks == NULL) {
+		// No deadline, the HW timer only needs to keep the tick counter up to date
+		ticks = UINT_MAX;
+	} else {
+		ticks = timer_get_delay(timer_get_batch_tick());
+		if (ticks == 0) {
+			ticks = 1;
+		}
+	}
+
+	polymcu_timer_hw_set_next(g_timer_hw_accounted, ticks);
+	g_timer_hw_accounted = 0;
+}
+
+// Boards override them to enter a deeper low power mode than WFI allows by default
+__attribute__((weak)) void polymcu_timer_hw_pre_sleep(unsigned int ticks) {
+}
+
+__attribute__((weak)) void polymcu_timer_hw_post_sleep(unsigned int ticks) {
+}
+#endif
+
+static void timer_user_add(void) {
+	// If we are the first task then resume the HW timer
+	if (++g_timer_user == 1) {
+		polymcu_timer_hw_start();
+#ifdef SUPPORT_TIMER_TICKLESS
+		g_timer_hw_accounted = 0;
+		timer_hw_program();
+#endif
+	}
+}
+
+static void timer_user_remove(void) {
+	// If we were the last instance to use the timer then we should stop it
+	// to save power
+	if (--g_timer_user == 0) {
+#ifdef SUPPORT_TIMER_TICKLESS
+		timer_hw_update_counter();
+#endif
+		polymcu_timer_hw_stop();
+	}
+}
 
 void polymcu_timer_irq_handler(void) {
-	unsigned int tick;
+	polymcu_timer_task_t task;
+	int expire = 0;
 
+	critical_section_enter();
+
+#ifdef SUPPORT_TIMER_TICKLESS
+	timer_hw_update_counter();
+#else
 	g_counter++;
+#endif
+
+	g_timer_stats.wakeups++;
+
+	// The tasks with some slack wait for the batch tick to be expired with the others
+	if ((g_timer_scheduled_tasks != NULL) && timer_tick_is_reached(g_counter, timer_get_batch_tick())) {
+		g_timer_stats.batches++;
+		expire = 1;
+	}
 
-	tick = polymcu_timer_get_value() + 1;
-
-	for (int i = 0; i < TIMER_TASK_MAX; i++) {
-		if ((g_polymcu_timer_tasks[i].function != NULL) &&
-			(g_polymcu_timer_tasks[i].attributes & POLYMCU_TIMER_STARTED) &&
-			(tick > g_polymcu_timer_tasks[i].next_tick))
-		{
-			g_polymcu_timer_tasks[i].function(g_polymcu_timer_tasks[i].arg);
-
-			// Update task state
-			if (g_polymcu_timer_tasks[i].attributes & POLYMCU_TIMER_ONE_TIME) {
-				g_polymcu_timer_tasks[i].attributes &= ~POLYMCU_TIMER_STARTED;
-			} else if (g_polymcu_timer_tasks[i].attributes & POLYMCU_TIMER_PERIODIC) {
-				g_polymcu_timer_tasks[i].next_tick += g_polymcu_timer_tasks[i].delta;
-			}
+	// Only the head of the list needs to be checked as long as no task has expired
+	while (expire && (g_timer_scheduled_tasks != NULL) &&
+		   timer_tick_is_reached(g_counter, g_timer_scheduled_tasks->next_tick))
+	{
+		task = g_timer_scheduled_tasks;
+		g_timer_scheduled_tasks = task->next;
+		g_timer_stats.expirations++;
+
+		// Update task state before calling the function so it can restart or stop itself
+		if (task->attributes & POLYMCU_TIMER_ONE_TIME) {
+			task->attributes &= ~POLYMCU_TIMER_STARTED;
+			timer_user_remove();
+		} else if (task->attributes & POLYMCU_TIMER_PERIODIC) {
+			task->next_tick += task->delta;
+			timer_insert_task(task);
 		}
+
+		critical_section_exit();
+		task->function(task->arg);
+		critical_section_enter();
+	}
+
+#ifdef SUPPORT_TIMER_TICKLESS
+	if (g_timer_user > 0) {
+		timer_hw_program();
 	}
+#endif
+
+	critical_section_exit();
+
+	// Keep the 64-bit time up to date
+	polymcu_time_update();
 }
 
 static polymcu_timer_task_t get_free_timer_task(void) {
-	for (int i = 0; i < TIMER_TASK_MAX; i++) {
-		if (g_polymcu_timer_tasks[i].function == NULL) {
-			return &g_polymcu_timer_tasks[i];
+	polymcu_timer_task_t task;
+
+	critical_section_enter();
+	if (!g_timer_free_tasks_initialized) {
+		for (int i = 0; i < TIMER_TASK_MAX; i++) {
+			g_polymcu_timer_tasks[i].next = g_timer_free_tasks;
+			g_timer_free_tasks = &g_polymcu_timer_tasks[i];
 		}
+		g_timer_free_tasks_initialized = 1;
 	}
-	return NULL;
+
+	task = g_timer_free_tasks;
+	if (task != NULL) {
+		g_timer_free_tasks = task->next;
+		task->next = NULL;
+	}
+	critical_section_exit();
+
+	return task;
 }
 
 polymcu_timer_task_t polymcu_timer_create_periodic_task(polymcu_timer_task_func_t function, unsigned int period, void* arg) {
@@ -86,7 +267,9 @@ polymcu_timer_task_t polymcu_timer_create_periodic_task(polymcu_timer_task_func_
 	task->attributes = POLYMCU_TIMER_PERIODIC;
 	task->function   = function;
 	task->arg        = arg;
-	task->delta      = period;
+	task->slack      = 0;
+	// A periodic task cannot expire more than once per tick
+	task->delta      = (period > 0) ? period : 1;
 
 	return task;
 }
@@ -100,40 +283,65 @@ polymcu_timer_task_t polymcu_timer_create_one_time_task(polymcu_timer_task_func_
 	task->attributes = POLYMCU_TIMER_ONE_TIME;
 	task->function   = function;
 	task->arg        = arg;
+	task->slack      = 0;
 	task->delta      = delay;
 
 	return task;
 }
 
 void polymcu_timer_remove_task(polymcu_timer_task_t task) {
-	if (!task) return;
+	if (!task || !task->function) return;
+
+	polymcu_timer_stop_task(task);
 
+	critical_section_enter();
 	task->function = NULL;
+	task->next = g_timer_free_tasks;
+	g_timer_free_tasks = task;
+	critical_section_exit();
 }
 
 int polymcu_timer_start_task(polymcu_timer_task_t task) {
 	if (!task) return 1;
 
-	task->attributes |= POLYMCU_TIMER_STARTED;
-	task->next_tick   = polymcu_timer_get_value() + task->delta;
+	critical_section_enter();
 
-	// If we are the first task then resume Systick
-	if (++g_timer_user == 1) {
-		polymcu_timer_hw_start();
+#ifdef SUPPORT_TIMER_TICKLESS
+	// The deadline is relative to the current tick
+	if (g_timer_user > 0) {
+		timer_hw_update_counter();
+	}
+#endif
+
+	if (task->attributes & POLYMCU_TIMER_STARTED) {
+		// Restarting a task reschedules it
+		timer_remove_task(task);
+	} else {
+		task->attributes |= POLYMCU_TIMER_STARTED;
+		timer_user_add();
 	}
+	task->next_tick = g_counter + task->delta;
+	timer_insert_task(task);
+
+#ifdef SUPPORT_TIMER_TICKLESS
+	// The task might be the next deadline
+	timer_hw_program();
+#endif
+
+	critical_section_exit();
 	return 0;
 }
 
 int polymcu_timer_stop_task(polymcu_timer_task_t task) {
 	if (!task) return 1;
 
-	task->attributes &= ~POLYMCU_TIMER_STARTED;
-
-	// If we were the last instance to use the timer then we should stop it
-	// to save power
-	if (--g_timer_user == 0) {
-		polymcu_timer_hw_stop();
+	critical_section_enter();
+	if (task->attributes & POLYMCU_TIMER_STARTED) {
+		task->attributes &= ~POLYMCU_TIMER_STARTED;
+		timer_remove_task(task);
+		timer_user_remove();
 	}
+	critical_section_exit();
 	return 0;
 }
 
@@ -143,46 +351,78 @@ int polymcu_timer_task_is_scheduled(polymcu_timer_task_t task) {
 	return (task->attributes & POLYMCU_TIMER_STARTED);
 }
 
-void polymcu_wait(unsigned int delay) {
-	unsigned int current_value, wait_until;
+int polymcu_timer_set_task_slack(polymcu_timer_task_t task, unsigned int slack) {
+	if (!task) return 1;
 
-	// If we are the first task then resume Systick
-	if (++g_timer_user == 1) {
-		polymcu_timer_hw_start();
+	// A periodic task cannot be delayed to its next period
+	if ((task->attributes & POLYMCU_TIMER_PERIODIC) && (slack >= task->delta)) {
+		slack = task->delta - 1;
 	}
 
-	current_value = polymcu_timer_get_value();
-
-	// Check overflow
-	if (current_value > UINT_MAX - delay) {
-		// Overflow case
-		wait_until = delay - (UINT_MAX - current_value);
+	critical_section_enter();
+	task->slack = slack;
+#ifdef SUPPORT_TIMER_TICKLESS
+	// The batch tick might have changed
+	if (task->attributes & POLYMCU_TIMER_STARTED) {
+		timer_hw_program();
+	}
+#endif
+	critical_section_exit();
+	return 0;
+}
 
-		// Wait for the counter to be restarted at 0
-		while (polymcu_timer_get_value() != 0) {
-			__WFI();
-		}
+void polymcu_timer_get_stats(polymcu_timer_stats_t* stats) {
+	critical_section_enter();
+	*stats = g_timer_stats;
+	stats->ticks = polymcu_timer_get_value() - g_timer_stats_start;
+	critical_section_exit();
+}
 
-		// Wait for the remaining 'delay'
-		while (polymcu_timer_get_value() < wait_until) {
-			__WFI();
-		}
-	} else {
-		// Non-Overflow case
-		wait_until = polymcu_timer_get_value() + delay;
+void polymcu_timer_reset_stats(void) {
+	critical_section_enter();
+	g_timer_stats.wakeups     = 0;
+	g_timer_stats.batches     = 0;
+	g_timer_stats.expirations = 0;
+	g_timer_stats_start = polymcu_timer_get_value();
+	critical_section_exit();
+}
 
-		while (polymcu_timer_get_value() < wait_until) {
-			__WFI();
-		}
-	}
+static void polymcu_wait_expired(void* arg) {
+	*(volatile int*)arg = 1;
+}
 
-	// If we were the last instance to use the timer then we should stop it
-	// to save power
-	if (--g_timer_user == 0) {
-		polymcu_timer_hw_stop();
+void polymcu_wait(unsigned int delay) {
+	volatile int expired = 0;
+	struct polymcu_timer_task task = {
+		.attributes = POLYMCU_TIMER_ONE_TIME,
+		.function   = polymcu_wait_expired,
+		.arg        = (void*)&expired,
+		.delta      = delay,
+		.slack      = 0,
+	};
+
+	// The task lives on the stack for the duration of the wait. It lets the
+	// timer sleep until the deadline in tickless mode
+	polymcu_timer_start_task(&task);
+
+	while (!expired) {
+		__WFI();
 	}
 }
 
 unsigned int polymcu_timer_get_value(void) {
+#ifdef SUPPORT_TIMER_TICKLESS
+	unsigned int value;
+
+	critical_section_enter();
+	value = g_counter;
+	if (g_timer_user > 0) {
+		// Ticks that have elapsed since the counter has been updated
+		value += polymcu_timer_hw_get_elapsed() - g_timer_hw_accounted;
+	}
+	critical_section_exit();
+	return value;
+#else
 	return g_counter;
+#endif
 }
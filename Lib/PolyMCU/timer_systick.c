@@ -26,23 +26,117 @@
 
 #include "PolyMCU.h"
 
+#ifdef SUPPORT_TIMER_TICKLESS
+// Minimum number of cycles to program the SysTick for
+#define SYSTICK_MIN_CYCLES	64
+
+// Number of SysTick cycles in one PolyMCU tick
+static uint32_t g_systick_tick_cycles;
+// Cycles of the current tick that have elapsed before the SysTick has been programmed
+static uint32_t g_systick_offset;
+// Set when the SysTick counter has reached zero since it has been programmed
+static uint32_t g_systick_wrapped;
+
+// Return the number of cycles since the SysTick has been programmed
+static uint32_t systick_get_elapsed_cycles(void) {
+	uint32_t load = SysTick->LOAD;
+	uint32_t value = SysTick->VAL;
+
+	// Reading 'CTRL' clears 'COUNTFLAG' so we need to remember it
+	if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+		g_systick_wrapped = 1;
+		// The counter might have been reloaded after we read it
+		value = SysTick->VAL;
+	}
+
+	if (g_systick_wrapped) {
+		return (load + 1) + (load - value);
+	} else if (value == 0) {
+		// The counter has just been cleared and has not been reloaded yet
+		return 0;
+	} else {
+		return load - value;
+	}
+}
+#endif
+
 void SysTick_Handler(void) {
 	polymcu_timer_irq_handler();
 }
 
 int polymcu_timer_init(unsigned int period) {
+#ifdef SUPPORT_TIMER_TICKLESS
+	g_systick_tick_cycles = SystemCoreClock / period;
+	if ((g_systick_tick_cycles - 1UL) > SysTick_LOAD_RELOAD_Msk) {
+		return 1;
+	}
+
+	SysTick->LOAD = g_systick_tick_cycles - 1UL;
+	SysTick->VAL  = 0UL;
+	NVIC_SetPriority(SysTick_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+	// The SysTick is only enabled when the first timer task is started
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+	return 0;
+#else
 	// Generate an interrupt every 'period'
 	return SysTick_Config(SystemCoreClock / period);
+#endif
 }
 
 unsigned int polymcu_timer_get_period(void) {
+#ifdef SUPPORT_TIMER_TICKLESS
+	return SystemCoreClock / g_systick_tick_cycles;
+#else
 	return SystemCoreClock / (SysTick->LOAD + 1UL);
+#endif
 }
 
 void polymcu_timer_hw_start(void) {
+#ifdef SUPPORT_TIMER_TICKLESS
+	SysTick->LOAD = g_systick_tick_cycles - 1UL;
+	SysTick->VAL  = 0UL;
+	g_systick_offset  = 0;
+	g_systick_wrapped = 0;
+#endif
 	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
 }
 
 void polymcu_timer_hw_stop(void) {
 	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
 }
+
+#ifdef SUPPORT_TIMER_TICKLESS
+unsigned int polymcu_timer_hw_get_elapsed(void) {
+	return (systick_get_elapsed_cycles() + g_systick_offset) / g_systick_tick_cycles;
+}
+
+unsigned int polymcu_timer_hw_set_next(unsigned int elapsed, unsigned int ticks) {
+	// The SysTick counter is only 24-bit long
+	uint32_t max_ticks = (SysTick_LOAD_RELOAD_Msk + 1UL) / g_systick_tick_cycles;
+	uint32_t cycles;
+
+	if (ticks > max_ticks) {
+		ticks = max_ticks;
+	}
+
+	// Keep the cycles that have not been accounted yet. The few cycles between
+	// reading the counter and clearing it are lost
+	g_systick_offset = systick_get_elapsed_cycles() + g_systick_offset - (elapsed * g_systick_tick_cycles);
+
+	cycles = ticks * g_systick_tick_cycles;
+	if (cycles > g_systick_offset + SYSTICK_MIN_CYCLES) {
+		cycles -= g_systick_offset;
+	} else {
+		// The deadline has already been reached
+		cycles = SYSTICK_MIN_CYCLES;
+	}
+
+	SysTick->LOAD = cycles - 1UL;
+	SysTick->VAL  = 0UL;
+	g_systick_wrapped = 0;
+	// Discard an expiration that might have happened in the meantime
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+
+	return ticks;
+}
+#endif
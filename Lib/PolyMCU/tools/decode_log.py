@@ -0,0 +1,217 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2017, Lab A Part
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# o Redistributions of source code must retain the above copyright notice, this
+# o list of conditions and the following disclaimer.
+#
+# o Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+"""Decode the PolyMCU binary log (SUPPORT_DEBUG_LOG_BINARY) using the firmware ELF."""
+
+from __future__ import print_function
+
+import argparse
+import re
+import struct
+import sys
+
+LOG_SECTION = '.polymcu_log'
+LOG_SYNC = 0xA5
+LOG_MAX_ARGS = 8
+# 'magic', 'size', 'head', 'tail', 'dropped' of the 'polymcu_log' structure
+LOG_RING_HEADER = struct.Struct('<12sIIII')
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+FORMAT_RE = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXcspfFeEgGaA%])')
+
+
+class Elf(object):
+    """Minimal little-endian ELF reader: only the section contents are needed."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF':
+            raise ValueError("'%s' is not an ELF file" % path)
+        if self.data[4:5] == b'\x01':
+            header, section = '<16xHHIIIIIHHHHHH', '<IIIIIIIIII'
+        else:
+            header, section = '<16xHHIQQQIHHHHHH', '<IIQQQQIIQQ'
+        fields = struct.unpack_from(header, self.data)
+        shoff, shentsize, shnum, shstrndx = fields[5], fields[10], fields[11], fields[12]
+
+        raw = [struct.unpack_from(section, self.data, shoff + i * shentsize) for i in range(shnum)]
+        names = raw[shstrndx]
+        self.sections = {}
+        self.loaded = []
+        for name, sh_type, flags, addr, offset, size in [s[:6] for s in raw]:
+            name = self._cstring(self.data, names[4] + name)
+            content = self.data[offset:offset + size] if sh_type != SHT_NOBITS else b''
+            self.sections[name] = (addr, content)
+            if (flags & SHF_ALLOC) and content:
+                self.loaded.append((addr, content))
+
+    @staticmethod
+    def _cstring(data, offset):
+        end = data.find(b'\0', offset)
+        return data[offset:end].decode('latin-1')
+
+    def format_string(self, identifier):
+        if LOG_SECTION not in self.sections:
+            raise ValueError("No '%s' section: is the firmware built with SUPPORT_DEBUG_LOG_BINARY?" % LOG_SECTION)
+        addr, content = self.sections[LOG_SECTION]
+        offset = identifier - addr
+        if offset < 0 or offset >= len(content) or (offset > 0 and content[offset - 1:offset] != b'\0'):
+            return None
+        return self._cstring(content, offset)
+
+    def string_at(self, address):
+        for addr, content in self.loaded:
+            if addr <= address < addr + len(content):
+                return self._cstring(content, address - addr)
+        return None
+
+
+def format_record(elf, fmt, args):
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    def convert(match):
+        flags, width, precision, _, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        if width == '*':
+            width = str(next_arg())
+        if precision == '*':
+            precision = str(next_arg())
+        spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+        value = next_arg()
+
+        if conversion in 'di':
+            return (spec + 'd') % (value - (1 << 32) if value & 0x80000000 else value)
+        elif conversion == 'u':
+            return (spec + 'd') % value
+        elif conversion in 'oxX':
+            return (spec + conversion) % value
+        elif conversion == 'c':
+            return (spec + 'c') % chr(value & 0xFF)
+        elif conversion == 's':
+            string = elf.string_at(value)
+            return (spec + 's') % (string if string is not None else '<0x%08x>' % value)
+        elif conversion == 'p':
+            return (spec + 's') % ('0x%08x' % value)
+        else:
+            # Floating point values have been converted to integer on the target
+            return (spec + conversion) % value
+
+    return FORMAT_RE.sub(convert, fmt)
+
+
+def decode(elf, data, output):
+    """Decode the records of 'data'. Return the bytes of the last incomplete record."""
+    position = 0
+    sequence = decode.sequence
+    while position + 8 <= len(data):
+        header, identifier = struct.unpack_from('<II', data, position)
+        nargs = (header >> 8) & 0xFF
+        fmt = elf.format_string(identifier) if (header & 0xFF) == LOG_SYNC and nargs <= LOG_MAX_ARGS else None
+        if fmt is None:
+            # Resynchronize on the next byte
+            position += 1
+            continue
+
+        size = 8 + nargs * 4
+        if position + size > len(data):
+            break
+        args = struct.unpack_from('<%dI' % nargs, data, position + 8)
+        position += size
+
+        record_sequence = header >> 16
+        if sequence is not None and record_sequence != sequence:
+            output.write('[%d log records dropped]\n' % ((record_sequence - sequence) & 0xFFFF))
+        sequence = (record_sequence + 1) & 0xFFFF
+
+        output.write(format_record(elf, fmt, args))
+        output.flush()
+
+    decode.sequence = sequence
+    return data[position:]
+
+decode.sequence = None
+
+
+def ring_content(dump):
+    """Extract the queued records from a memory dump of the 'polymcu_log' structure."""
+    magic, size, head, tail, dropped = LOG_RING_HEADER.unpack_from(dump)
+    if not magic.startswith(b'POLYMCU LOG'):
+        raise ValueError("The dump does not start with the 'polymcu_log' structure")
+    ring = dump[LOG_RING_HEADER.size:LOG_RING_HEADER.size + size]
+    start, count = tail % size, (head - tail) & 0xFFFFFFFF
+    if dropped:
+        sys.stderr.write('%d log records dropped by the target\n' % dropped)
+    return (ring[start:] + ring[:start])[:count]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('elf', help='Firmware ELF file')
+    parser.add_argument('input', nargs='?', default='-',
+                        help="Binary log: file, serial port (with --baudrate) or '-' for stdin")
+    parser.add_argument('--baudrate', type=int, help='Read the log from a serial port (requires pyserial)')
+    parser.add_argument('--ring', action='store_true',
+                        help="The input is a memory dump of the 'polymcu_log' structure (DEBUG_LOG_MEMORY)")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+
+    if args.ring:
+        with open(args.input, 'rb') as f:
+            decode(elf, ring_content(f.read()), sys.stdout)
+        return
+
+    if args.baudrate:
+        import serial
+        stream = serial.Serial(args.input, args.baudrate)
+        read = lambda: stream.read(max(1, stream.in_waiting))
+    elif args.input == '-':
+        stream = getattr(sys.stdin, 'buffer', sys.stdin)
+        read = lambda: stream.read(4096)
+    else:
+        stream = open(args.input, 'rb')
+        read = lambda: stream.read(4096)
+
+    pending = b''
+    try:
+        while True:
+            data = read()
+            if not data:
+                break
+            pending = decode(elf, pending + data, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -25,9 +25,12 @@
  */
 
 #include "Driver_USART.h"
+#include "PolyMCU.h"
 
 extern const ARM_DRIVER_USART Driver_UART_DEBUG;
 
+#ifndef SUPPORT_DEBUG_UART_BUFFERED
+
 /* Write one char "ch" to the default console */
 void _ttywrch(int ch) {
 	Driver_UART_DEBUG.Send(&ch, 1);
@@ -44,3 +47,316 @@ int _write(int fd, char *ptr, int len) {
 int _read(int fd, char *ptr, int len) {
 	return Driver_UART_DEBUG.Receive(ptr, len);
 }
+
+int polymcu_uart_write_raw(const void* data, int len) {
+	const char *ptr = data;
+	int ret;
+
+	// The drivers append '\r' to the transfers (of more than one byte) ending with '\n'
+	if ((len >= 2) && (ptr[len - 1] == '\n')) {
+		ret = Driver_UART_DEBUG.Send(ptr, len - 1);
+		if (ret < 0) {
+			return ret;
+		}
+		ret = Driver_UART_DEBUG.Send(ptr + len - 1, 1);
+		return (ret < 0) ? ret : len;
+	} else {
+		ret = Driver_UART_DEBUG.Send(ptr, len);
+		return (ret < 0) ? ret : len;
+	}
+}
+
+#else
+
+//
+// Buffered console
+//
+// The written characters are queued into a TX ring and handed to the driver by
+// contiguous chunks. With an interrupt-driven driver, the next chunk is started
+// from the ARM_USART_EVENT_SEND_COMPLETE event. With a blocking driver, the ring
+// is drained by the writer itself (but never from an interrupt).
+// '\n' are expanded into "\r\n" when queued.
+//
+
+#ifndef DEBUG_UART_TX_BUFFER_SIZE
+  #define DEBUG_UART_TX_BUFFER_SIZE    512
+#endif
+#ifndef DEBUG_UART_RX_BUFFER_SIZE
+  #define DEBUG_UART_RX_BUFFER_SIZE    64
+#endif
+
+#if (DEBUG_UART_TX_BUFFER_SIZE & (DEBUG_UART_TX_BUFFER_SIZE - 1)) != 0
+  #error "DEBUG_UART_TX_BUFFER_SIZE must be a power of two"
+#endif
+#if (DEBUG_UART_RX_BUFFER_SIZE & (DEBUG_UART_RX_BUFFER_SIZE - 1)) != 0
+  #error "DEBUG_UART_RX_BUFFER_SIZE must be a power of two"
+#endif
+
+#define UART_TX_MASK    (DEBUG_UART_TX_BUFFER_SIZE - 1)
+#define UART_RX_MASK    (DEBUG_UART_RX_BUFFER_SIZE - 1)
+
+// Head and tail are free running indexes
+static char g_uart_tx_buffer[DEBUG_UART_TX_BUFFER_SIZE];
+static volatile unsigned int g_uart_tx_head;     // Next byte to queue
+static volatile unsigned int g_uart_tx_tail;     // First byte not sent yet
+static volatile unsigned int g_uart_tx_pending;  // Size of the chunk owned by the driver
+static volatile unsigned int g_uart_tx_draining;
+static volatile unsigned int g_uart_tx_dropped;
+static volatile unsigned int g_uart_tx_async;    // The driver completes its transfers from interrupt
+static char g_uart_tx_last;
+
+#if DEBUG_UART_RX_BUFFER_SIZE > 0
+enum {
+	UART_RX_IDLE = 0,
+	UART_RX_ARMING,  // First Receive() in progress
+	UART_RX_ARMED,   // A one-byte Receive() is pending in the driver
+	UART_RX_DIRECT   // The driver is blocking, read directly from it
+};
+
+static char g_uart_rx_buffer[DEBUG_UART_RX_BUFFER_SIZE];
+static volatile unsigned int g_uart_rx_head;
+static volatile unsigned int g_uart_rx_tail;
+static volatile unsigned int g_uart_rx_dropped;
+static volatile unsigned int g_uart_rx_state;
+static char g_uart_rx_char;
+#endif
+
+static int uart_in_isr(void) {
+	return __get_IPSR() != 0;
+}
+
+// Waiting for the UART is only possible from a thread with the interrupts enabled
+static int uart_can_block(void) {
+#ifdef POLYMCU_HAS_BASEPRI
+	// BASEPRI is raised by the critical sections when CRITICAL_SECTION_PRIORITY is set
+	if (__get_BASEPRI() != 0) {
+		return 0;
+	}
+#endif
+	return (__get_IPSR() == 0) && (__get_PRIMASK() == 0);
+}
+
+// Must be called in critical section
+static void uart_tx_complete(void) {
+	g_uart_tx_tail += g_uart_tx_pending;
+	g_uart_tx_pending = 0;
+}
+
+// Hand the queued characters to the driver.
+// Unless 'force' is set, a blocking driver is not used from an interrupt as it would
+// stall it for the whole transfer.
+static void uart_tx_drain(int force) {
+	unsigned int tail, len;
+	int32_t ret;
+
+	critical_section_enter();
+	if (g_uart_tx_draining || g_uart_tx_pending || (!force && !g_uart_tx_async && uart_in_isr())) {
+		critical_section_exit();
+		return;
+	}
+
+	g_uart_tx_draining = 1;
+	while ((g_uart_tx_pending == 0) && (g_uart_tx_head != g_uart_tx_tail)) {
+		tail = g_uart_tx_tail & UART_TX_MASK;
+		len = g_uart_tx_head - g_uart_tx_tail;
+		if (len > DEBUG_UART_TX_BUFFER_SIZE - tail) {
+			len = DEBUG_UART_TX_BUFFER_SIZE - tail;
+		}
+		g_uart_tx_pending = len;
+		critical_section_exit();
+
+		ret = Driver_UART_DEBUG.Send(&g_uart_tx_buffer[tail], len);
+
+		critical_section_enter();
+		if (g_uart_tx_pending == 0) {
+			// Completion already signaled
+		} else if (ret == ARM_DRIVER_OK) {
+			// The completion will be signaled by the driver event
+			g_uart_tx_async = 1;
+		} else {
+			// Blocking driver returns the number of bytes sent
+			if (ret < 0) {
+				g_uart_tx_dropped += len;
+			}
+			uart_tx_complete();
+		}
+	}
+	g_uart_tx_draining = 0;
+	critical_section_exit();
+}
+
+// Queue as many characters as possible. Return the number of characters consumed.
+// When 'translate' is set, '\n' is expanded into "\r\n".
+static int uart_tx_queue(const char *ptr, int len, int translate) {
+	unsigned int needed;
+	int queued;
+	char ch;
+
+	critical_section_enter();
+	for (queued = 0; queued < len; queued++) {
+		ch = ptr[queued];
+		needed = (translate && (ch == '\n') && (g_uart_tx_last != '\r')) ? 2 : 1;
+		if (DEBUG_UART_TX_BUFFER_SIZE - (g_uart_tx_head - g_uart_tx_tail) < needed) {
+			break;
+		}
+		if (needed == 2) {
+			g_uart_tx_buffer[g_uart_tx_head++ & UART_TX_MASK] = '\r';
+		}
+		g_uart_tx_buffer[g_uart_tx_head++ & UART_TX_MASK] = ch;
+		g_uart_tx_last = ch;
+	}
+	critical_section_exit();
+
+	return queued;
+}
+
+#if DEBUG_UART_RX_BUFFER_SIZE > 0
+// Must be called in critical section
+static void uart_rx_push(char ch) {
+	if (g_uart_rx_head - g_uart_rx_tail < DEBUG_UART_RX_BUFFER_SIZE) {
+		g_uart_rx_buffer[g_uart_rx_head++ & UART_RX_MASK] = ch;
+	} else {
+		g_uart_rx_dropped++;
+	}
+}
+
+static void uart_rx_start(void) {
+	int32_t ret;
+
+	critical_section_enter();
+	if (g_uart_rx_state != UART_RX_IDLE) {
+		critical_section_exit();
+		return;
+	}
+	g_uart_rx_state = UART_RX_ARMING;
+	critical_section_exit();
+
+	ret = Driver_UART_DEBUG.Receive(&g_uart_rx_char, 1);
+
+	critical_section_enter();
+	if (g_uart_rx_state == UART_RX_ARMING) {
+		g_uart_rx_state = (ret == ARM_DRIVER_OK) ? UART_RX_ARMED : UART_RX_DIRECT;
+	}
+	critical_section_exit();
+}
+#endif
+
+void polymcu_uart_debug_event(uint32_t event) {
+	if (event & ARM_USART_EVENT_SEND_COMPLETE) {
+		critical_section_enter();
+		uart_tx_complete();
+		critical_section_exit();
+		uart_tx_drain(0);
+	}
+
+#if DEBUG_UART_RX_BUFFER_SIZE > 0
+	if (event & ARM_USART_EVENT_RECEIVE_COMPLETE) {
+		critical_section_enter();
+		if (g_uart_rx_state == UART_RX_ARMED) {
+			uart_rx_push(g_uart_rx_char);
+			critical_section_exit();
+			// Wait for the next character
+			if (Driver_UART_DEBUG.Receive(&g_uart_rx_char, 1) != ARM_DRIVER_OK) {
+				g_uart_rx_state = UART_RX_IDLE;
+			}
+		} else if (g_uart_rx_state == UART_RX_ARMING) {
+			// The driver has received the character before returning: it is blocking
+			uart_rx_push(g_uart_rx_char);
+			g_uart_rx_state = UART_RX_DIRECT;
+			critical_section_exit();
+		} else {
+			critical_section_exit();
+		}
+	}
+#endif
+}
+
+void polymcu_uart_flush(void) {
+	int in_isr = uart_in_isr();
+
+	while (g_uart_tx_head != g_uart_tx_tail) {
+		if (g_uart_tx_async ? !uart_can_block() : (in_isr && g_uart_tx_draining)) {
+			// The progress depends on a context we are preempting
+			return;
+		}
+		uart_tx_drain(1);
+	}
+}
+
+unsigned int polymcu_uart_get_dropped(void) {
+#if DEBUG_UART_RX_BUFFER_SIZE > 0
+	return g_uart_tx_dropped + g_uart_rx_dropped;
+#else
+	return g_uart_tx_dropped;
+#endif
+}
+
+/* Write "len" of char from "ptr" to file id "fd"
+ * Return number of char written. */
+int _write(int fd, char *ptr, int len) {
+	int written = uart_tx_queue(ptr, len, 1);
+
+#ifdef DEBUG_UART_TX_BLOCK
+	// Wait for the ring to have some room
+	while ((written < len) && uart_can_block()) {
+		uart_tx_drain(0);
+		written += uart_tx_queue(ptr + written, len - written, 1);
+	}
+#endif
+
+	if (written < len) {
+		critical_section_enter();
+		g_uart_tx_dropped += len - written;
+		critical_section_exit();
+	}
+
+	uart_tx_drain(0);
+
+	// The dropped characters are reported as written to not make newlib retry
+	return len;
+}
+
+int polymcu_uart_write_raw(const void* data, int len) {
+	int written = uart_tx_queue(data, len, 0);
+	uart_tx_drain(0);
+	return written;
+}
+
+/* Write one char "ch" to the default console */
+void _ttywrch(int ch) {
+	char c = ch;
+	_write(1, &c, 1);
+}
+
+/* Read "len" of char to "ptr" from file id "fd"
+ * Return number of char read. */
+int _read(int fd, char *ptr, int len) {
+#if DEBUG_UART_RX_BUFFER_SIZE > 0
+	int read = 0;
+
+	uart_rx_start();
+
+	if (g_uart_rx_state == UART_RX_DIRECT) {
+		if (g_uart_rx_head == g_uart_rx_tail) {
+			return Driver_UART_DEBUG.Receive(ptr, len);
+		}
+	} else {
+		// Wait for at least one character
+		while ((g_uart_rx_head == g_uart_rx_tail) && uart_can_block()) {
+			__WFI();
+		}
+	}
+
+	critical_section_enter();
+	while ((read < len) && (g_uart_rx_head != g_uart_rx_tail)) {
+		ptr[read++] = g_uart_rx_buffer[g_uart_rx_tail++ & UART_RX_MASK];
+	}
+	critical_section_exit();
+
+	return read;
+#else
+	return Driver_UART_DEBUG.Receive(ptr, len);
+#endif
+}
+
+#endif
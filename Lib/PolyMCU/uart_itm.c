@@ -24,30 +24,112 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef ARMCM3
-  #include <ARMCM3.h>
-#else
-  #error Device not supported
+#include <stdarg.h>
+#include <string.h>
+#include "board.h"
+#include "PolyMCU.h"
+
+#if !defined(__CORTEX_M) || (__CORTEX_M < 3)
+  #error The ITM is only available on ARM Cortex-M3/M4/M7
+#endif
+
+#ifndef ITM_PRINTF_BUFFER_SIZE
+  #define ITM_PRINTF_BUFFER_SIZE    128
 #endif
 
-//TODO: Review me
 volatile int32_t ITM_RxBuffer = ITM_RXBUFFER_EMPTY; // Initialize as EMPTY
 
+static volatile uint32_t g_itm_dropped;
+
+static int itm_port_enabled(unsigned int port) {
+	return (ITM->TCR & ITM_TCR_ITMENA_Msk) && (ITM->TER & (1UL << port));
+}
+
+// Reading a stimulus port returns 0 while its FIFO is full
+static int itm_port_ready(unsigned int port) {
+	return ITM->PORT[port].u32 != 0UL;
+}
+
+int polymcu_itm_write(unsigned int port, const void* data, int len) {
+	const uint8_t* ptr = data;
+	uint32_t word;
+	uint16_t half;
+	int written = 0;
+
+	// Nobody is listening: discard the data like 'ITM_SendChar()'
+	if ((port >= 32) || !itm_port_enabled(port)) {
+		return len;
+	}
+
+	// Use the widest stimulus writes: a 32-bit write is a single SWO packet
+	while (written < len) {
+		if (!itm_port_ready(port)) {
+			// Never spin on the FIFO: drop the remaining data
+			g_itm_dropped += len - written;
+			break;
+		}
+
+		if (len - written >= 4) {
+			memcpy(&word, ptr + written, 4);
+			ITM->PORT[port].u32 = word;
+			written += 4;
+		} else if (len - written >= 2) {
+			memcpy(&half, ptr + written, 2);
+			ITM->PORT[port].u16 = half;
+			written += 2;
+		} else {
+			ITM->PORT[port].u8 = ptr[written];
+			written += 1;
+		}
+	}
+
+	return written;
+}
+
+int polymcu_itm_printf(unsigned int port, const char* format, ...) {
+	char buffer[ITM_PRINTF_BUFFER_SIZE];
+	va_list args;
+	int len;
+
+	va_start(args, format);
+	len = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	if (len < 0) {
+		return len;
+	} else if (len >= (int)sizeof(buffer)) {
+		// The message has been truncated
+		g_itm_dropped += len - (sizeof(buffer) - 1);
+		len = sizeof(buffer) - 1;
+	}
+
+	return polymcu_itm_write(port, buffer, len);
+}
+
+unsigned int polymcu_itm_get_dropped(void) {
+	return g_itm_dropped;
+}
+
 /* Write one char "ch" to the default console */
 void _ttywrch(int ch) {
-	ITM_SendChar(ch);
+	char c = ch;
+	polymcu_itm_write(POLYMCU_ITM_PORT_STDOUT, &c, 1);
 }
 
 /* Write "len" of char from "ptr" to file id "fd"
  * Return number of char written. */
 int _write (int fd, char *ptr, int len)
 {
-	for (unsigned i = 0; i < len; i++) {
-		ITM_SendChar(ptr[i]);
-	}
+	polymcu_itm_write(POLYMCU_ITM_PORT_STDOUT, ptr, len);
+
+	// The dropped characters are reported as written to not make newlib retry
 	return len;
 }
 
+int polymcu_uart_write_raw(const void* data, int len) {
+	return polymcu_itm_write(POLYMCU_ITM_PORT_LOG, data, len);
+}
+
 /* Read "len" of char to "ptr" from file id "fd"
  * Return number of char read. */
 int _read (int fd, char *ptr, int len)
@@ -39,3 +39,7 @@ int _write(int fd, char *ptr, int len) {
 int _read(int fd, char *ptr, int len) {
 	return 0;
 }
+
+int polymcu_uart_write_raw(const void* data, int len) {
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * CMSIS-RTOS v1 API of the kernel renamed with the 'os1' prefix.
+ *
+ * The identifiers below are defined by both 'cmsis_os.h' and 'cmsis_os2.h' with a
+ * different meaning. When the CMSIS-RTOS2 layer is built on top of the CMSIS-RTOS v1
+ * layer of the kernel (RTX and RioT-OS), the v1 layer is compiled with this header
+ * forcibly included: its symbols do not collide with the CMSIS-RTOS2 ones.
+ * The CMSIS-RTOS2 ports include 'cmsis_os1_end.h' after 'cmsis_os.h' to get back the
+ * CMSIS-RTOS2 identifiers.
+ */
+
+#ifndef __CMSIS_OS1_H__
+#define __CMSIS_OS1_H__
+
+// Functions
+#define osKernelInitialize      os1KernelInitialize
+#define osKernelStart           os1KernelStart
+#define osKernelRunning         os1KernelRunning
+#define osThreadGetId           os1ThreadGetId
+#define osThreadTerminate       os1ThreadTerminate
+#define osThreadYield           os1ThreadYield
+#define osThreadSetPriority     os1ThreadSetPriority
+#define osThreadGetPriority     os1ThreadGetPriority
+#define osThreadGetCpuUsage     os1ThreadGetCpuUsage
+#define osDelay                 os1Delay
+#define osTimerStart            os1TimerStart
+#define osTimerStop             os1TimerStop
+#define osTimerDelete           os1TimerDelete
+#define osMutexRelease          os1MutexRelease
+#define osMutexDelete           os1MutexDelete
+#define osSemaphoreRelease      os1SemaphoreRelease
+#define osSemaphoreDelete       os1SemaphoreDelete
+
+// Status codes
+#define osOK                    os1OK
+#define osErrorParameter        os1ErrorParameter
+#define osErrorResource         os1ErrorResource
+#define osErrorISR              os1ErrorISR
+#define osErrorNoMemory         os1ErrorNoMemory
+
+// Priorities
+#define osPriorityIdle          os1PriorityIdle
+#define osPriorityLow           os1PriorityLow
+#define osPriorityBelowNormal   os1PriorityBelowNormal
+#define osPriorityNormal        os1PriorityNormal
+#define osPriorityAboveNormal   os1PriorityAboveNormal
+#define osPriorityHigh          os1PriorityHigh
+#define osPriorityRealtime      os1PriorityRealtime
+#define osPriorityError         os1PriorityError
+
+// Timer types
+#define osTimerOnce             os1TimerOnce
+#define osTimerPeriodic         os1TimerPeriodic
+
+#endif
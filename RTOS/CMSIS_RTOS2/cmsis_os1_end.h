@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Remove the 'os1' renaming of cmsis_os1.h once the CMSIS-RTOS v1 header of the kernel
+ * has been included. The v1 API is then only reachable through its 'os1' names.
+ */
+
+#ifdef __CMSIS_OS1_H__
+
+#undef osKernelInitialize
+#undef osKernelStart
+#undef osKernelRunning
+#undef osThreadGetId
+#undef osThreadTerminate
+#undef osThreadYield
+#undef osThreadSetPriority
+#undef osThreadGetPriority
+#undef osThreadGetCpuUsage
+#undef osDelay
+#undef osTimerStart
+#undef osTimerStop
+#undef osTimerDelete
+#undef osMutexRelease
+#undef osMutexDelete
+#undef osSemaphoreRelease
+#undef osSemaphoreDelete
+#undef osOK
+#undef osErrorParameter
+#undef osErrorResource
+#undef osErrorISR
+#undef osErrorNoMemory
+#undef osPriorityIdle
+#undef osPriorityLow
+#undef osPriorityBelowNormal
+#undef osPriorityNormal
+#undef osPriorityAboveNormal
+#undef osPriorityHigh
+#undef osPriorityRealtime
+#undef osPriorityError
+#undef osTimerOnce
+#undef osTimerPeriodic
+
+// Also defined by cmsis_os2.h
+#undef osWaitForever
+
+#endif
@@ -0,0 +1,1809 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Portable CMSIS-RTOS2 layer. The objects live in their own control blocks (allocated
+ * by the layer or provided by the caller) and are protected by the PolyMCU critical
+ * sections. The kernel only runs the threads: a thread waiting for an object is added
+ * to the priority ordered wait list of the object and blocked by the port (see os2_port.h).
+ * The resources (mutex ownership, semaphore tokens, memory blocks, messages) are handed
+ * over directly to the highest priority waiter: a message is copied once from the buffer
+ * of the sender to the queue slot or to the buffer of a waiting receiver.
+ *
+ * The threads are woken up once out of the critical section as some kernels (RTX) use
+ * a SVC to wake up a thread.
+ */
+
+#include <string.h>
+#include "os2_port.h"
+#include "PolyMCU.h"
+
+extern uint32_t SystemCoreClock;
+
+#define OS2_API_VERSION             20010000	// CMSIS-RTOS2 API 2.1.0
+
+// Object types (first field of the control blocks). Cleared when the object is deleted
+#define OS2_ID_INVALID              0x00
+#define OS2_ID_THREAD               0xF1
+#define OS2_ID_TIMER                0xF2
+#define OS2_ID_EVENT_FLAGS          0xF3
+#define OS2_ID_MUTEX                0xF4
+#define OS2_ID_SEMAPHORE            0xF5
+#define OS2_ID_MEMORY_POOL          0xF6
+#define OS2_ID_MESSAGE_QUEUE        0xF7
+
+// Control block flags
+#define OS2_FLAG_CB_ALLOCATED       (1 << 0)	// The control block has been allocated by the layer
+#define OS2_FLAG_MEM_ALLOCATED      (1 << 1)	// The data storage has been allocated by the layer
+
+// What a thread is blocked on
+#define OS2_WAIT_NONE               0
+#define OS2_WAIT_THREAD_FLAGS       1
+#define OS2_WAIT_EVENT_FLAGS        2
+#define OS2_WAIT_MUTEX              3
+#define OS2_WAIT_SEMAPHORE          4
+#define OS2_WAIT_MEMORY_POOL        5
+#define OS2_WAIT_MESSAGE_PUT        6
+#define OS2_WAIT_MESSAGE_GET        7
+
+// Thread flag used to wake up the timer thread when the first deadline changes
+#define OS2_TIMER_THREAD_FLAG       0x1U
+
+#define OS2_ALIGN4(size)            (((size) + 3U) & ~3U)
+
+#define os2_in_isr()                (__get_IPSR() != 0U)
+
+static osKernelState_t g_os2_kernel_state = osKernelInactive;
+
+// All the threads created by osThreadNew()
+static os2_thread_cb_t* g_os2_threads;
+
+// Running timers ordered by deadline and the thread that calls their function
+static os2_timer_cb_t* g_os2_timers;
+static os2_thread_cb_t* g_os2_timer_thread;
+
+//
+// Helpers
+//
+
+// Return the caller-provided control block or allocate it. NULL if the memory is invalid
+static void* os2_cb_new(void* cb_mem, uint32_t cb_size, size_t size) {
+	void* cb;
+
+	if (cb_mem != NULL) {
+		if ((cb_size < size) || (((uintptr_t)cb_mem & 3) != 0)) {
+			return NULL;
+		}
+		cb = cb_mem;
+		memset(cb, 0, size);
+	} else {
+		if (cb_size != 0) {
+			return NULL;
+		}
+		cb = os2_port_malloc(size);
+		if (cb == NULL) {
+			return NULL;
+		}
+		memset(cb, 0, size);
+		// 'flags' is the second byte of all the control blocks
+		((uint8_t*)cb)[1] = OS2_FLAG_CB_ALLOCATED;
+	}
+	return cb;
+}
+
+static void os2_cb_delete(void* cb) {
+	if (((uint8_t*)cb)[1] & OS2_FLAG_CB_ALLOCATED) {
+		os2_port_free(cb);
+	}
+}
+
+static inline os2_thread_cb_t* os2_thread(osThreadId_t thread_id) {
+	os2_thread_cb_t* thread = (os2_thread_cb_t*)thread_id;
+	return ((thread != NULL) && (thread->id == OS2_ID_THREAD)) ? thread : NULL;
+}
+
+static inline int os2_flags_match(uint32_t flags, uint32_t wait_flags, uint32_t options) {
+	if (options & osFlagsWaitAll) {
+		return (flags & wait_flags) == wait_flags;
+	} else {
+		return (flags & wait_flags) != 0;
+	}
+}
+
+//
+// Wait lists (in critical section)
+//
+
+// Insert the thread after the waiters of the same or higher priority
+static void os2_wait_list_add(os2_thread_cb_t** list, os2_thread_cb_t* thread) {
+	os2_thread_cb_t** link = list;
+
+	while ((*link != NULL) && ((*link)->priority >= thread->priority)) {
+		link = &(*link)->wait_next;
+	}
+	thread->wait_next = *link;
+	thread->wait_list = list;
+	*link = thread;
+}
+
+static void os2_wait_list_remove(os2_thread_cb_t* thread) {
+	os2_thread_cb_t** link = thread->wait_list;
+
+	if (link == NULL) {
+		return;
+	}
+	while (*link != thread) {
+		link = &(*link)->wait_next;
+	}
+	*link = thread->wait_next;
+	thread->wait_next = NULL;
+	thread->wait_list = NULL;
+}
+
+// Complete the wait of the thread. It is woken up by os2_wake_up() once out of the
+// critical section. Until the thread has consumed the wake up, the waker might still
+// reference it: the thread cannot be deleted by another thread (see os2_thread_release()).
+static void os2_wait_complete(os2_thread_cb_t* thread, osStatus_t status, os2_thread_cb_t** wake_list) {
+	os2_wait_list_remove(thread);
+	thread->wait_state = OS2_WAIT_NONE;
+	thread->wait_status = status;
+	thread->wake_pending = 1;
+	thread->wake_next = *wake_list;
+	*wake_list = thread;
+}
+
+// Complete the wait of all the waiters of a deleted object
+static void os2_wait_complete_all(os2_thread_cb_t** list, os2_thread_cb_t** wake_list) {
+	while (*list != NULL) {
+		os2_wait_complete(*list, osErrorResource, wake_list);
+	}
+}
+
+// Wake up the threads whose wait has been completed (out of the critical section)
+static void os2_wake_up(os2_thread_cb_t* wake_list) {
+	while (wake_list != NULL) {
+		// The thread might reuse 'wake_next' as soon as it is woken up
+		os2_thread_cb_t* next = wake_list->wake_next;
+		os2_port_thread_wake(wake_list);
+		wake_list = next;
+	}
+}
+
+// Block the calling thread on the wait list (NULL when waiting for its thread flags).
+// It must be called in a critical section that it leaves. `boost` is a thread whose
+// priority has been raised by the waiter (priority inheritance).
+static osStatus_t os2_wait(os2_thread_cb_t* self, uint8_t wait_state, os2_thread_cb_t** list,
+						   uint32_t timeout, os2_thread_cb_t* boost)
+{
+	int ret, terminated;
+
+	self->wait_state = wait_state;
+	self->wait_status = osErrorTimeout;
+	if (list != NULL) {
+		os2_wait_list_add(list, self);
+	}
+	critical_section_exit();
+
+	if (boost != NULL) {
+		os2_port_thread_set_priority(boost);
+	}
+
+	ret = os2_port_thread_block(self, timeout);
+
+	critical_section_enter();
+	if (self->wait_state != OS2_WAIT_NONE) {
+		// Nobody has completed the wait: it has timed out
+		os2_wait_list_remove(self);
+		self->wait_state = OS2_WAIT_NONE;
+		critical_section_exit();
+	} else {
+		critical_section_exit();
+		if (ret == OS2_PORT_TIMEOUT) {
+			// The wait has been completed while the thread was timing out. Consume the
+			// wake up on its way, it must not end the next wait.
+			os2_port_thread_block(self, osWaitForever);
+		}
+
+		// The waker does not reference the thread anymore
+		critical_section_enter();
+		self->wake_pending = 0;
+		terminated = (self->state == osThreadTerminated);
+		critical_section_exit();
+
+		if (terminated) {
+			// osThreadTerminate() has been called while the wake up was pending. It has
+			// left the deletion of the thread to the thread itself.
+			os2_cb_delete(self);
+			os2_port_thread_terminate(NULL);
+			for (;;);
+		}
+	}
+	return (osStatus_t)self->wait_status;
+}
+
+//
+// Priority inheritance (in critical section)
+//
+
+// Effective priority of the thread: its own priority or the priority of the highest
+// waiter of the priority inheritance mutexes it owns
+static int8_t os2_thread_priority(os2_thread_cb_t* thread) {
+	int8_t priority = thread->base_priority;
+	os2_mutex_cb_t* mutex;
+
+	for (mutex = thread->mutex_list; mutex != NULL; mutex = mutex->owner_next) {
+		if ((mutex->attr_bits & osMutexPrioInherit) && (mutex->waiters != NULL) &&
+			(mutex->waiters->priority > priority))
+		{
+			priority = mutex->waiters->priority;
+		}
+	}
+	return priority;
+}
+
+// Update the effective priority of the thread. Return 1 if the kernel priority must change
+static int os2_thread_update_priority(os2_thread_cb_t* thread) {
+	int8_t priority = os2_thread_priority(thread);
+
+	if (priority == thread->priority) {
+		return 0;
+	}
+	thread->priority = priority;
+
+	// Keep the wait list ordered
+	if (thread->wait_list != NULL) {
+		os2_thread_cb_t** list = thread->wait_list;
+		os2_wait_list_remove(thread);
+		os2_wait_list_add(list, thread);
+	}
+	return 1;
+}
+
+//  ==== Kernel Management Functions ====
+
+osStatus_t osKernelInitialize(void) {
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (g_os2_kernel_state == osKernelReady) {
+		return osOK;
+	} else if (g_os2_kernel_state != osKernelInactive) {
+		return osError;
+	}
+
+	if (os2_port_kernel_initialize() != 0) {
+		return osError;
+	}
+	g_os2_kernel_state = osKernelReady;
+	return osOK;
+}
+
+osStatus_t osKernelGetInfo(osVersion_t* version, char* id_buf, uint32_t id_size) {
+	if (version != NULL) {
+		version->api    = OS2_API_VERSION;
+		version->kernel = OS2_API_VERSION;
+	}
+	if ((id_buf != NULL) && (id_size != 0)) {
+		strncpy(id_buf, os2_port_kernel_get_name(), id_size - 1);
+		id_buf[id_size - 1] = '\0';
+	}
+	return osOK;
+}
+
+osKernelState_t osKernelGetState(void) {
+	return g_os2_kernel_state;
+}
+
+osStatus_t osKernelStart(void) {
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (g_os2_kernel_state != osKernelReady) {
+		return osError;
+	}
+
+	g_os2_kernel_state = osKernelRunning;
+	os2_port_kernel_start();
+
+	g_os2_kernel_state = osKernelError;
+	return osError;
+}
+
+uint32_t osKernelGetTickCount(void) {
+	return os2_port_kernel_get_tick();
+}
+
+uint32_t osKernelGetTickFreq(void) {
+	return os2_port_kernel_get_tick_freq();
+}
+
+uint32_t osKernelGetSysTimerCount(void) {
+	return (uint32_t)polymcu_time_cycles();
+}
+
+uint32_t osKernelGetSysTimerFreq(void) {
+	return SystemCoreClock;
+}
+
+//  ==== Thread Management Functions ====
+
+void os2_thread_entry(os2_thread_cb_t* thread) {
+	thread->func(thread->argument);
+	osThreadExit();
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void* argument, const osThreadAttr_t* attr) {
+	const osThreadAttr_t default_attr = { .priority = osPriorityNormal };
+	osPriority_t priority;
+	os2_thread_cb_t* thread;
+
+	if (os2_in_isr() || (func == NULL)) {
+		return NULL;
+	}
+	if (attr == NULL) {
+		attr = &default_attr;
+	}
+
+	priority = (attr->priority == osPriorityNone) ? osPriorityNormal : attr->priority;
+	if ((priority < osPriorityIdle) || (priority >= osPriorityISR)) {
+		return NULL;
+	}
+	// The threads cannot be joined
+	if (attr->attr_bits & osThreadJoinable) {
+		return NULL;
+	}
+	if ((attr->stack_mem != NULL) && ((((uintptr_t)attr->stack_mem & 7) != 0) || (attr->stack_size == 0))) {
+		return NULL;
+	}
+
+	thread = os2_cb_new(attr->cb_mem, attr->cb_size, sizeof(os2_thread_cb_t));
+	if (thread == NULL) {
+		return NULL;
+	}
+	thread->id            = OS2_ID_THREAD;
+	thread->state         = osThreadReady;
+	thread->name          = attr->name;
+	thread->func          = func;
+	thread->argument      = argument;
+	thread->base_priority = priority;
+	thread->priority      = priority;
+	thread->stack_mem     = attr->stack_mem;
+	thread->stack_size    = attr->stack_size;
+
+	critical_section_enter();
+	thread->next = g_os2_threads;
+	g_os2_threads = thread;
+	critical_section_exit();
+
+	if (os2_port_thread_create(thread) != 0) {
+		os2_thread_cb_t** link = &g_os2_threads;
+
+		critical_section_enter();
+		while (*link != thread) {
+			link = &(*link)->next;
+		}
+		*link = thread->next;
+		critical_section_exit();
+
+		thread->id = OS2_ID_INVALID;
+		os2_cb_delete(thread);
+		return NULL;
+	}
+	return thread;
+}
+
+const char* osThreadGetName(osThreadId_t thread_id) {
+	os2_thread_cb_t* thread = os2_thread(thread_id);
+	return (thread != NULL) ? thread->name : NULL;
+}
+
+osThreadId_t osThreadGetId(void) {
+	return os2_port_thread_self();
+}
+
+osThreadState_t osThreadGetState(osThreadId_t thread_id) {
+	os2_thread_cb_t* thread = os2_thread(thread_id);
+
+	if (thread == NULL) {
+		return osThreadError;
+	} else if (thread == os2_port_thread_self()) {
+		return osThreadRunning;
+	} else if (thread->wait_state != OS2_WAIT_NONE) {
+		return osThreadBlocked;
+	} else {
+		return (osThreadState_t)thread->state;
+	}
+}
+
+osStatus_t osThreadSetPriority(osThreadId_t thread_id, osPriority_t priority) {
+	os2_thread_cb_t* thread = os2_thread(thread_id);
+	int update;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if ((thread == NULL) || (priority < osPriorityIdle) || (priority >= osPriorityISR)) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	thread->base_priority = priority;
+	update = os2_thread_update_priority(thread);
+	critical_section_exit();
+
+	if (update) {
+		os2_port_thread_set_priority(thread);
+	}
+	return osOK;
+}
+
+osPriority_t osThreadGetPriority(osThreadId_t thread_id) {
+	os2_thread_cb_t* thread = os2_thread(thread_id);
+
+	if (os2_in_isr() || (thread == NULL)) {
+		return osPriorityError;
+	}
+	return (osPriority_t)thread->priority;
+}
+
+#ifdef SUPPORT_RTOS_CPU_USAGE
+osStatus_t osThreadGetCpuUsage(osThreadId_t thread_id, polymcu_cpu_usage_stats_t* stats) {
+	os2_thread_cb_t* thread = os2_thread(thread_id);
+
+	if ((thread_id != NULL) && (thread == NULL)) {
+		return osErrorParameter;
+	}
+	// The records are kept by the kernel for its native threads
+	if (polymcu_cpu_usage_get((thread != NULL) ? thread->port : NULL, stats) != 0) {
+		return osErrorResource;
+	}
+	return osOK;
+}
+#endif
+
+osStatus_t osThreadYield(void) {
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	os2_port_thread_yield();
+	return osOK;
+}
+
+static void os2_mutex_release_owned(os2_mutex_cb_t* mutex, os2_thread_cb_t** wake_list);
+
+// Remove the thread from the layer and delete it. It does not return when the thread
+// is the caller.
+static void os2_thread_release(os2_thread_cb_t* thread) {
+	os2_thread_cb_t* wake_list = NULL;
+	os2_thread_cb_t** link;
+	os2_mutex_cb_t* mutex;
+	int deferred;
+	void* port;
+
+	critical_section_enter();
+	os2_wait_list_remove(thread);
+	thread->wait_state = OS2_WAIT_NONE;
+	thread->state = osThreadTerminated;
+	thread->id = OS2_ID_INVALID;
+
+	for (link = &g_os2_threads; *link != NULL; link = &(*link)->next) {
+		if (*link == thread) {
+			*link = thread->next;
+			break;
+		}
+	}
+
+	// The robust mutexes are released. The others stay locked.
+	mutex = thread->mutex_list;
+	while (mutex != NULL) {
+		os2_mutex_cb_t* next = mutex->owner_next;
+		if (mutex->attr_bits & osMutexRobust) {
+			os2_mutex_release_owned(mutex, &wake_list);
+		} else {
+			mutex->owner = NULL;
+			mutex->owner_next = NULL;
+		}
+		mutex = next;
+	}
+	thread->mutex_list = NULL;
+
+	// A waker has captured the thread in its wake list and might not have woken it up
+	// yet: the thread deletes itself once woken up (see os2_wait()). The calling thread
+	// has always consumed its wake ups.
+	deferred = thread->wake_pending;
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+
+	if (!deferred) {
+		port = thread->port;
+		os2_cb_delete(thread);
+		os2_port_thread_terminate(port);
+	}
+}
+
+void osThreadExit(void) {
+	os2_thread_cb_t* self = os2_port_thread_self();
+
+	if (self != NULL) {
+		os2_thread_release(self);
+	} else {
+		// Not a CMSIS-RTOS2 thread
+		os2_port_thread_terminate(NULL);
+	}
+	for (;;);
+}
+
+osStatus_t osThreadTerminate(osThreadId_t thread_id) {
+	os2_thread_cb_t* thread = os2_thread(thread_id);
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (thread == NULL) {
+		return osErrorParameter;
+	}
+	if (thread == os2_port_thread_self()) {
+		osThreadExit();
+	}
+
+	os2_thread_release(thread);
+	return osOK;
+}
+
+uint32_t osThreadGetCount(void) {
+	os2_thread_cb_t* thread;
+	uint32_t count = 0;
+
+	if (os2_in_isr()) {
+		return 0;
+	}
+
+	critical_section_enter();
+	for (thread = g_os2_threads; thread != NULL; thread = thread->next) {
+		count++;
+	}
+	critical_section_exit();
+	return count;
+}
+
+//  ==== Thread Flags Functions ====
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags) {
+	os2_thread_cb_t* thread = os2_thread(thread_id);
+	os2_thread_cb_t* wake_list = NULL;
+	uint32_t ret;
+
+	if ((thread == NULL) || ((flags & osFlagsError) != 0)) {
+		return osFlagsErrorParameter;
+	}
+
+	critical_section_enter();
+	thread->thread_flags |= flags;
+	ret = thread->thread_flags;
+
+	if ((thread->wait_state == OS2_WAIT_THREAD_FLAGS) &&
+		os2_flags_match(thread->thread_flags, thread->wait_value, thread->wait_options))
+	{
+		uint32_t wait_flags = thread->wait_value;
+
+		thread->wait_value = thread->thread_flags;
+		if ((thread->wait_options & osFlagsNoClear) == 0) {
+			thread->thread_flags &= ~wait_flags;
+		}
+		os2_wait_complete(thread, osOK, &wake_list);
+	}
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	return ret;
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags) {
+	os2_thread_cb_t* self = os2_port_thread_self();
+	uint32_t ret;
+
+	if (os2_in_isr()) {
+		return osFlagsErrorISR;
+	}
+	if ((self == NULL) || ((flags & osFlagsError) != 0)) {
+		return osFlagsErrorParameter;
+	}
+
+	critical_section_enter();
+	ret = self->thread_flags;
+	self->thread_flags &= ~flags;
+	critical_section_exit();
+	return ret;
+}
+
+uint32_t osThreadFlagsGet(void) {
+	os2_thread_cb_t* self = os2_port_thread_self();
+
+	if (os2_in_isr() || (self == NULL)) {
+		return 0;
+	}
+	return self->thread_flags;
+}
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout) {
+	os2_thread_cb_t* self = os2_port_thread_self();
+	uint32_t ret;
+
+	if (os2_in_isr()) {
+		return osFlagsErrorISR;
+	}
+	if ((self == NULL) || (flags == 0) || ((flags & osFlagsError) != 0)) {
+		return osFlagsErrorParameter;
+	}
+
+	critical_section_enter();
+	if (os2_flags_match(self->thread_flags, flags, options)) {
+		ret = self->thread_flags;
+		if ((options & osFlagsNoClear) == 0) {
+			self->thread_flags &= ~flags;
+		}
+		critical_section_exit();
+		return ret;
+	}
+	if (timeout == 0) {
+		critical_section_exit();
+		return osFlagsErrorResource;
+	}
+
+	self->wait_value = flags;
+	self->wait_options = options;
+	if (os2_wait(self, OS2_WAIT_THREAD_FLAGS, NULL, timeout, NULL) != osOK) {
+		return osFlagsErrorTimeout;
+	}
+	return self->wait_value;
+}
+
+//  ==== Generic Wait Functions ====
+
+osStatus_t osDelay(uint32_t ticks) {
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (ticks != 0) {
+		os2_port_thread_delay(ticks);
+	}
+	return osOK;
+}
+
+osStatus_t osDelayUntil(uint32_t ticks) {
+	uint32_t delay;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+
+	delay = ticks - os2_port_kernel_get_tick();
+	if ((delay == 0) || (delay > 0x7FFFFFFFU)) {
+		return osErrorParameter;
+	}
+	os2_port_thread_delay(delay);
+	return osOK;
+}
+
+//  ==== Timer Management Functions ====
+
+static inline os2_timer_cb_t* os2_timer(osTimerId_t timer_id) {
+	os2_timer_cb_t* timer = (os2_timer_cb_t*)timer_id;
+	return ((timer != NULL) && (timer->id == OS2_ID_TIMER)) ? timer : NULL;
+}
+
+// Insert the timer in the list of the running timers (in critical section)
+static void os2_timer_insert(os2_timer_cb_t* timer, uint32_t now) {
+	os2_timer_cb_t** link = &g_os2_timers;
+
+	while ((*link != NULL) && ((int32_t)((*link)->deadline - now) <= (int32_t)(timer->deadline - now))) {
+		link = &(*link)->next;
+	}
+	timer->next = *link;
+	*link = timer;
+	timer->running = 1;
+}
+
+static void os2_timer_remove(os2_timer_cb_t* timer) {
+	os2_timer_cb_t** link = &g_os2_timers;
+
+	while ((*link != NULL) && (*link != timer)) {
+		link = &(*link)->next;
+	}
+	if (*link != NULL) {
+		*link = timer->next;
+	}
+	timer->next = NULL;
+	timer->running = 0;
+}
+
+// Call the functions of the expired timers and sleep until the next deadline
+static void os2_timer_thread(void* argument) {
+	(void)argument;
+
+	for (;;) {
+		uint32_t timeout = osWaitForever;
+		os2_timer_cb_t* timer;
+		uint32_t now;
+
+		critical_section_enter();
+		now = os2_port_kernel_get_tick();
+		timer = g_os2_timers;
+		if ((timer != NULL) && ((int32_t)(timer->deadline - now) <= 0)) {
+			osTimerFunc_t func = timer->func;
+			void* timer_argument = timer->argument;
+
+			os2_timer_remove(timer);
+			if (timer->type == osTimerPeriodic) {
+				timer->deadline += timer->period;
+				os2_timer_insert(timer, now);
+			}
+			critical_section_exit();
+
+			func(timer_argument);
+			continue;
+		}
+		if (timer != NULL) {
+			timeout = timer->deadline - now;
+		}
+		critical_section_exit();
+
+		osThreadFlagsWait(OS2_TIMER_THREAD_FLAG, osFlagsWaitAny, timeout);
+	}
+}
+
+osTimerId_t osTimerNew(osTimerFunc_t func, osTimerType_t type, void* argument, const osTimerAttr_t* attr) {
+	const osThreadAttr_t thread_attr = { .name = "timer", .priority = osPriorityHigh };
+	os2_timer_cb_t* timer;
+
+	if (os2_in_isr() || (func == NULL) || ((type != osTimerOnce) && (type != osTimerPeriodic))) {
+		return NULL;
+	}
+
+	// The timer thread is created with the first timer
+	if (g_os2_timer_thread == NULL) {
+		g_os2_timer_thread = osThreadNew(os2_timer_thread, NULL, &thread_attr);
+		if (g_os2_timer_thread == NULL) {
+			return NULL;
+		}
+	}
+
+	timer = os2_cb_new(attr ? attr->cb_mem : NULL, attr ? attr->cb_size : 0, sizeof(os2_timer_cb_t));
+	if (timer == NULL) {
+		return NULL;
+	}
+	timer->id       = OS2_ID_TIMER;
+	timer->type     = type;
+	timer->name     = attr ? attr->name : NULL;
+	timer->func     = func;
+	timer->argument = argument;
+	return timer;
+}
+
+const char* osTimerGetName(osTimerId_t timer_id) {
+	os2_timer_cb_t* timer = os2_timer(timer_id);
+	return (timer != NULL) ? timer->name : NULL;
+}
+
+osStatus_t osTimerStart(osTimerId_t timer_id, uint32_t ticks) {
+	os2_timer_cb_t* timer = os2_timer(timer_id);
+	uint32_t now;
+	int first;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if ((timer == NULL) || (ticks == 0) || (ticks > 0x7FFFFFFFU)) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (timer->running) {
+		os2_timer_remove(timer);
+	}
+	now = os2_port_kernel_get_tick();
+	timer->period = ticks;
+	timer->deadline = now + ticks;
+	os2_timer_insert(timer, now);
+	first = (g_os2_timers == timer);
+	critical_section_exit();
+
+	// The timer thread sleeps until the previous first deadline
+	if (first) {
+		osThreadFlagsSet(g_os2_timer_thread, OS2_TIMER_THREAD_FLAG);
+	}
+	return osOK;
+}
+
+osStatus_t osTimerStop(osTimerId_t timer_id) {
+	os2_timer_cb_t* timer = os2_timer(timer_id);
+	osStatus_t status = osOK;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (timer == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (timer->running) {
+		os2_timer_remove(timer);
+	} else {
+		status = osErrorResource;
+	}
+	critical_section_exit();
+	return status;
+}
+
+uint32_t osTimerIsRunning(osTimerId_t timer_id) {
+	os2_timer_cb_t* timer = os2_timer(timer_id);
+
+	if (os2_in_isr() || (timer == NULL)) {
+		return 0;
+	}
+	return timer->running;
+}
+
+osStatus_t osTimerDelete(osTimerId_t timer_id) {
+	os2_timer_cb_t* timer = os2_timer(timer_id);
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (timer == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (timer->running) {
+		os2_timer_remove(timer);
+	}
+	timer->id = OS2_ID_INVALID;
+	critical_section_exit();
+
+	os2_cb_delete(timer);
+	return osOK;
+}
+
+//  ==== Event Flags Management Functions ====
+
+static inline os2_event_flags_cb_t* os2_event_flags(osEventFlagsId_t ef_id) {
+	os2_event_flags_cb_t* ef = (os2_event_flags_cb_t*)ef_id;
+	return ((ef != NULL) && (ef->id == OS2_ID_EVENT_FLAGS)) ? ef : NULL;
+}
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t* attr) {
+	os2_event_flags_cb_t* ef;
+
+	if (os2_in_isr()) {
+		return NULL;
+	}
+
+	ef = os2_cb_new(attr ? attr->cb_mem : NULL, attr ? attr->cb_size : 0, sizeof(os2_event_flags_cb_t));
+	if (ef == NULL) {
+		return NULL;
+	}
+	ef->id   = OS2_ID_EVENT_FLAGS;
+	ef->name = attr ? attr->name : NULL;
+	return ef;
+}
+
+const char* osEventFlagsGetName(osEventFlagsId_t ef_id) {
+	os2_event_flags_cb_t* ef = os2_event_flags(ef_id);
+	return (ef != NULL) ? ef->name : NULL;
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags) {
+	os2_event_flags_cb_t* ef = os2_event_flags(ef_id);
+	os2_thread_cb_t* wake_list = NULL;
+	os2_thread_cb_t* thread;
+	uint32_t ret;
+
+	if ((ef == NULL) || ((flags & osFlagsError) != 0)) {
+		return osFlagsErrorParameter;
+	}
+
+	critical_section_enter();
+	ef->event_flags |= flags;
+	ret = ef->event_flags;
+
+	// Wake up the waiters in priority order. They might clear the flags they waited for
+	thread = ef->waiters;
+	while (thread != NULL) {
+		os2_thread_cb_t* next = thread->wait_next;
+
+		if (os2_flags_match(ef->event_flags, thread->wait_value, thread->wait_options)) {
+			uint32_t wait_flags = thread->wait_value;
+
+			thread->wait_value = ef->event_flags;
+			if ((thread->wait_options & osFlagsNoClear) == 0) {
+				ef->event_flags &= ~wait_flags;
+			}
+			os2_wait_complete(thread, osOK, &wake_list);
+		}
+		thread = next;
+	}
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	return ret;
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags) {
+	os2_event_flags_cb_t* ef = os2_event_flags(ef_id);
+	uint32_t ret;
+
+	if ((ef == NULL) || ((flags & osFlagsError) != 0)) {
+		return osFlagsErrorParameter;
+	}
+
+	critical_section_enter();
+	ret = ef->event_flags;
+	ef->event_flags &= ~flags;
+	critical_section_exit();
+	return ret;
+}
+
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id) {
+	os2_event_flags_cb_t* ef = os2_event_flags(ef_id);
+	return (ef != NULL) ? ef->event_flags : 0;
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout) {
+	os2_event_flags_cb_t* ef = os2_event_flags(ef_id);
+	os2_thread_cb_t* self;
+	uint32_t ret;
+
+	if ((ef == NULL) || (flags == 0) || ((flags & osFlagsError) != 0)) {
+		return osFlagsErrorParameter;
+	}
+
+	critical_section_enter();
+	if (os2_flags_match(ef->event_flags, flags, options)) {
+		ret = ef->event_flags;
+		if ((options & osFlagsNoClear) == 0) {
+			ef->event_flags &= ~flags;
+		}
+		critical_section_exit();
+		return ret;
+	}
+	if (timeout == 0) {
+		critical_section_exit();
+		return osFlagsErrorResource;
+	}
+
+	self = os2_port_thread_self();
+	if (os2_in_isr() || (self == NULL)) {
+		critical_section_exit();
+		return osFlagsErrorParameter;
+	}
+
+	self->wait_value = flags;
+	self->wait_options = options;
+	switch (os2_wait(self, OS2_WAIT_EVENT_FLAGS, &ef->waiters, timeout, NULL)) {
+	case osOK:
+		return self->wait_value;
+	case osErrorTimeout:
+		return osFlagsErrorTimeout;
+	default:
+		return osFlagsErrorResource;
+	}
+}
+
+osStatus_t osEventFlagsDelete(osEventFlagsId_t ef_id) {
+	os2_event_flags_cb_t* ef = os2_event_flags(ef_id);
+	os2_thread_cb_t* wake_list = NULL;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (ef == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	ef->id = OS2_ID_INVALID;
+	os2_wait_complete_all(&ef->waiters, &wake_list);
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	os2_cb_delete(ef);
+	return osOK;
+}
+
+//  ==== Mutex Management Functions ====
+
+static inline os2_mutex_cb_t* os2_mutex(osMutexId_t mutex_id) {
+	os2_mutex_cb_t* mutex = (os2_mutex_cb_t*)mutex_id;
+	return ((mutex != NULL) && (mutex->id == OS2_ID_MUTEX)) ? mutex : NULL;
+}
+
+static void os2_mutex_lock(os2_mutex_cb_t* mutex, os2_thread_cb_t* owner) {
+	mutex->owner = owner;
+	mutex->lock = 1;
+	mutex->owner_next = owner->mutex_list;
+	owner->mutex_list = mutex;
+}
+
+// Hand the mutex over to its highest priority waiter (in critical section)
+static void os2_mutex_release_owned(os2_mutex_cb_t* mutex, os2_thread_cb_t** wake_list) {
+	os2_thread_cb_t* owner = mutex->owner;
+	os2_thread_cb_t* waiter = mutex->waiters;
+
+	if (owner != NULL) {
+		os2_mutex_cb_t** link = &owner->mutex_list;
+		while (*link != mutex) {
+			link = &(*link)->owner_next;
+		}
+		*link = mutex->owner_next;
+	}
+	mutex->owner = NULL;
+	mutex->owner_next = NULL;
+	mutex->lock = 0;
+
+	if (waiter != NULL) {
+		os2_wait_complete(waiter, osOK, wake_list);
+		os2_mutex_lock(mutex, waiter);
+		// The new owner inherits the priority of the remaining waiters
+		os2_thread_update_priority(waiter);
+	}
+}
+
+osMutexId_t osMutexNew(const osMutexAttr_t* attr) {
+	os2_mutex_cb_t* mutex;
+
+	if (os2_in_isr()) {
+		return NULL;
+	}
+
+	mutex = os2_cb_new(attr ? attr->cb_mem : NULL, attr ? attr->cb_size : 0, sizeof(os2_mutex_cb_t));
+	if (mutex == NULL) {
+		return NULL;
+	}
+	mutex->id        = OS2_ID_MUTEX;
+	mutex->name      = attr ? attr->name : NULL;
+	mutex->attr_bits = attr ? attr->attr_bits : 0;
+	return mutex;
+}
+
+const char* osMutexGetName(osMutexId_t mutex_id) {
+	os2_mutex_cb_t* mutex = os2_mutex(mutex_id);
+	return (mutex != NULL) ? mutex->name : NULL;
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout) {
+	os2_mutex_cb_t* mutex = os2_mutex(mutex_id);
+	os2_thread_cb_t* self = os2_port_thread_self();
+	os2_thread_cb_t* boost = NULL;
+	os2_thread_cb_t* owner;
+	osStatus_t status;
+	int update = 0;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if ((mutex == NULL) || (self == NULL)) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (mutex->lock == 0) {
+		os2_mutex_lock(mutex, self);
+		critical_section_exit();
+		return osOK;
+	}
+	if (mutex->owner == self) {
+		if ((mutex->attr_bits & osMutexRecursive) && (mutex->lock != UINT32_MAX)) {
+			mutex->lock++;
+			status = osOK;
+		} else {
+			status = osErrorResource;
+		}
+		critical_section_exit();
+		return status;
+	}
+	if (timeout == 0) {
+		critical_section_exit();
+		return osErrorResource;
+	}
+
+	// The owner runs at the priority of its highest waiter
+	owner = mutex->owner;
+	if ((mutex->attr_bits & osMutexPrioInherit) && (owner != NULL) && (owner->priority < self->priority)) {
+		owner->priority = self->priority;
+		if (owner->wait_list != NULL) {
+			os2_thread_cb_t** list = owner->wait_list;
+			os2_wait_list_remove(owner);
+			os2_wait_list_add(list, owner);
+		}
+		boost = owner;
+	}
+
+	status = os2_wait(self, OS2_WAIT_MUTEX, &mutex->waiters, timeout, boost);
+	if (status == osErrorTimeout) {
+		// The owner does not inherit our priority anymore
+		critical_section_enter();
+		owner = mutex->owner;
+		if ((mutex->attr_bits & osMutexPrioInherit) && (owner != NULL)) {
+			update = os2_thread_update_priority(owner);
+		}
+		critical_section_exit();
+		if (update) {
+			os2_port_thread_set_priority(owner);
+		}
+	}
+	return status;
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id) {
+	os2_mutex_cb_t* mutex = os2_mutex(mutex_id);
+	os2_thread_cb_t* self = os2_port_thread_self();
+	os2_thread_cb_t* wake_list = NULL;
+	os2_thread_cb_t* new_owner;
+	int update;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if ((mutex == NULL) || (self == NULL)) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if ((mutex->lock == 0) || (mutex->owner != self)) {
+		critical_section_exit();
+		return osErrorResource;
+	}
+	if (--mutex->lock != 0) {
+		critical_section_exit();
+		return osOK;
+	}
+
+	os2_mutex_release_owned(mutex, &wake_list);
+	new_owner = mutex->owner;
+	// Drop the priority inherited from the waiters of the mutex
+	update = os2_thread_update_priority(self);
+	critical_section_exit();
+
+	if ((new_owner != NULL) && (new_owner->priority != new_owner->base_priority)) {
+		os2_port_thread_set_priority(new_owner);
+	}
+	os2_wake_up(wake_list);
+	if (update) {
+		os2_port_thread_set_priority(self);
+	}
+	return osOK;
+}
+
+osThreadId_t osMutexGetOwner(osMutexId_t mutex_id) {
+	os2_mutex_cb_t* mutex = os2_mutex(mutex_id);
+
+	if (os2_in_isr() || (mutex == NULL)) {
+		return NULL;
+	}
+	return mutex->owner;
+}
+
+osStatus_t osMutexDelete(osMutexId_t mutex_id) {
+	os2_mutex_cb_t* mutex = os2_mutex(mutex_id);
+	os2_thread_cb_t* wake_list = NULL;
+	os2_thread_cb_t* owner;
+	int update = 0;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (mutex == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	mutex->id = OS2_ID_INVALID;
+	os2_wait_complete_all(&mutex->waiters, &wake_list);
+	owner = mutex->owner;
+	if (owner != NULL) {
+		os2_mutex_cb_t** link = &owner->mutex_list;
+		while (*link != mutex) {
+			link = &(*link)->owner_next;
+		}
+		*link = mutex->owner_next;
+		update = os2_thread_update_priority(owner);
+	}
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	if (update) {
+		os2_port_thread_set_priority(owner);
+	}
+	os2_cb_delete(mutex);
+	return osOK;
+}
+
+//  ==== Semaphore Management Functions ====
+
+static inline os2_semaphore_cb_t* os2_semaphore(osSemaphoreId_t semaphore_id) {
+	os2_semaphore_cb_t* semaphore = (os2_semaphore_cb_t*)semaphore_id;
+	return ((semaphore != NULL) && (semaphore->id == OS2_ID_SEMAPHORE)) ? semaphore : NULL;
+}
+
+osSemaphoreId_t osSemaphoreNew(uint32_t max_count, uint32_t initial_count, const osSemaphoreAttr_t* attr) {
+	os2_semaphore_cb_t* semaphore;
+
+	if (os2_in_isr() || (max_count == 0) || (initial_count > max_count)) {
+		return NULL;
+	}
+
+	semaphore = os2_cb_new(attr ? attr->cb_mem : NULL, attr ? attr->cb_size : 0, sizeof(os2_semaphore_cb_t));
+	if (semaphore == NULL) {
+		return NULL;
+	}
+	semaphore->id         = OS2_ID_SEMAPHORE;
+	semaphore->name       = attr ? attr->name : NULL;
+	semaphore->tokens     = initial_count;
+	semaphore->max_tokens = max_count;
+	return semaphore;
+}
+
+const char* osSemaphoreGetName(osSemaphoreId_t semaphore_id) {
+	os2_semaphore_cb_t* semaphore = os2_semaphore(semaphore_id);
+	return (semaphore != NULL) ? semaphore->name : NULL;
+}
+
+osStatus_t osSemaphoreAcquire(osSemaphoreId_t semaphore_id, uint32_t timeout) {
+	os2_semaphore_cb_t* semaphore = os2_semaphore(semaphore_id);
+	os2_thread_cb_t* self;
+
+	if (semaphore == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (semaphore->tokens != 0) {
+		semaphore->tokens--;
+		critical_section_exit();
+		return osOK;
+	}
+	if (timeout == 0) {
+		critical_section_exit();
+		return osErrorResource;
+	}
+
+	self = os2_port_thread_self();
+	if (os2_in_isr() || (self == NULL)) {
+		critical_section_exit();
+		return osErrorParameter;
+	}
+	return os2_wait(self, OS2_WAIT_SEMAPHORE, &semaphore->waiters, timeout, NULL);
+}
+
+osStatus_t osSemaphoreRelease(osSemaphoreId_t semaphore_id) {
+	os2_semaphore_cb_t* semaphore = os2_semaphore(semaphore_id);
+	os2_thread_cb_t* wake_list = NULL;
+	osStatus_t status = osOK;
+
+	if (semaphore == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (semaphore->waiters != NULL) {
+		// The token goes straight to the waiter
+		os2_wait_complete(semaphore->waiters, osOK, &wake_list);
+	} else if (semaphore->tokens < semaphore->max_tokens) {
+		semaphore->tokens++;
+	} else {
+		status = osErrorResource;
+	}
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	return status;
+}
+
+uint32_t osSemaphoreGetCount(osSemaphoreId_t semaphore_id) {
+	os2_semaphore_cb_t* semaphore = os2_semaphore(semaphore_id);
+	return (semaphore != NULL) ? semaphore->tokens : 0;
+}
+
+osStatus_t osSemaphoreDelete(osSemaphoreId_t semaphore_id) {
+	os2_semaphore_cb_t* semaphore = os2_semaphore(semaphore_id);
+	os2_thread_cb_t* wake_list = NULL;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (semaphore == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	semaphore->id = OS2_ID_INVALID;
+	os2_wait_complete_all(&semaphore->waiters, &wake_list);
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	os2_cb_delete(semaphore);
+	return osOK;
+}
+
+//  ==== Memory Pool Management Functions ====
+
+static inline os2_memory_pool_cb_t* os2_memory_pool(osMemoryPoolId_t mp_id) {
+	os2_memory_pool_cb_t* mp = (os2_memory_pool_cb_t*)mp_id;
+	return ((mp != NULL) && (mp->id == OS2_ID_MEMORY_POOL)) ? mp : NULL;
+}
+
+osMemoryPoolId_t osMemoryPoolNew(uint32_t block_count, uint32_t block_size, const osMemoryPoolAttr_t* attr) {
+	os2_memory_pool_cb_t* mp;
+	uint32_t size, i;
+	uint8_t* mem;
+
+	if (os2_in_isr() || (block_count == 0) || (block_size == 0)) {
+		return NULL;
+	}
+
+	block_size = OS2_ALIGN4(block_size);
+	size = osMemoryPoolMemSize(block_count, block_size);
+	if (size / block_size != block_count) {
+		return NULL;
+	}
+
+	mp = os2_cb_new(attr ? attr->cb_mem : NULL, attr ? attr->cb_size : 0, sizeof(os2_memory_pool_cb_t));
+	if (mp == NULL) {
+		return NULL;
+	}
+
+	if (attr && attr->mp_mem) {
+		if ((attr->mp_size < size) || (((uintptr_t)attr->mp_mem & 3) != 0)) {
+			os2_cb_delete(mp);
+			return NULL;
+		}
+		mem = attr->mp_mem;
+	} else {
+		mem = os2_port_malloc(size);
+		if (mem == NULL) {
+			os2_cb_delete(mp);
+			return NULL;
+		}
+		mp->flags |= OS2_FLAG_MEM_ALLOCATED;
+	}
+
+	// Chain the free blocks. A free block holds the address of the next one.
+	for (i = 0; i < block_count - 1; i++) {
+		*(void**)(mem + (i * block_size)) = mem + ((i + 1) * block_size);
+	}
+	*(void**)(mem + (i * block_size)) = NULL;
+
+	mp->id          = OS2_ID_MEMORY_POOL;
+	mp->name        = attr ? attr->name : NULL;
+	mp->block_count = block_count;
+	mp->block_size  = block_size;
+	mp->block_base  = mem;
+	mp->block_lim   = mem + size;
+	mp->free_list   = mem;
+	return mp;
+}
+
+const char* osMemoryPoolGetName(osMemoryPoolId_t mp_id) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	return (mp != NULL) ? mp->name : NULL;
+}
+
+void* osMemoryPoolAlloc(osMemoryPoolId_t mp_id, uint32_t timeout) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	os2_thread_cb_t* self;
+	void* block;
+
+	if (mp == NULL) {
+		return NULL;
+	}
+
+	critical_section_enter();
+	block = mp->free_list;
+	if (block != NULL) {
+		mp->free_list = *(void**)block;
+		mp->used_count++;
+		critical_section_exit();
+		return block;
+	}
+	if (timeout == 0) {
+		critical_section_exit();
+		return NULL;
+	}
+
+	self = os2_port_thread_self();
+	if (os2_in_isr() || (self == NULL)) {
+		critical_section_exit();
+		return NULL;
+	}
+	if (os2_wait(self, OS2_WAIT_MEMORY_POOL, &mp->waiters, timeout, NULL) != osOK) {
+		return NULL;
+	}
+	// The block has been handed over by osMemoryPoolFree()
+	return self->wait_data;
+}
+
+osStatus_t osMemoryPoolFree(osMemoryPoolId_t mp_id, void* block) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	os2_thread_cb_t* wake_list = NULL;
+	os2_thread_cb_t* waiter;
+
+	if ((mp == NULL) || ((uint8_t*)block < (uint8_t*)mp->block_base) || ((uint8_t*)block >= (uint8_t*)mp->block_lim) ||
+		((((uint8_t*)block - (uint8_t*)mp->block_base) % mp->block_size) != 0))
+	{
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (mp->used_count == 0) {
+		critical_section_exit();
+		return osErrorResource;
+	}
+
+	waiter = mp->waiters;
+	if (waiter != NULL) {
+		// The block goes straight to the waiter
+		waiter->wait_data = block;
+		os2_wait_complete(waiter, osOK, &wake_list);
+	} else {
+		*(void**)block = mp->free_list;
+		mp->free_list = block;
+		mp->used_count--;
+	}
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	return osOK;
+}
+
+uint32_t osMemoryPoolGetCapacity(osMemoryPoolId_t mp_id) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	return (mp != NULL) ? mp->block_count : 0;
+}
+
+uint32_t osMemoryPoolGetBlockSize(osMemoryPoolId_t mp_id) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	return (mp != NULL) ? mp->block_size : 0;
+}
+
+uint32_t osMemoryPoolGetCount(osMemoryPoolId_t mp_id) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	return (mp != NULL) ? mp->used_count : 0;
+}
+
+uint32_t osMemoryPoolGetSpace(osMemoryPoolId_t mp_id) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	return (mp != NULL) ? mp->block_count - mp->used_count : 0;
+}
+
+osStatus_t osMemoryPoolDelete(osMemoryPoolId_t mp_id) {
+	os2_memory_pool_cb_t* mp = os2_memory_pool(mp_id);
+	os2_thread_cb_t* wake_list = NULL;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (mp == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	mp->id = OS2_ID_INVALID;
+	os2_wait_complete_all(&mp->waiters, &wake_list);
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	if (mp->flags & OS2_FLAG_MEM_ALLOCATED) {
+		os2_port_free(mp->block_base);
+	}
+	os2_cb_delete(mp);
+	return osOK;
+}
+
+//  ==== Message Queue Management Functions ====
+
+static inline os2_message_queue_cb_t* os2_message_queue(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = (os2_message_queue_cb_t*)mq_id;
+	return ((mq != NULL) && (mq->id == OS2_ID_MESSAGE_QUEUE)) ? mq : NULL;
+}
+
+static inline void* os2_message_data(os2_message_t* msg) {
+	return msg + 1;
+}
+
+// Queue the message after the messages of the same or higher priority (in critical section)
+static void os2_message_queue_insert(os2_message_queue_cb_t* mq, os2_message_t* msg) {
+	if ((mq->tail == NULL) || (mq->tail->priority >= msg->priority)) {
+		// Most of the messages have the same priority
+		msg->next = NULL;
+		if (mq->tail != NULL) {
+			mq->tail->next = msg;
+		} else {
+			mq->head = msg;
+		}
+		mq->tail = msg;
+	} else {
+		os2_message_t** link = &mq->head;
+
+		while ((*link)->priority >= msg->priority) {
+			link = &(*link)->next;
+		}
+		msg->next = *link;
+		*link = msg;
+	}
+	mq->count++;
+}
+
+// Move the message of the highest priority sender into the slot (in critical section)
+static void os2_message_queue_take_sender(os2_message_queue_cb_t* mq, os2_message_t* msg, os2_thread_cb_t** wake_list) {
+	os2_thread_cb_t* sender = mq->senders;
+
+	memcpy(os2_message_data(msg), sender->wait_data, mq->msg_size);
+	msg->priority = (uint8_t)sender->wait_value;
+	os2_message_queue_insert(mq, msg);
+	os2_wait_complete(sender, osOK, wake_list);
+}
+
+osMessageQueueId_t osMessageQueueNew(uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t* attr) {
+	os2_message_queue_cb_t* mq;
+	uint32_t slot_size, size, i;
+	uint8_t* mem;
+
+	if (os2_in_isr() || (msg_count == 0) || (msg_size == 0)) {
+		return NULL;
+	}
+
+	slot_size = sizeof(os2_message_t) + OS2_ALIGN4(msg_size);
+	size = osMessageQueueMemSize(msg_count, msg_size);
+	if ((slot_size < msg_size) || (size / slot_size != msg_count)) {
+		return NULL;
+	}
+
+	mq = os2_cb_new(attr ? attr->cb_mem : NULL, attr ? attr->cb_size : 0, sizeof(os2_message_queue_cb_t));
+	if (mq == NULL) {
+		return NULL;
+	}
+
+	if (attr && attr->mq_mem) {
+		if ((attr->mq_size < size) || (((uintptr_t)attr->mq_mem & 3) != 0)) {
+			os2_cb_delete(mq);
+			return NULL;
+		}
+		mem = attr->mq_mem;
+	} else {
+		mem = os2_port_malloc(size);
+		if (mem == NULL) {
+			os2_cb_delete(mq);
+			return NULL;
+		}
+		mq->flags |= OS2_FLAG_MEM_ALLOCATED;
+	}
+
+	// Chain the free slots
+	for (i = 0; i < msg_count; i++) {
+		os2_message_t* msg = (os2_message_t*)(mem + (i * slot_size));
+		msg->next = (i + 1 < msg_count) ? (os2_message_t*)(mem + ((i + 1) * slot_size)) : NULL;
+	}
+
+	mq->id        = OS2_ID_MESSAGE_QUEUE;
+	mq->name      = attr ? attr->name : NULL;
+	mq->msg_count = msg_count;
+	mq->msg_size  = msg_size;
+	mq->slot_mem  = mem;
+	mq->free_list = (os2_message_t*)mem;
+	return mq;
+}
+
+const char* osMessageQueueGetName(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	return (mq != NULL) ? mq->name : NULL;
+}
+
+osStatus_t osMessageQueuePut(osMessageQueueId_t mq_id, const void* msg_ptr, uint8_t msg_prio, uint32_t timeout) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	os2_thread_cb_t* wake_list = NULL;
+	os2_thread_cb_t* self;
+	os2_message_t* msg;
+
+	if ((mq == NULL) || (msg_ptr == NULL)) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	if (mq->receivers != NULL) {
+		// The queue is empty: copy the message straight into the buffer of the receiver
+		os2_thread_cb_t* receiver = mq->receivers;
+
+		memcpy(receiver->wait_data, msg_ptr, mq->msg_size);
+		receiver->wait_value = msg_prio;
+		os2_wait_complete(receiver, osOK, &wake_list);
+		critical_section_exit();
+
+		os2_wake_up(wake_list);
+		return osOK;
+	}
+
+	msg = mq->free_list;
+	if (msg != NULL) {
+		mq->free_list = msg->next;
+		memcpy(os2_message_data(msg), msg_ptr, mq->msg_size);
+		msg->priority = msg_prio;
+		os2_message_queue_insert(mq, msg);
+		critical_section_exit();
+		return osOK;
+	}
+	if (timeout == 0) {
+		critical_section_exit();
+		return osErrorResource;
+	}
+
+	// The message is copied from our buffer by the receiver that frees a slot
+	self = os2_port_thread_self();
+	if (os2_in_isr() || (self == NULL)) {
+		critical_section_exit();
+		return osErrorParameter;
+	}
+	self->wait_data = (void*)msg_ptr;
+	self->wait_value = msg_prio;
+	return os2_wait(self, OS2_WAIT_MESSAGE_PUT, &mq->senders, timeout, NULL);
+}
+
+osStatus_t osMessageQueueGet(osMessageQueueId_t mq_id, void* msg_ptr, uint8_t* msg_prio, uint32_t timeout) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	os2_thread_cb_t* wake_list = NULL;
+	os2_thread_cb_t* self;
+	os2_message_t* msg;
+	osStatus_t status;
+
+	if ((mq == NULL) || (msg_ptr == NULL)) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	msg = mq->head;
+	if (msg != NULL) {
+		mq->head = msg->next;
+		if (mq->head == NULL) {
+			mq->tail = NULL;
+		}
+		mq->count--;
+
+		memcpy(msg_ptr, os2_message_data(msg), mq->msg_size);
+		if (msg_prio != NULL) {
+			*msg_prio = msg->priority;
+		}
+
+		// Reuse the slot for the message of a waiting sender
+		if (mq->senders != NULL) {
+			os2_message_queue_take_sender(mq, msg, &wake_list);
+		} else {
+			msg->next = mq->free_list;
+			mq->free_list = msg;
+		}
+		critical_section_exit();
+
+		os2_wake_up(wake_list);
+		return osOK;
+	}
+	if (timeout == 0) {
+		critical_section_exit();
+		return osErrorResource;
+	}
+
+	// The message is copied into our buffer by the sender
+	self = os2_port_thread_self();
+	if (os2_in_isr() || (self == NULL)) {
+		critical_section_exit();
+		return osErrorParameter;
+	}
+	self->wait_data = msg_ptr;
+	status = os2_wait(self, OS2_WAIT_MESSAGE_GET, &mq->receivers, timeout, NULL);
+	if ((status == osOK) && (msg_prio != NULL)) {
+		*msg_prio = (uint8_t)self->wait_value;
+	}
+	return status;
+}
+
+uint32_t osMessageQueueGetCapacity(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	return (mq != NULL) ? mq->msg_count : 0;
+}
+
+uint32_t osMessageQueueGetMsgSize(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	return (mq != NULL) ? mq->msg_size : 0;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	return (mq != NULL) ? mq->count : 0;
+}
+
+uint32_t osMessageQueueGetSpace(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	return (mq != NULL) ? mq->msg_count - mq->count : 0;
+}
+
+osStatus_t osMessageQueueReset(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	os2_thread_cb_t* wake_list = NULL;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (mq == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	// Discard the queued messages
+	while (mq->head != NULL) {
+		os2_message_t* msg = mq->head;
+		mq->head = msg->next;
+		msg->next = mq->free_list;
+		mq->free_list = msg;
+	}
+	mq->tail = NULL;
+	mq->count = 0;
+
+	// Queue the messages of the waiting senders
+	while ((mq->senders != NULL) && (mq->free_list != NULL)) {
+		os2_message_t* msg = mq->free_list;
+		mq->free_list = msg->next;
+		os2_message_queue_take_sender(mq, msg, &wake_list);
+	}
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	return osOK;
+}
+
+osStatus_t osMessageQueueDelete(osMessageQueueId_t mq_id) {
+	os2_message_queue_cb_t* mq = os2_message_queue(mq_id);
+	os2_thread_cb_t* wake_list = NULL;
+
+	if (os2_in_isr()) {
+		return osErrorISR;
+	}
+	if (mq == NULL) {
+		return osErrorParameter;
+	}
+
+	critical_section_enter();
+	mq->id = OS2_ID_INVALID;
+	os2_wait_complete_all(&mq->senders, &wake_list);
+	os2_wait_complete_all(&mq->receivers, &wake_list);
+	critical_section_exit();
+
+	os2_wake_up(wake_list);
+	if (mq->flags & OS2_FLAG_MEM_ALLOCATED) {
+		os2_port_free(mq->slot_mem);
+	}
+	os2_cb_delete(mq);
+	return osOK;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Kernel interface of the CMSIS-RTOS2 layer. 'cmsis_os2.c' implements the objects in
+ * its own control blocks: it only needs the kernel to run threads and to block a thread
+ * until it is woken up or until a timeout. Each kernel implements this interface
+ * (port_freertos.c, port_rtx.c and port_riot.c).
+ */
+
+#ifndef __OS2_PORT_H__
+#define __OS2_PORT_H__
+
+#include "cmsis_os2.h"
+
+// Value returned by os2_port_thread_block()
+#define OS2_PORT_WOKEN          0
+#define OS2_PORT_TIMEOUT        1
+
+/*
+ * Kernel
+ */
+int os2_port_kernel_initialize(void);
+// Only returns on error
+int os2_port_kernel_start(void);
+uint32_t os2_port_kernel_get_tick(void);
+uint32_t os2_port_kernel_get_tick_freq(void);
+// Kernel identification returned by osKernelGetInfo()
+const char* os2_port_kernel_get_name(void);
+
+// Memory for the control blocks, stacks and data of the objects created without caller memory
+void* os2_port_malloc(size_t size);
+void os2_port_free(void* ptr);
+
+/*
+ * Threads
+ */
+
+// Create the kernel thread of `thread` (`thread->port` is set by the port). The kernel
+// thread runs os2_thread_entry(thread).
+int os2_port_thread_create(os2_thread_cb_t* thread);
+void os2_thread_entry(os2_thread_cb_t* thread);
+
+// Return the CMSIS-RTOS2 thread running the caller (NULL for the threads not created by
+// osThreadNew()).
+os2_thread_cb_t* os2_port_thread_self(void);
+
+// Change the kernel priority of the thread to `thread->priority`
+void os2_port_thread_set_priority(os2_thread_cb_t* thread);
+void os2_port_thread_yield(void);
+void os2_port_thread_delay(uint32_t ticks);
+
+// Delete the kernel thread `port` (the calling thread when NULL). When it is the calling
+// thread, it does not return. The control block of the thread might already have been freed.
+void os2_port_thread_terminate(void* port);
+
+// Block the calling thread until os2_port_thread_wake() is called for it or until `ticks`
+// (osWaitForever to wait without timeout). A wake up sent before the thread blocks is
+// not lost: the next block returns immediately.
+int os2_port_thread_block(os2_thread_cb_t* thread, uint32_t ticks);
+
+// Wake up a thread blocked by os2_port_thread_block(). It can be called from interrupts
+// but not from a critical section.
+void os2_port_thread_wake(os2_thread_cb_t* thread);
+
+#endif
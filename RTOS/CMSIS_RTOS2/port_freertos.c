@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * CMSIS-RTOS2 port on the native FreeRTOS API. The blocked threads wait for a task
+ * notification. The CMSIS-RTOS2 thread and the caller-provided stack of a task are kept
+ * in its thread local storage pointers.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "os2_port.h"
+
+#define OS2_TLS_THREAD		0	// CMSIS-RTOS2 thread of the task
+#define OS2_TLS_STACK		1	// Caller-provided stack of the task (not freed with the task)
+
+#if configMAX_PRIORITIES < 7
+  #error "The CMSIS-RTOS2 priorities require 7 FreeRTOS priorities"
+#endif
+
+// Caller-provided stack of the task being deleted by the idle task
+static void* g_os2_deleted_stack;
+// Caller-provided stack given to xTaskGenericCreate(). FreeRTOS frees it if the TCB cannot
+// be allocated.
+static void* g_os2_created_stack;
+
+static inline int os2_port_in_isr(void) {
+	return __get_IPSR() != 0U;
+}
+
+// osPriorityIdle..osPriorityRealtime7 on the FreeRTOS priorities 0..6
+static inline UBaseType_t os2_port_priority(int8_t priority) {
+	return priority / 8;
+}
+
+int os2_port_kernel_initialize(void) {
+	return 0;
+}
+
+int os2_port_kernel_start(void) {
+	vTaskStartScheduler();
+	return 1;
+}
+
+uint32_t os2_port_kernel_get_tick(void) {
+	if (os2_port_in_isr()) {
+		return xTaskGetTickCountFromISR();
+	} else {
+		return xTaskGetTickCount();
+	}
+}
+
+uint32_t os2_port_kernel_get_tick_freq(void) {
+	return configTICK_RATE_HZ;
+}
+
+const char* os2_port_kernel_get_name(void) {
+	return "FreeRTOS " tskKERNEL_VERSION_NUMBER;
+}
+
+void* os2_port_malloc(size_t size) {
+	return pvPortMalloc(size);
+}
+
+void os2_port_free(void* ptr) {
+	vPortFree(ptr);
+}
+
+static void os2_port_thread_entry(void* arg) {
+	os2_thread_entry((os2_thread_cb_t*)arg);
+}
+
+int os2_port_thread_create(os2_thread_cb_t* thread) {
+	uint32_t depth = configMINIMAL_STACK_SIZE;
+	TaskHandle_t handle;
+	BaseType_t res;
+
+	if (thread->stack_size != 0) {
+		depth = thread->stack_size / sizeof(StackType_t);
+		if (depth > UINT16_MAX) {
+			return 1;
+		}
+	}
+
+	vTaskSuspendAll();
+	g_os2_created_stack = thread->stack_mem;
+	res = xTaskGenericCreate(os2_port_thread_entry, thread->name ? thread->name : "", depth, thread,
+							 os2_port_priority(thread->priority), &handle,
+							 (StackType_t*)thread->stack_mem, NULL);
+	g_os2_created_stack = NULL;
+	// Bind the task before it can run: a higher priority task runs on xTaskResumeAll() and
+	// might block, be woken, terminated or reprioritized through 'thread->port'
+	if (res == pdPASS) {
+		thread->port = handle;
+		vTaskSetThreadLocalStoragePointer(handle, OS2_TLS_THREAD, thread);
+		vTaskSetThreadLocalStoragePointer(handle, OS2_TLS_STACK, thread->stack_mem);
+	} else {
+		thread->port = NULL;
+	}
+	xTaskResumeAll();
+	return (res == pdPASS) ? 0 : 1;
+}
+
+os2_thread_cb_t* os2_port_thread_self(void) {
+	if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+		return NULL;
+	}
+	return (os2_thread_cb_t*)pvTaskGetThreadLocalStoragePointer(NULL, OS2_TLS_THREAD);
+}
+
+void os2_port_thread_set_priority(os2_thread_cb_t* thread) {
+	vTaskPrioritySet((TaskHandle_t)thread->port, os2_port_priority(thread->priority));
+}
+
+void os2_port_thread_yield(void) {
+	taskYIELD();
+}
+
+void os2_port_thread_delay(uint32_t ticks) {
+	vTaskDelay(ticks);
+}
+
+void os2_port_thread_terminate(void* port) {
+	vTaskDelete((TaskHandle_t)port);
+}
+
+int os2_port_thread_block(os2_thread_cb_t* thread, uint32_t ticks) {
+	(void)thread;
+
+	// Each wake up gives one notification (portMAX_DELAY is osWaitForever)
+	if (ulTaskNotifyTake(pdFALSE, ticks) == 0) {
+		return OS2_PORT_TIMEOUT;
+	}
+	return OS2_PORT_WOKEN;
+}
+
+void os2_port_thread_wake(os2_thread_cb_t* thread) {
+	if (os2_port_in_isr()) {
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+		vTaskNotifyGiveFromISR((TaskHandle_t)thread->port, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	} else {
+		xTaskNotifyGive((TaskHandle_t)thread->port);
+	}
+}
+
+/*
+ * FreeRTOS hooks (see FreeRTOSConfig.h): the caller-provided stacks must not be returned
+ * to the heap when their task is deleted.
+ */
+void os_thread_clean_up(void* tcb) {
+	g_os2_deleted_stack = pvTaskGetThreadLocalStoragePointer((TaskHandle_t)tcb, OS2_TLS_STACK);
+}
+
+void os_thread_free_stack(void* stack) {
+	if ((stack != g_os2_deleted_stack) && (stack != g_os2_created_stack)) {
+		vPortFree(stack);
+	}
+}
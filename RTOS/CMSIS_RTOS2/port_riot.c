@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * CMSIS-RTOS2 port on the CMSIS-RTOS v1 layer of RioT-OS (renamed with the 'os1' prefix,
+ * see cmsis_os1.h). A blocked thread waits for the last signal flag of the layer. The
+ * kernel tick is the millisecond of the PolyMCU timer that drives the timeouts of the
+ * layer. main() is already a RioT-OS thread: it runs at osPriorityRealtime between
+ * osKernelInitialize() and osKernelStart() and osKernelStart() terminates it.
+ *
+ * The thread stacks come from the stack pool of the layer: `stack_mem` is not used.
+ */
+
+#include <stdlib.h>
+#include "cmsis_os1.h"
+#include "cmsis_os.h"
+#include "cmsis_os1_end.h"
+#include "os2_port.h"
+#include "kernel_types.h"
+#include "PolyMCU.h"
+
+// Signal flag that wakes up a thread blocked by the CMSIS-RTOS2 layer
+#define OS2_SIGNAL			(1 << (osFeature_Signals - 1))
+
+// CMSIS-RTOS2 threads indexed by their RioT-OS PID
+static os2_thread_cb_t* g_os2_threads[KERNEL_PID_LAST + 1];
+
+// osPriorityIdle..osPriorityRealtime7 on os1PriorityIdle..os1PriorityRealtime
+static inline osPriority os2_port_priority(int8_t priority) {
+	return (osPriority)((priority / 8) - 3);
+}
+
+int os2_port_kernel_initialize(void) {
+	if (os1KernelInitialize() != os1OK) {
+		return 1;
+	}
+
+	// The threads created before osKernelStart() must not preempt main()
+	os1ThreadSetPriority(os1ThreadGetId(), os1PriorityRealtime);
+	return 0;
+}
+
+int os2_port_kernel_start(void) {
+	// RioT-OS is already running: main() is replaced by the CMSIS-RTOS2 threads
+	os1ThreadTerminate(os1ThreadGetId());
+	return 1;
+}
+
+uint32_t os2_port_kernel_get_tick(void) {
+	return (uint32_t)(polymcu_time_us() / 1000);
+}
+
+uint32_t os2_port_kernel_get_tick_freq(void) {
+	return 1000;
+}
+
+const char* os2_port_kernel_get_name(void) {
+	return osKernelSystemId;
+}
+
+void* os2_port_malloc(size_t size) {
+	void* ptr;
+
+	critical_section_enter();
+	ptr = malloc(size);
+	critical_section_exit();
+	return ptr;
+}
+
+void os2_port_free(void* ptr) {
+	critical_section_enter();
+	free(ptr);
+	critical_section_exit();
+}
+
+static void os2_port_thread_entry(void const* arg) {
+	os2_thread_cb_t* thread = (os2_thread_cb_t*)arg;
+	osThreadId pid = os1ThreadGetId();
+
+	thread->port = (void*)(intptr_t)pid;
+	g_os2_threads[pid] = thread;
+	os2_thread_entry(thread);
+}
+
+int os2_port_thread_create(os2_thread_cb_t* thread) {
+	osThreadDef_t thread_def = {
+		.name      = thread->name,
+		.pthread   = os2_port_thread_entry,
+		.tpriority = os2_port_priority(thread->priority),
+		.instances = 1,
+		.stacksize = thread->stack_size
+	};
+	osThreadId pid;
+
+	pid = osThreadCreate(&thread_def, thread);
+	if (pid == KERNEL_PID_UNDEF) {
+		return 1;
+	}
+	thread->port = (void*)(intptr_t)pid;
+	g_os2_threads[pid] = thread;
+	return 0;
+}
+
+os2_thread_cb_t* os2_port_thread_self(void) {
+	osThreadId pid = os1ThreadGetId();
+
+	if ((pid < 0) || (pid > KERNEL_PID_LAST)) {
+		return NULL;
+	}
+	return g_os2_threads[pid];
+}
+
+void os2_port_thread_set_priority(os2_thread_cb_t* thread) {
+	os1ThreadSetPriority((osThreadId)(intptr_t)thread->port, os2_port_priority(thread->priority));
+}
+
+void os2_port_thread_yield(void) {
+	os1ThreadYield();
+}
+
+void os2_port_thread_delay(uint32_t ticks) {
+	os1Delay(ticks);
+}
+
+void os2_port_thread_terminate(void* port) {
+	osThreadId pid = (port != NULL) ? (osThreadId)(intptr_t)port : os1ThreadGetId();
+
+	if ((pid >= 0) && (pid <= KERNEL_PID_LAST)) {
+		g_os2_threads[pid] = NULL;
+	}
+	os1ThreadTerminate(pid);
+}
+
+int os2_port_thread_block(os2_thread_cb_t* thread, uint32_t ticks) {
+	osEvent event;
+
+	(void)thread;
+
+	event = osSignalWait(OS2_SIGNAL, ticks);
+	return (event.status == osEventSignal) ? OS2_PORT_WOKEN : OS2_PORT_TIMEOUT;
+}
+
+void os2_port_thread_wake(os2_thread_cb_t* thread) {
+	osSignalSet((osThreadId)(intptr_t)thread->port, OS2_SIGNAL);
+}
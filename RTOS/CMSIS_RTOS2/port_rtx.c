@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * CMSIS-RTOS2 port on the CMSIS-RTOS v1 API of RTX (renamed with the 'os1' prefix, see
+ * cmsis_os1.h). A blocked thread waits for the last signal flag of RTX. main() is already
+ * a RTX thread: it runs at osPriorityRealtime between osKernelInitialize() and
+ * osKernelStart() (as the CMSIS-RTOS2 threads must not run before) and osKernelStart()
+ * terminates it.
+ *
+ * RTX allocates the thread stacks itself: `stack_mem` is not used and a `stack_size`
+ * larger than the default one requires RTOS_TASK_PRIVATE_STACK_COUNT/SIZE.
+ */
+
+// The RTX headers first: rt_TypeDef.h defines NULL without checking it is defined
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_Time.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "cmsis_os1.h"
+#include "cmsis_os.h"
+#include "cmsis_os1_end.h"
+#include "os2_port.h"
+#include "PolyMCU.h"
+
+// Signal flag that wakes up a thread blocked by the CMSIS-RTOS2 layer
+#define OS2_SIGNAL			(1 << (osFeature_Signals - 1))
+// Longest RTX timeout (in ticks) whose conversion to milliseconds cannot overflow
+// (the RTX tick is at most 1s)
+#define OS2_MAX_TICKS		(0xFFFFFFFEU / 1000U)
+
+// CMSIS-RTOS2 threads indexed by the RTX task ID
+static os2_thread_cb_t** g_os2_threads;
+
+// osPriorityIdle..osPriorityRealtime7 on os1PriorityIdle..os1PriorityRealtime
+static inline osPriority os2_port_priority(int8_t priority) {
+	return (osPriority)((priority / 8) - 3);
+}
+
+// The CMSIS-RTOS v1 API only accepts milliseconds: round up to cover the RTX ticks
+static inline uint32_t os2_port_ticks_to_ms(uint32_t ticks) {
+	return (uint32_t)((((uint64_t)ticks * os_clockrate) + 999U) / 1000U);
+}
+
+int os2_port_kernel_initialize(void) {
+	g_os2_threads = os2_port_malloc(os_maxtaskrun * sizeof(os2_thread_cb_t*));
+	if (g_os2_threads == NULL) {
+		return 1;
+	}
+	memset(g_os2_threads, 0, os_maxtaskrun * sizeof(os2_thread_cb_t*));
+
+	// The threads created before osKernelStart() must not preempt main()
+	os1ThreadSetPriority(os1ThreadGetId(), os1PriorityRealtime);
+	return 0;
+}
+
+int os2_port_kernel_start(void) {
+	// RTX is already running: main() is replaced by the CMSIS-RTOS2 threads
+	os1ThreadTerminate(os1ThreadGetId());
+	return 1;
+}
+
+uint32_t os2_port_kernel_get_tick(void) {
+	return os_time;
+}
+
+uint32_t os2_port_kernel_get_tick_freq(void) {
+	return 1000000U / os_clockrate;
+}
+
+const char* os2_port_kernel_get_name(void) {
+	return osKernelSystemId;
+}
+
+void* os2_port_malloc(size_t size) {
+	void* ptr;
+
+	critical_section_enter();
+	ptr = malloc(size);
+	critical_section_exit();
+	return ptr;
+}
+
+void os2_port_free(void* ptr) {
+	critical_section_enter();
+	free(ptr);
+	critical_section_exit();
+}
+
+static inline uint32_t os2_port_task_index(osThreadId id) {
+	return ((P_TCB)id)->task_id - 1U;
+}
+
+static void os2_port_thread_entry(void const* arg) {
+	os2_thread_cb_t* thread = (os2_thread_cb_t*)arg;
+	osThreadId id = os1ThreadGetId();
+
+	// The thread might run before osThreadCreate() returns
+	thread->port = id;
+	g_os2_threads[os2_port_task_index(id)] = thread;
+	os2_thread_entry(thread);
+}
+
+int os2_port_thread_create(os2_thread_cb_t* thread) {
+	osThreadDef_t thread_def = {
+		.pthread   = os2_port_thread_entry,
+		.tpriority = os2_port_priority(thread->priority),
+		.instances = 1,
+		.stacksize = thread->stack_size
+	};
+	osThreadId id;
+
+	if (g_os2_threads == NULL) {
+		return 1;
+	}
+
+	id = osThreadCreate(&thread_def, thread);
+	if (id == NULL) {
+		return 1;
+	}
+	thread->port = id;
+	g_os2_threads[os2_port_task_index(id)] = thread;
+	return 0;
+}
+
+os2_thread_cb_t* os2_port_thread_self(void) {
+	osThreadId id = os1ThreadGetId();
+	uint32_t index;
+
+	if ((id == NULL) || (g_os2_threads == NULL)) {
+		return NULL;
+	}
+	index = os2_port_task_index(id);
+	return (index < os_maxtaskrun) ? g_os2_threads[index] : NULL;
+}
+
+void os2_port_thread_set_priority(os2_thread_cb_t* thread) {
+	os1ThreadSetPriority(thread->port, os2_port_priority(thread->priority));
+}
+
+void os2_port_thread_yield(void) {
+	os1ThreadYield();
+}
+
+void os2_port_thread_delay(uint32_t ticks) {
+	while (ticks > OS2_MAX_TICKS) {
+		os1Delay(os2_port_ticks_to_ms(OS2_MAX_TICKS));
+		ticks -= OS2_MAX_TICKS;
+	}
+	os1Delay(os2_port_ticks_to_ms(ticks));
+}
+
+void os2_port_thread_terminate(void* port) {
+	osThreadId id = (port != NULL) ? (osThreadId)port : os1ThreadGetId();
+	uint32_t index = os2_port_task_index(id);
+
+	if ((g_os2_threads != NULL) && (index < os_maxtaskrun)) {
+		g_os2_threads[index] = NULL;
+	}
+	os1ThreadTerminate(id);
+}
+
+int os2_port_thread_block(os2_thread_cb_t* thread, uint32_t ticks) {
+	osEvent event;
+
+	(void)thread;
+
+	if (ticks == osWaitForever) {
+		event = osSignalWait(OS2_SIGNAL, osWaitForever);
+		return (event.status == osEventSignal) ? OS2_PORT_WOKEN : OS2_PORT_TIMEOUT;
+	}
+
+	// Split the timeouts that would not fit in milliseconds
+	for (;;) {
+		uint32_t chunk = (ticks > OS2_MAX_TICKS) ? OS2_MAX_TICKS : ticks;
+
+		event = osSignalWait(OS2_SIGNAL, os2_port_ticks_to_ms(chunk));
+		if (event.status == osEventSignal) {
+			return OS2_PORT_WOKEN;
+		}
+		ticks -= chunk;
+		if (ticks == 0) {
+			return OS2_PORT_TIMEOUT;
+		}
+	}
+}
+
+void os2_port_thread_wake(os2_thread_cb_t* thread) {
+	osSignalSet(thread->port, OS2_SIGNAL);
+}
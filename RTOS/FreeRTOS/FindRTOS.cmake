@@ -46,8 +46,21 @@ else()
   message(FATAL_ERROR "Toolchain not supported.")
 endif()
 
-if(NOT SUPPORT_RTOS_NO_CMSIS)
+if(SUPPORT_RTOS_CMSIS2)
+  # The CMSIS-RTOS2 layer replaces the CMSIS-RTOS wrapper (see RTOS/CMSIS_RTOS2)
+  include_directories(${CMAKE_CURRENT_LIST_DIR}/../CMSIS_RTOS2/Include)
+  add_definitions(-D__CMSIS_RTOS2)
+elseif(NOT SUPPORT_RTOS_NO_CMSIS)
   add_definitions(-D__CMSIS_RTOS)
 endif()
 
+# Allocate the stacks of the CMSIS threads at link time (see osThreadDef())
+if(SUPPORT_RTOS_STATIC)
+  add_definitions(-DSUPPORT_RTOS_STATIC)
+endif()
+
 set(RTOS_LIBRARIES freertos)
+if(SUPPORT_RTOS_CMSIS2)
+  # The layer is linked before the kernel it calls into
+  list(INSERT RTOS_LIBRARIES 0 cmsis_rtos2)
+endif()
@@ -25,17 +25,26 @@
  */
 
 #include "board.h"
+#include <string.h>
 #include "cmsis_os.h"
 #include "FreeRTOS.h"
 #include "event_groups.h"
 #include "semphr.h"
 #include "task.h"
+#ifdef SUPPORT_RTOS_CPU_USAGE
+#include "PolyMCU.h"
+#endif
 
 uint32_t const os_tickfreq   = configCPU_CLOCK_HZ;
 uint16_t const os_tickus_i   = configCPU_CLOCK_HZ / 1000000;
 uint16_t const os_tickus_f   = (((uint64_t)(configCPU_CLOCK_HZ - 1000000 * (configCPU_CLOCK_HZ/1000000)))<<16) / 1000000;
 uint32_t const os_tick_period_ms = portTICK_PERIOD_MS;
 
+// Thread local storage pointers used by the CMSIS wrapper
+#define OS_TLS_THREAD		0	// 'os_thread_t' of the task
+#define OS_TLS_STACK		1	// Stack allocated by osThreadDef() (SUPPORT_RTOS_STATIC)
+#define OS_TLS_DEF			2	// Thread definition owning the stack (SUPPORT_RTOS_STATIC)
+
 typedef struct {
 	TaskHandle_t		handle;
 	EventGroupHandle_t	event_group;
@@ -58,11 +67,86 @@ typedef struct {
 	QueueHandle_t *queue;
 } os_message_t;
 
+// Memory pool control block stored in the 3 first words of the memory of the pool.
+// Each block is preceded by a header word: the address of the header of the next
+// free block when it is free, or its state when it is allocated.
+typedef struct {
+	uint32_t * volatile free;
+	uint32_t            block_sz;	// Size of a block and its header in bytes
+	uint32_t            count;
+} os_pool_t;
+
+#define OS_POOL_BLOCK_ALLOCATED		0x1
+#define OS_POOL_BLOCK_QUEUED		0x3
+
+// Mail queue control block stored in the queue memory of the mail queue definition
+typedef struct {
+	QueueHandle_t      queue;
+	SemaphoreHandle_t  free_blocks;
+} os_mail_t;
+
+// LDREX/STREX are available on ARMv7-M and ARMv8-M Mainline
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+  #define OS_USE_EXCLUSIVE_ACCESS
+#endif
+
 os_thread_t g_threads[RTOS_TASK_COUNT];
 
 /* Main Thread definition */
 extern int main (void);
-osThreadDef_t os_thread_def_main = {(os_pthread)main, osPriorityNormal, 1, configMAIN_STACK_SIZE };
+#ifdef SUPPORT_RTOS_STATIC
+static uint32_t os_thread_stack_main[configMAIN_STACK_SIZE] __attribute__((aligned(8)));
+static uint32_t os_thread_stack_used_main;
+osThreadDef_t os_thread_def_main = {(os_pthread)main, osPriorityNormal, 1, configMAIN_STACK_SIZE * sizeof(StackType_t),
+									os_thread_stack_main, &os_thread_stack_used_main };
+
+// Static stack of the task being deleted by the idle task
+static void *g_os_thread_deleted_stack;
+// Static stack given to xTaskGenericCreate(). FreeRTOS frees it if the TCB cannot be allocated.
+static void *g_os_thread_created_stack;
+
+static uint32_t os_thread_reserve_stack(const osThreadDef_t *thread_def) {
+	uint32_t instance;
+
+	taskENTER_CRITICAL();
+	for (instance = 0; instance < thread_def->instances; instance++) {
+		if ((*thread_def->stack_used & (1UL << instance)) == 0) {
+			*thread_def->stack_used |= 1UL << instance;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+	return instance;
+}
+
+static void os_thread_release_stack(const osThreadDef_t *thread_def, uint32_t instance) {
+	taskENTER_CRITICAL();
+	*thread_def->stack_used &= ~(1UL << instance);
+	taskEXIT_CRITICAL();
+}
+
+void os_thread_clean_up(void *tcb) {
+	const osThreadDef_t *thread_def = pvTaskGetThreadLocalStoragePointer((TaskHandle_t)tcb, OS_TLS_DEF);
+	StackType_t *stack = pvTaskGetThreadLocalStoragePointer((TaskHandle_t)tcb, OS_TLS_STACK);
+
+	g_os_thread_deleted_stack = stack;
+
+	// The idle task deletes the task once it cannot run anymore: its stack can now be
+	// given to a new instance
+	if (thread_def != NULL) {
+		os_thread_release_stack(thread_def,
+				(stack - (StackType_t*)thread_def->stack) / osThreadStackWords(thread_def->stacksize));
+	}
+}
+
+void os_thread_free_stack(void *stack) {
+	if ((stack != g_os_thread_deleted_stack) && (stack != g_os_thread_created_stack)) {
+		vPortFree(stack);
+	}
+}
+#else
+osThreadDef_t os_thread_def_main = {(os_pthread)main, osPriorityNormal, 1, configMAIN_STACK_SIZE * sizeof(StackType_t) };
+#endif
 
 __attribute__((naked)) void software_init_hook (void) {
   __asm (
@@ -120,50 +204,90 @@ uint32_t osKernelSysTick (void) {
 
 osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
 	unsigned short usStackDepth = configMINIMAL_STACK_SIZE;
+	StackType_t *stack = NULL;
 	os_thread_t *thread_id = NULL;
 	BaseType_t res;
 	uint32_t index;
+#ifdef SUPPORT_RTOS_STATIC
+	uint32_t instance;
 
+	usStackDepth = osThreadStackWords(thread_def->stacksize);
+
+	// Reserve a free stack among the instances of the thread definition. The stack of a
+	// terminated instance is released when FreeRTOS deletes its task (os_thread_clean_up()).
+	instance = os_thread_reserve_stack(thread_def);
+	if (instance == thread_def->instances) {
+		return NULL;
+	}
+	stack = (StackType_t*)thread_def->stack + (instance * usStackDepth);
+#else
+	// The stack size of the thread definition is in bytes
 	if (thread_def->stacksize != 0) {
-		usStackDepth = thread_def->stacksize;
+		usStackDepth = (thread_def->stacksize + sizeof(StackType_t) - 1) / sizeof(StackType_t);
 	}
+#endif
 
-	// Find free thread slot
+	// Find the first free thread slot
 	for (index = 0; index < RTOS_TASK_COUNT; index++) {
 		if (g_threads[index].handle == NULL) {
 			thread_id = &g_threads[index];
+			break;
 		}
 	}
 	if (thread_id == NULL) {
+#ifdef SUPPORT_RTOS_STATIC
+		os_thread_release_stack(thread_def, instance);
+#endif
 		return NULL;
 	}
 
-	res = xTaskCreate((TaskFunction_t)thread_def->pthread,	/* The function that implements the task. */
+	// Create the event group first as a higher priority thread runs straight away
+	thread_id->event_group = xEventGroupCreate();
+
+	// The new task must not run before its thread local storage is set
+	vTaskSuspendAll();
+#ifdef SUPPORT_RTOS_STATIC
+	g_os_thread_created_stack = stack;
+#endif
+	res = xTaskGenericCreate((TaskFunction_t)thread_def->pthread,	/* The function that implements the task. */
 				"Task", 									/* The text name assigned to the task - for debug only as it is not used by the kernel. */
-				usStackDepth, 								/* The size of the stack to allocate to the task. */
+				usStackDepth, 								/* The size of the stack of the task (in words). */
 				argument, 									/* The parameter passed to the task - just to check the functionality. */
 				tskIDLE_PRIORITY + thread_def->tpriority,	/* The priority assigned to the task. */
-				&thread_id->handle);										/* The task handle is not required, so NULL is passed. */
-	 if (res == pdPASS) {
-		 thread_id->event_group = xEventGroupCreate();
-		 return (osThreadId)thread_id;
-	 } else {
-		 return NULL;
-	 }
+				&thread_id->handle,							/* The task handle. */
+				stack,										/* The stack of the task or NULL to allocate it from the heap. */
+				NULL);
+	if (res == pdPASS) {
+		vTaskSetThreadLocalStoragePointer(thread_id->handle, OS_TLS_THREAD, thread_id);
+		vTaskSetThreadLocalStoragePointer(thread_id->handle, OS_TLS_STACK, stack);
+#ifdef SUPPORT_RTOS_STATIC
+		vTaskSetThreadLocalStoragePointer(thread_id->handle, OS_TLS_DEF, (void*)thread_def);
+#endif
+	}
+#ifdef SUPPORT_RTOS_STATIC
+	g_os_thread_created_stack = NULL;
+#endif
+	xTaskResumeAll();
+
+	if (res == pdPASS) {
+		return (osThreadId)thread_id;
+	} else {
+		if (thread_id->event_group != NULL) {
+			vEventGroupDelete(thread_id->event_group);
+			thread_id->event_group = NULL;
+		}
+		thread_id->handle = NULL;
+#ifdef SUPPORT_RTOS_STATIC
+		os_thread_release_stack(thread_def, instance);
+#endif
+		return NULL;
+	}
 }
 
 /// Return the thread ID of the current running thread.
 /// \return thread ID for reference by other functions or NULL in case of error.
 osThreadId osThreadGetId (void) {
-	uint32_t index;
-	TaskHandle_t handle = xTaskGetCurrentTaskHandle();
-
-	for (index = 0; index < RTOS_TASK_COUNT; index++) {
-		if (g_threads[index].handle == handle) {
-			return (osThreadId)&g_threads[index];
-		}
-	}
-	return NULL;
+	return (osThreadId)pvTaskGetThreadLocalStoragePointer(NULL, OS_TLS_THREAD);
 }
 
 /// Terminate execution of a thread and remove it from Active Threads.
@@ -171,13 +295,18 @@ osThreadId osThreadGetId (void) {
 /// \return status code that indicates the execution status of the function.
 osStatus osThreadTerminate (osThreadId thread_id) {
 	os_thread_t *thread = (os_thread_t *)thread_id;
+	TaskHandle_t handle = thread->handle;
 
-	if (thread->handle != NULL) {
+	if (handle != NULL) {
 		if (thread->event_group != NULL) {
 			vEventGroupDelete(thread->event_group);
+			thread->event_group = NULL;
 		}
-		vTaskDelete(thread->handle);
+		// Note: The static stack is released by os_thread_clean_up() once the idle task has
+		// deleted the task. A thread terminating itself still runs on it.
+		// Release the slot first: vTaskDelete() does not return when the thread terminates itself
 		thread->handle = NULL;
+		vTaskDelete(handle);
 
 		return osOK;
 	} else {
@@ -216,6 +345,21 @@ osPriority osThreadGetPriority (osThreadId thread_id) {
 	return priority;
 }
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+/// Get the CPU usage of an active thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId or NULL.
+/// \param[out]    stats         CPU usage of the thread.
+/// \return status code that indicates the execution status of the function.
+osStatus osThreadGetCpuUsage (osThreadId thread_id, polymcu_cpu_usage_stats_t *stats) {
+	os_thread_t *thread = (os_thread_t *)thread_id;
+
+	if (polymcu_cpu_usage_get((thread != NULL) ? thread->handle : NULL, stats) != 0) {
+		return osErrorParameter;
+	}
+	return osOK;
+}
+#endif
+
 /// Create a timer.
 /// \param[in]     timer_def     timer object referenced with \ref osTimer.
 /// \param[in]     type          osTimerOnce for one-shot or osTimerPeriodic for periodic behavior.
@@ -240,12 +384,18 @@ osStatus osTimerStart (osTimerId timer_id, uint32_t millisec) {
 	os_timer_t *timer = (os_timer_t*)timer_id;
 	BaseType_t ret;
 
-	ret =  xTimerChangePeriod(timer->timer, millisec / portTICK_PERIOD_MS, 0);
-	if (ret != pdPASS) {
-		return osErrorParameter;
-	}
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
 
-	ret = xTimerStart(timer->timer, 0);
+		// Changing the period of a timer also (re)starts it
+		ret = xTimerChangePeriodFromISR(timer->timer, millisec / portTICK_PERIOD_MS, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else {
+		ret = xTimerChangePeriod(timer->timer, millisec / portTICK_PERIOD_MS, 0);
+		if (ret == pdPASS) {
+			ret = xTimerStart(timer->timer, 0);
+		}
+	}
 	if (ret == pdPASS) {
 		return osOK;
 	} else {
@@ -258,7 +408,16 @@ osStatus osTimerStart (osTimerId timer_id, uint32_t millisec) {
 /// \return status code that indicates the execution status of the function.
 osStatus osTimerStop (osTimerId timer_id) {
 	os_timer_t *timer = (os_timer_t*)timer_id;
-	BaseType_t ret = xTimerStop(timer->timer, 0);
+	BaseType_t ret;
+
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+		ret = xTimerStopFromISR(timer->timer, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else {
+		ret = xTimerStop(timer->timer, 0);
+	}
 	if (ret == pdPASS) {
 		return osOK;
 	} else {
@@ -304,27 +463,31 @@ int32_t osSignalSet (osThreadId thread_id, int32_t signals) {
 	EventBits_t previous_bits;
 
 	os_thread_t *thread = (os_thread_t *)thread_id;
-	if (thread->event_group == NULL) {
-		thread->event_group = xEventGroupCreate();
-	}
 
-#if ( ( configUSE_TRACE_FACILITY == 1 ) && ( INCLUDE_xTimerPendFunctionCall == 1 ) && ( configUSE_TIMERS == 1 ) )
 	if (__get_IPSR() != 0) {
-		BaseType_t pxHigherPriorityTaskWoken;
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+		// The event group cannot be allocated from an interrupt
+		if (thread->event_group == NULL) {
+			return 0x80000000;
+		}
 
 		previous_bits = xEventGroupGetBitsFromISR(thread->event_group);
 
-		xEventGroupSetBitsFromISR(thread->event_group, signals, &pxHigherPriorityTaskWoken);
+		// The bits are set by the timer task, waking it up might require a context switch
+		if (xEventGroupSetBitsFromISR(thread->event_group, signals, &pxHigherPriorityTaskWoken) != pdPASS) {
+			return 0x80000000;
+		}
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
 	} else {
+		if (thread->event_group == NULL) {
+			thread->event_group = xEventGroupCreate();
+		}
+
 		previous_bits = xEventGroupGetBits(thread->event_group);
 
 		xEventGroupSetBits(thread->event_group, signals);
 	}
-#else
-	previous_bits = xEventGroupGetBits(thread->event_group);
-
-	xEventGroupSetBits(thread->event_group, signals);
-#endif
 	return previous_bits;
 }
 
@@ -336,28 +499,31 @@ int32_t osSignalClear (osThreadId thread_id, int32_t signals) {
 	EventBits_t previous_bits;
 
 	os_thread_t *thread = (os_thread_t *)thread_id;
-	if (thread->event_group == NULL) {
-		thread->event_group = xEventGroupCreate();
-	}
 
 	// Ignore the control bits
 	signals = signals & ~eventEVENT_BITS_CONTROL_BYTES;
 
-#if ( ( configUSE_TRACE_FACILITY == 1 ) && ( INCLUDE_xTimerPendFunctionCall == 1 ) && ( configUSE_TIMERS == 1 ) )
 	if (__get_IPSR() != 0) {
+		// The event group cannot be allocated from an interrupt
+		if (thread->event_group == NULL) {
+			return 0x80000000;
+		}
+
 		previous_bits = xEventGroupGetBitsFromISR(thread->event_group);
 
-		xEventGroupClearBitsFromISR(thread->event_group, signals);
+		// Clearing bits does not unblock any task, the timer task only needs to run later
+		if (xEventGroupClearBitsFromISR(thread->event_group, signals) != pdPASS) {
+			return 0x80000000;
+		}
 	} else {
+		if (thread->event_group == NULL) {
+			thread->event_group = xEventGroupCreate();
+		}
+
 		previous_bits = xEventGroupGetBits(thread->event_group);
 
 		xEventGroupClearBits(thread->event_group, signals);
 	}
-#else
-	previous_bits = xEventGroupGetBits(thread->event_group);
-
-	xEventGroupClearBits(thread->event_group, signals);
-#endif
 
 	return previous_bits;
 }
@@ -408,9 +574,10 @@ osStatus osMutexWait (osMutexId mutex_id, uint32_t millisec) {
 	BaseType_t res;
 
 	if (__get_IPSR() != 0) {
-		BaseType_t pxHigherPriorityTaskWoken;
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
 
 		res = xSemaphoreTakeFromISR(mutex->mutex, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
 	} else {
 		res = xSemaphoreTake(mutex->mutex, millisec / portTICK_PERIOD_MS);
 	}
@@ -428,9 +595,10 @@ osStatus osMutexRelease (osMutexId mutex_id) {
 	os_mutex_t* mutex = (os_mutex_t*)mutex_id;
 
 	if (__get_IPSR() != 0) {
-		BaseType_t pxHigherPriorityTaskWoken;
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
 
 		xSemaphoreGiveFromISR(mutex->mutex, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
 	} else {
 		xSemaphoreGive(mutex->mutex);
 	}
@@ -473,9 +641,10 @@ int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec) {
 	int32_t res;
 
 	if (__get_IPSR() != 0) {
-		BaseType_t pxHigherPriorityTaskWoken;
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
 
 		res = xSemaphoreTakeFromISR(sem->sem, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
 	} else {
 		res = xSemaphoreTake(sem->sem, millisec / portTICK_PERIOD_MS);
 	}
@@ -494,9 +663,10 @@ osStatus osSemaphoreRelease (osSemaphoreId semaphore_id) {
 	BaseType_t res;
 
 	if (__get_IPSR() != 0) {
-		BaseType_t pxHigherPriorityTaskWoken;
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
 
 		res = xSemaphoreGiveFromISR(sem->sem, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
 	} else {
 		res = xSemaphoreGive(sem->sem);
 	}
@@ -540,8 +710,16 @@ osMessageQId osMessageCreate (const osMessageQDef_t *queue_def, osThreadId threa
 /// \return status code that indicates the execution status of the function.
 osStatus osMessagePut (osMessageQId queue_id, uint32_t info, uint32_t millisec) {
 	os_message_t* message = (os_message_t*)queue_id;
+	BaseType_t ret;
+
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
 
-	BaseType_t ret = xQueueSend(message->queue, &info, millisec / portTICK_PERIOD_MS);
+		ret = xQueueSendFromISR(message->queue, &info, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else {
+		ret = xQueueSend(message->queue, &info, millisec / portTICK_PERIOD_MS);
+	}
 	if (ret == pdTRUE) {
 		return osOK;
 	} else {
@@ -557,8 +735,16 @@ os_InRegs osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec) {
 	os_message_t* message = (os_message_t*)queue_id;
 	osEvent event;
 	uint32_t info;
+	BaseType_t ret;
 
-	BaseType_t ret = xQueueReceive(message->queue, &info, millisec / portTICK_PERIOD_MS);
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+		ret = xQueueReceiveFromISR(message->queue, &info, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else {
+		ret = xQueueReceive(message->queue, &info, millisec / portTICK_PERIOD_MS);
+	}
 	if (ret == pdTRUE) {
 		event.status = osEventMessage;
 		event.value.v = info;
@@ -569,3 +755,288 @@ os_InRegs osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec) {
 }
 
 #endif     // Message Queues available
+
+#if (defined (osFeature_Pool)  &&  (osFeature_Pool != 0))  // Memory Pool Management available
+
+static void os_pool_init(os_pool_t *pool, uint32_t pool_sz, uint32_t item_sz) {
+	uint32_t *block = (uint32_t*)(pool + 1);
+	uint32_t index;
+
+	pool->block_sz = (((item_sz + 3) / 4) + 1) * sizeof(uint32_t);
+	pool->count = pool_sz;
+	pool->free = block;
+
+	for (index = 0; index < pool_sz - 1; index++) {
+		*block = (uint32_t)((uint8_t*)block + pool->block_sz);
+		block = (uint32_t*)*block;
+	}
+	*block = (uint32_t)NULL;
+}
+
+// Return the header of the block if it belongs to the pool
+static uint32_t *os_pool_get_header(os_pool_t *pool, void *block) {
+	uint32_t offset = (uint8_t*)block - (uint8_t*)(pool + 1);
+
+	if ((block == NULL) || (offset >= pool->block_sz * pool->count) ||
+		(offset % pool->block_sz != sizeof(uint32_t)))
+	{
+		return NULL;
+	} else {
+		return (uint32_t*)block - 1;
+	}
+}
+
+static void *os_pool_alloc(os_pool_t *pool) {
+	uint32_t *header;
+
+#ifdef OS_USE_EXCLUSIVE_ACCESS
+	do {
+		header = (uint32_t*)__LDREXW((volatile uint32_t*)&pool->free);
+		if (header == NULL) {
+			__CLREX();
+			return NULL;
+		}
+	} while (__STREXW(*header, (volatile uint32_t*)&pool->free));
+#else
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	header = pool->free;
+	if (header != NULL) {
+		pool->free = (uint32_t*)*header;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	if (header == NULL) {
+		return NULL;
+	}
+#endif
+
+	*header = OS_POOL_BLOCK_ALLOCATED;
+	return header + 1;
+}
+
+static osStatus os_pool_free(os_pool_t *pool, void *block) {
+	uint32_t *header = os_pool_get_header(pool, block);
+	uint32_t *free;
+
+	// Also catch the blocks that are already free or still in a mail queue
+	if ((header == NULL) || (*header != OS_POOL_BLOCK_ALLOCATED)) {
+		return osErrorValue;
+	}
+
+#ifdef OS_USE_EXCLUSIVE_ACCESS
+	do {
+		do {
+			free = pool->free;
+			*header = (uint32_t)free;
+			__DMB();
+		} while ((uint32_t)free != __LDREXW((volatile uint32_t*)&pool->free));
+	} while (__STREXW((uint32_t)header, (volatile uint32_t*)&pool->free));
+#else
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	free = pool->free;
+	*header = (uint32_t)free;
+	pool->free = header;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+#endif
+	return osOK;
+}
+
+/// Create and Initialize a memory pool.
+/// \param[in]     pool_def      memory pool definition referenced with \ref osPool.
+/// \return memory pool ID for reference by other functions or NULL in case of error.
+osPoolId osPoolCreate (const osPoolDef_t *pool_def) {
+	os_pool_t *pool = (os_pool_t*)pool_def->pool;
+
+	if ((pool == NULL) || (pool_def->pool_sz == 0) || (pool_def->item_sz == 0)) {
+		return NULL;
+	}
+	os_pool_init(pool, pool_def->pool_sz, pool_def->item_sz);
+	return (osPoolId)pool;
+}
+
+/// Allocate a memory block from a memory pool.
+/// \param[in]     pool_id       memory pool ID obtain referenced with \ref osPoolCreate.
+/// \return address of the allocated memory block or NULL in case of no memory available.
+void *osPoolAlloc (osPoolId pool_id) {
+	return os_pool_alloc((os_pool_t*)pool_id);
+}
+
+/// Allocate a memory block from a memory pool and set memory block to zero.
+/// \param[in]     pool_id       memory pool ID obtain referenced with \ref osPoolCreate.
+/// \return address of the allocated memory block or NULL in case of no memory available.
+void *osPoolCAlloc (osPoolId pool_id) {
+	os_pool_t *pool = (os_pool_t*)pool_id;
+	void *block = os_pool_alloc(pool);
+
+	if (block != NULL) {
+		memset(block, 0, pool->block_sz - sizeof(uint32_t));
+	}
+	return block;
+}
+
+/// Return an allocated memory block back to a specific memory pool.
+/// \param[in]     pool_id       memory pool ID obtain referenced with \ref osPoolCreate.
+/// \param[in]     block         address of the allocated memory block that is returned to the memory pool.
+/// \return status code that indicates the execution status of the function.
+osStatus osPoolFree (osPoolId pool_id, void *block) {
+	return os_pool_free((os_pool_t*)pool_id, block);
+}
+
+#endif   // Memory Pool Management available
+
+#if (defined (osFeature_MailQ)  &&  (osFeature_MailQ != 0))     // Mail Queues available
+
+/// Create and Initialize mail queue.
+/// \param[in]     queue_def     reference to the mail queue definition obtain with \ref osMailQ
+/// \param[in]     thread_id     thread ID (obtained by \ref osThreadCreate or \ref osThreadGetId) or NULL.
+/// \return mail queue ID for reference by other functions or NULL in case of error.
+osMailQId osMailCreate (const osMailQDef_t *queue_def, osThreadId thread_id) {
+	void **def = (void**)queue_def->pool;
+	os_mail_t *mail = (os_mail_t*)def[0];
+
+	if (queue_def->queue_sz == 0) {
+		return NULL;
+	}
+
+	// The queue only passes the pointers to the blocks
+	mail->queue = xQueueCreate(queue_def->queue_sz, sizeof(void*));
+	mail->free_blocks = xSemaphoreCreateCounting(queue_def->queue_sz, queue_def->queue_sz);
+	if ((mail->queue == NULL) || (mail->free_blocks == NULL)) {
+		return NULL;
+	}
+	os_pool_init((os_pool_t*)def[1], queue_def->queue_sz, queue_def->item_sz);
+	return (osMailQId)def;
+}
+
+/// Allocate a memory block from a mail.
+/// \param[in]     queue_id      mail queue ID obtained with \ref osMailCreate.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out
+/// \return pointer to memory block that can be filled with mail or NULL in case of error.
+void *osMailAlloc (osMailQId queue_id, uint32_t millisec) {
+	void **def = (void**)queue_id;
+	os_mail_t *mail = (os_mail_t*)def[0];
+	BaseType_t res;
+
+	// The semaphore counts the free blocks to wait for one
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+		res = xSemaphoreTakeFromISR(mail->free_blocks, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else if (millisec == osWaitForever) {
+		res = xSemaphoreTake(mail->free_blocks, portMAX_DELAY);
+	} else {
+		res = xSemaphoreTake(mail->free_blocks, millisec / portTICK_PERIOD_MS);
+	}
+	if (res != pdTRUE) {
+		return NULL;
+	}
+	return os_pool_alloc((os_pool_t*)def[1]);
+}
+
+/// Allocate a memory block from a mail and set memory block to zero.
+/// \param[in]     queue_id      mail queue ID obtained with \ref osMailCreate.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out
+/// \return pointer to memory block that can be filled with mail or NULL in case of error.
+void *osMailCAlloc (osMailQId queue_id, uint32_t millisec) {
+	os_pool_t *pool = (os_pool_t*)((void**)queue_id)[1];
+	void *block = osMailAlloc(queue_id, millisec);
+
+	if (block != NULL) {
+		memset(block, 0, pool->block_sz - sizeof(uint32_t));
+	}
+	return block;
+}
+
+/// Put a mail to a queue.
+/// \param[in]     queue_id      mail queue ID obtained with \ref osMailCreate.
+/// \param[in]     mail          memory block previously allocated with \ref osMailAlloc or \ref osMailCAlloc.
+/// \return status code that indicates the execution status of the function.
+osStatus osMailPut (osMailQId queue_id, void *mail) {
+	void **def = (void**)queue_id;
+	os_mail_t *mail_queue = (os_mail_t*)def[0];
+	uint32_t *header = os_pool_get_header((os_pool_t*)def[1], mail);
+	BaseType_t res;
+
+	// Also catch the blocks that are free or already queued
+	if ((header == NULL) || (*header != OS_POOL_BLOCK_ALLOCATED)) {
+		return osErrorValue;
+	}
+	*header = OS_POOL_BLOCK_QUEUED;
+
+	// The queue has one entry per block: it cannot be full
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+		res = xQueueSendFromISR(mail_queue->queue, &mail, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else {
+		res = xQueueSend(mail_queue->queue, &mail, 0);
+	}
+	if (res == pdTRUE) {
+		return osOK;
+	} else {
+		*header = OS_POOL_BLOCK_ALLOCATED;
+		return osErrorResource;
+	}
+}
+
+/// Get a mail from a queue.
+/// \param[in]     queue_id      mail queue ID obtained with \ref osMailCreate.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out
+/// \return event that contains mail information or error code.
+os_InRegs osEvent osMailGet (osMailQId queue_id, uint32_t millisec) {
+	void **def = (void**)queue_id;
+	os_mail_t *mail_queue = (os_mail_t*)def[0];
+	osEvent event;
+	void *mail;
+	BaseType_t res;
+
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+		res = xQueueReceiveFromISR(mail_queue->queue, &mail, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else if (millisec == osWaitForever) {
+		res = xQueueReceive(mail_queue->queue, &mail, portMAX_DELAY);
+	} else {
+		res = xQueueReceive(mail_queue->queue, &mail, millisec / portTICK_PERIOD_MS);
+	}
+
+	if (res == pdTRUE) {
+		*((uint32_t*)mail - 1) = OS_POOL_BLOCK_ALLOCATED;
+		event.status = osEventMail;
+		event.value.p = mail;
+	} else if (millisec == 0) {
+		event.status = osOK;
+	} else {
+		event.status = osEventTimeout;
+	}
+	return event;
+}
+
+/// Free a memory block from a mail.
+/// \param[in]     queue_id      mail queue ID obtained with \ref osMailCreate.
+/// \param[in]     mail          pointer to the memory block that was obtained with \ref osMailGet.
+/// \return status code that indicates the execution status of the function.
+osStatus osMailFree (osMailQId queue_id, void *mail) {
+	void **def = (void**)queue_id;
+	os_mail_t *mail_queue = (os_mail_t*)def[0];
+	osStatus status;
+
+	status = os_pool_free((os_pool_t*)def[1], mail);
+	if (status != osOK) {
+		return status;
+	}
+
+	if (__get_IPSR() != 0) {
+		BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+		xSemaphoreGiveFromISR(mail_queue->free_blocks, &pxHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+	} else {
+		xSemaphoreGive(mail_queue->free_blocks);
+	}
+	return osOK;
+}
+
+#endif  // Mail Queues available
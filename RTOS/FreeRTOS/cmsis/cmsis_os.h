@@ -60,8 +60,8 @@
 
 
 #define osFeature_MainThread   1       ///< main can be thread
-#define osFeature_Pool         0       ///< Memory Pools available - not supported by FreeRTOS
-#define osFeature_MailQ        0       ///< Mail Queues available - not supported by FreeRTOS
+#define osFeature_Pool         1       ///< Memory Pools available
+#define osFeature_MailQ        1       ///< Mail Queues available
 #define osFeature_MessageQ     1       ///< Message Queues available
 #define osFeature_Signals      16      ///< 16 Signal Flags available per thread
 #define osFeature_Semaphore    65535   ///< Maximum count for \ref osSemaphoreCreate function
@@ -77,6 +77,10 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#ifdef SUPPORT_RTOS_STATIC
+#include "FreeRTOSConfig.h"
+#endif
+
 #ifdef  __cplusplus
 extern "C"
 {
@@ -146,6 +150,9 @@ typedef struct os_mutex_t *osMutexId;
 /// Semaphore ID identifies the semaphore (pointer to a semaphore control block).
 typedef struct os_semaphore_t *osSemaphoreId;
 
+/// Pool ID identifies the memory pool (pointer to a memory pool control block).
+typedef struct os_pool_t *osPoolId;
+
 /// Message ID identifies the message queue (pointer to a message queue control block).
 typedef struct os_message_t *osMessageQId;
 
@@ -159,6 +166,10 @@ typedef struct os_thread_def  {
   osPriority             tpriority;    ///< initial thread priority
   uint32_t               instances;    ///< maximum number of instances of that thread function
   uint32_t               stacksize;    ///< stack size requirements in bytes; 0 is default stack size
+#ifdef SUPPORT_RTOS_STATIC
+  uint32_t              *stack;        ///< stacks of the instances (allocated by \ref osThreadDef)
+  uint32_t              *stack_used;   ///< bitmap of the instance stacks in use
+#endif
 } osThreadDef_t;
 
 /// Timer Definition structure contains timer parameters.
@@ -264,6 +275,15 @@ uint32_t osKernelSysTick (void);
 #if defined (osObjectsExternal)  // object is external
 #define osThreadDef(name, priority, instances, stacksz)  \
 extern const osThreadDef_t os_thread_def_##name
+#elif defined (SUPPORT_RTOS_STATIC) // define the object and the stacks of its instances
+/// Size of the stack of a thread instance in 32-bit words (8-byte aligned)
+#define osThreadStackWords(stacksz)  \
+((stacksz) ? ((((stacksz) + 7) / 8) * 2) : configMINIMAL_STACK_SIZE)
+#define osThreadDef(name, priority, instances, stacksz)  \
+static uint32_t os_thread_stack_##name[instances][osThreadStackWords(stacksz)] __attribute__((aligned(8))); \
+static uint32_t os_thread_stack_used_##name; \
+const osThreadDef_t os_thread_def_##name = \
+{ (name), (priority), (instances), (stacksz), &os_thread_stack_##name[0][0], &os_thread_stack_used_##name }
 #else                            // define the object
 #define osThreadDef(name, priority, instances, stacksz)  \
 const osThreadDef_t os_thread_def_##name = \
@@ -306,6 +326,16 @@ osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority);
 /// \return current priority value of the thread function.
 osPriority osThreadGetPriority (osThreadId thread_id);
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+struct polymcu_cpu_usage_stats;
+
+/// Get the CPU usage of an active thread (PolyMCU extension, see `polymcu_cpu_usage_get()`).
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId or NULL for the current thread.
+/// \param[out]    stats         cumulative cycles, load over the last window and unused stack of the thread.
+/// \return status code that indicates the execution status of the function.
+osStatus osThreadGetCpuUsage (osThreadId thread_id, struct polymcu_cpu_usage_stats *stats);
+#endif
+
 
 //  ==== Generic Wait Functions ====
 
@@ -486,7 +516,7 @@ osStatus osSemaphoreDelete (osSemaphoreId semaphore_id);
 extern const osPoolDef_t os_pool_def_##name
 #else                            // define the object
 #define osPoolDef(name, no, type)   \
-uint32_t os_pool_m_##name[3+((sizeof(type)+3)/4)*(no)]; \
+uint32_t os_pool_m_##name[3+(((sizeof(type)+3)/4)+1)*(no)]; \
 const osPoolDef_t os_pool_def_##name = \
 { (no), sizeof(type), (os_pool_m_##name) }
 #endif
@@ -579,7 +609,7 @@ extern const osMailQDef_t os_mailQ_def_##name
 #else                            // define the object
 #define osMailQDef(name, queue_sz, type) \
 uint32_t os_mailQ_q_##name[4+(queue_sz)] = { 0 }; \
-uint32_t os_mailQ_m_##name[3+((sizeof(type)+3)/4)*(queue_sz)]; \
+uint32_t os_mailQ_m_##name[3+(((sizeof(type)+3)/4)+1)*(queue_sz)]; \
 void *   os_mailQ_p_##name[2] = { (os_mailQ_q_##name), os_mailQ_m_##name }; \
 const osMailQDef_t os_mailQ_def_##name =  \
 { (queue_sz), sizeof(type), (os_mailQ_p_##name) }
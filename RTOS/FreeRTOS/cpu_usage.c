@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Per-task CPU usage (`SUPPORT_RTOS_CPU_USAGE`). The trace hooks of FreeRTOSConfig.h keep
+ * the record of each task in its task tag and account the CPU cycles of the task that is
+ * switched out (see Lib/PolyMCU/cpu_usage.c).
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "PolyMCU.h"
+
+// The idle and timer tasks have their record too
+#define CPU_USAGE_RECORD_COUNT		(RTOS_TASK_COUNT + 2)
+
+// A record is free when its thread is NULL
+static polymcu_cpu_usage_t g_cpu_usage[CPU_USAGE_RECORD_COUNT];
+
+// Called by traceTASK_CREATE() in a critical section
+polymcu_cpu_usage_t* os_cpu_usage_create(void* tcb, const char* name) {
+	uint32_t flags = 0;
+	unsigned int i;
+
+	for (i = 0; i < CPU_USAGE_RECORD_COUNT; i++) {
+		if (g_cpu_usage[i].thread == NULL) {
+			if (strcmp(name, "IDLE") == 0) {
+				flags |= POLYMCU_CPU_USAGE_IDLE;
+			}
+			polymcu_cpu_usage_add(&g_cpu_usage[i], name, tcb, NULL, flags);
+			return &g_cpu_usage[i];
+		}
+	}
+
+	// The task is not accounted
+	return NULL;
+}
+
+// Called by traceTASK_DELETE() in a critical section
+void os_cpu_usage_delete(polymcu_cpu_usage_t* usage) {
+	if (usage != NULL) {
+		polymcu_cpu_usage_remove(usage);
+		usage->thread = NULL;
+	}
+}
+
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_find(void* thread) {
+	return (polymcu_cpu_usage_t*)xTaskGetApplicationTaskTag((TaskHandle_t)thread);
+}
+
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_running(void) {
+	if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+		return NULL;
+	}
+	return (polymcu_cpu_usage_t*)xTaskGetApplicationTaskTag(NULL);
+}
+
+uint32_t polymcu_rtos_cpu_usage_stack_free(const polymcu_cpu_usage_t* usage) {
+	// The stacks are filled with a known value when configCHECK_FOR_STACK_OVERFLOW is 2
+	return uxTaskGetStackHighWaterMark((TaskHandle_t)usage->thread) * sizeof(StackType_t);
+}
+
+static void cpu_usage_report_task(void* arg) {
+	TickType_t period = pdMS_TO_TICKS((unsigned int)arg);
+	TickType_t last_wake = xTaskGetTickCount();
+
+	for (;;) {
+		vTaskDelayUntil(&last_wake, period);
+		polymcu_cpu_usage_dump();
+	}
+}
+
+int polymcu_cpu_usage_start_report(unsigned int period_ms) {
+	BaseType_t ret;
+
+	if (pdMS_TO_TICKS(period_ms) == 0) {
+		return 1;
+	}
+
+	// The printf() of the report requires more than the minimal stack
+	ret = xTaskCreate(cpu_usage_report_task, "CPU", configMINIMAL_STACK_SIZE * 2,
+			(void*)period_ms, configMAX_PRIORITIES - 1, NULL);
+	return (ret == pdPASS) ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * FreeRTOS memory allocator backed by the PolyMCU heap (`SUPPORT_HEAP=tlsf`).
+ * FreeRTOS and newlib share the same heap instead of splitting the RAM.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "PolyMCU.h"
+
+void *pvPortMalloc( size_t xWantedSize ) {
+	void *pvReturn;
+
+	// The PolyMCU heap is protected by its own (bounded) critical sections
+	pvReturn = polymcu_heap_malloc( NULL, xWantedSize );
+	traceMALLOC( pvReturn, xWantedSize );
+
+#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	if( pvReturn == NULL ) {
+		extern void vApplicationMallocFailedHook( void );
+		vApplicationMallocFailedHook();
+	}
+#endif
+
+	return pvReturn;
+}
+
+void vPortFree( void *pv ) {
+	if( pv != NULL ) {
+		traceFREE( pv, 0 );
+		polymcu_heap_free( NULL, pv );
+	}
+}
+
+size_t xPortGetFreeHeapSize( void ) {
+	polymcu_heap_stats_t stats;
+
+	polymcu_heap_get_stats( NULL, &stats );
+	return stats.free_size;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize( void ) {
+	polymcu_heap_stats_t stats;
+
+	polymcu_heap_get_stats( NULL, &stats );
+	return stats.total_size - stats.peak_used_size;
+}
+
+void vPortInitialiseBlocks( void ) {
+	/* This just exists to keep the linker quiet. */
+}
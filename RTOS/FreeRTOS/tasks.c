@@ -3160,8 +3160,9 @@ TCB_t *pxNewTCB;
 			else
 			{
 				/* The stack cannot be used as the TCB was not created.  Free it
-				again. */
-				vPortFree( pxStack );
+				again.  It was allocated with pvPortMallocAligned() so it might be
+				the stack provided by the application. */
+				vPortFreeAligned( pxStack );
 			}
 		}
 		else
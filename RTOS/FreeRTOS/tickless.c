@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * FreeRTOS tickless idle driven by the PolyMCU timer (`SUPPORT_RTOS_TICKLESS`).
+ * The FreeRTOS tick is a periodic task of the PolyMCU timer. When all the tasks are
+ * blocked, the idle task replaces it by a single wake up at the next FreeRTOS deadline
+ * and the board HW timer (see `polymcu_timer_hw_set_next()`) lets the core sleep until then.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "PolyMCU.h"
+
+#if configUSE_TICKLESS_IDLE != 2
+  #error "The PolyMCU tickless idle requires configUSE_TICKLESS_IDLE to be 2"
+#endif
+
+void xPortSysTickHandler( void );
+
+static polymcu_timer_task_t g_rtos_tick_task;
+// PolyMCU timer value of the last tick counted by FreeRTOS
+static unsigned int g_rtos_tick;
+
+// Count the ticks that have elapsed since the last FreeRTOS tick. It catches up with the
+// ticks the PolyMCU timer has expired together
+static void rtos_tick_update(void) {
+	unsigned int now = polymcu_timer_get_value();
+
+	while (g_rtos_tick != now) {
+		g_rtos_tick++;
+		xPortSysTickHandler();
+	}
+}
+
+static void rtos_tick(void* arg) {
+	rtos_tick_update();
+}
+
+static void rtos_wake_up(void* arg) {
+	// Nothing to do, the interrupt has woken up the core
+}
+
+// Override the SysTick setup of the FreeRTOS port
+void vPortSetupTimerInterrupt( void ) {
+	polymcu_timer_init(configTICK_RATE_HZ);
+
+	g_rtos_tick_task = polymcu_timer_create_periodic_task(rtos_tick, 1, NULL);
+	configASSERT(g_rtos_tick_task != NULL);
+
+	g_rtos_tick = polymcu_timer_get_value();
+	polymcu_timer_start_task(g_rtos_tick_task);
+}
+
+/*
+ * Called by the idle task with the scheduler suspended when no task is expected to be
+ * ready for `xExpectedIdleTime` ticks.
+ */
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime ) {
+	polymcu_timer_task_t wake_up_task;
+	unsigned int elapsed;
+
+	// The interrupts still wake up the core from WFI but they are only served once the
+	// sleep has been set up or the tick count has been corrected
+	__disable_irq();
+
+	if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+		__enable_irq();
+		return;
+	}
+
+	// Ticks that have elapsed but have not been counted by FreeRTOS yet
+	elapsed = polymcu_timer_get_value() - g_rtos_tick;
+	if (elapsed >= xExpectedIdleTime) {
+		__enable_irq();
+		return;
+	}
+
+	// Replace the periodic tick by a single wake up at the end of the expected idle time
+	wake_up_task = polymcu_timer_create_one_time_task(rtos_wake_up, xExpectedIdleTime - elapsed, NULL);
+	if (wake_up_task == NULL) {
+		// No free timer task, keep the periodic tick
+		__enable_irq();
+		return;
+	}
+	polymcu_timer_stop_task(g_rtos_tick_task);
+	polymcu_timer_start_task(wake_up_task);
+
+	configPRE_SLEEP_PROCESSING(xExpectedIdleTime);
+	__DSB();
+	__WFI();
+	__ISB();
+	configPOST_SLEEP_PROCESSING(xExpectedIdleTime);
+
+	// Serve the interrupt that has woken up the core. It might not be the PolyMCU timer
+	__enable_irq();
+	__disable_irq();
+
+	polymcu_timer_stop_task(wake_up_task);
+	polymcu_timer_remove_task(wake_up_task);
+
+	// Jump over the ticks the core has slept in one go. The last tick of the expected
+	// idle time is left to the tick handler to unblock the tasks whose timeout has expired
+	elapsed = polymcu_timer_get_value() - g_rtos_tick;
+	if (elapsed >= xExpectedIdleTime) {
+		elapsed = xExpectedIdleTime - 1;
+	}
+	vTaskStepTick(elapsed);
+	g_rtos_tick += elapsed;
+
+	// The ticks left are pended until the scheduler is resumed by the idle task
+	rtos_tick_update();
+	polymcu_timer_start_task(g_rtos_tick_task);
+
+	__enable_irq();
+}
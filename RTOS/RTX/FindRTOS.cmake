@@ -26,7 +26,17 @@
 
 include_directories(${CMAKE_CURRENT_LIST_DIR}/INC)
 
-# If RTX is supported
-add_definitions(-D__CMSIS_RTOS)
+if(SUPPORT_RTOS_CMSIS2)
+  # The CMSIS-RTOS v1 API of RTX is only used by the CMSIS-RTOS2 layer (see RTOS/CMSIS_RTOS2)
+  include_directories(${CMAKE_CURRENT_LIST_DIR}/../CMSIS_RTOS2/Include)
+  add_definitions(-D__CMSIS_RTOS2)
+else()
+  # If RTX is supported
+  add_definitions(-D__CMSIS_RTOS)
+endif()
 
 set(RTOS_LIBRARIES cmsis_rtos)
+if(SUPPORT_RTOS_CMSIS2)
+  # The layer is linked before the kernel it calls into
+  list(INSERT RTOS_LIBRARIES 0 cmsis_rtos2)
+endif()
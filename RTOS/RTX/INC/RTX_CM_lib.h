@@ -46,6 +46,10 @@
 #define __USED __root
 #endif
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+#include "PolyMCU.h"
+#endif
+
 
 /*----------------------------------------------------------------------------
  *      Definitions
@@ -54,7 +58,7 @@
 #define _declare_box(pool,size,cnt)  uint32_t pool[(((size)+3)/4)*(cnt) + 3]
 #define _declare_box8(pool,size,cnt) uint64_t pool[(((size)+7)/8)*(cnt) + 2]
 
-#define OS_TCB_SIZE     52
+#define OS_TCB_SIZE     56
 #define OS_TMR_SIZE     8
 
 #if (( defined(__CC_ARM)                                          || \
@@ -68,20 +72,20 @@ typedef uint32_t OS_RESULT;
 
 #define runtask_id()    rt_tsk_self()
 #define mutex_init(m)   rt_mut_init(m)
-#define mutex_wait(m)   os_mut_wait(m,0xFFFFU)
+#define mutex_wait(m)   os_mut_wait(m,0xFFFFFFFFU)
 #define mutex_rel(m)    os_mut_release(m)
 
 extern uint8_t   os_running;
 extern OS_TID    rt_tsk_self    (void);
 extern void      rt_mut_init    (OS_ID mutex);
 extern OS_RESULT rt_mut_release (OS_ID mutex);
-extern OS_RESULT rt_mut_wait    (OS_ID mutex, uint16_t timeout);
+extern OS_RESULT rt_mut_wait    (OS_ID mutex, uint32_t timeout);
 
 #if defined(__CC_ARM)
 #define os_mut_wait(mutex,timeout) _os_mut_wait((uint32_t)rt_mut_wait,mutex,timeout)
 #define os_mut_release(mutex)      _os_mut_release((uint32_t)rt_mut_release,mutex)
 OS_RESULT _os_mut_release (uint32_t p, OS_ID mutex)                   __svc_indirect(0);
-OS_RESULT _os_mut_wait    (uint32_t p, OS_ID mutex, uint16_t timeout) __svc_indirect(0);
+OS_RESULT _os_mut_wait    (uint32_t p, OS_ID mutex, uint32_t timeout) __svc_indirect(0);
 #else
 __attribute__((always_inline))
 static __inline OS_RESULT os_mut_release (OS_ID mutex) {
@@ -100,7 +104,7 @@ static __inline OS_RESULT os_mut_release (OS_ID mutex) {
   return (OS_RESULT)__r0;
 }
 __attribute__((always_inline))
-static __inline OS_RESULT os_mut_wait (OS_ID mutex, uint16_t timeout) {
+static __inline OS_RESULT os_mut_wait (OS_ID mutex, uint32_t timeout) {
   register uint32_t __r0 __asm("r0") = (uint32_t)mutex;
   register uint32_t __r1 __asm("r1") = (uint32_t)timeout;
   register uint32_t __r2 __asm("r2");
@@ -212,6 +216,13 @@ extern
 void *os_active_TCB[];
 void *os_active_TCB[OS_TASK_CNT];
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+/* CPU usage records of the tasks (indexed by 'task_id - 1') */
+extern
+polymcu_cpu_usage_t os_cpu_usage[];
+polymcu_cpu_usage_t os_cpu_usage[OS_TASK_CNT];
+#endif
+
 /* User Timers Resources */
 #if (OS_TIMERS != 0)
 extern void osTimerThread (void const *argument);
@@ -524,6 +535,10 @@ __attribute ((noreturn)) void __cs3_start_c (void){
 
 #else
 
+/* The symbols are expanded: the CMSIS-RTOS2 layer renames the CMSIS-RTOS v1 functions */
+#define __RTX_SYMBOL_STR(s)  #s
+#define __RTX_SYMBOL(s)      __RTX_SYMBOL_STR(s)
+
 __attribute__((naked)) void software_init_hook (void) {
   __asm (
     ".syntax unified\n"
@@ -537,11 +552,11 @@ __attribute__((naked)) void software_init_hook (void) {
     "bl   __libc_init_array\n"
     "mov  r0,r4\n"
     "mov  r1,r5\n"
-    "bl   osKernelInitialize\n"
+    "bl   " __RTX_SYMBOL(osKernelInitialize) "\n"
     "ldr  r0,=os_thread_def_main\n"
     "movs r1,#0\n"
     "bl   osThreadCreate\n"
-    "bl   osKernelStart\n"
+    "bl   " __RTX_SYMBOL(osKernelStart) "\n"
     "bl   exit\n"
   );
 }
@@ -323,6 +323,16 @@ osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority);
 /// \return current priority value of the thread function.
 osPriority osThreadGetPriority (osThreadId thread_id);
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+struct polymcu_cpu_usage_stats;
+
+/// Get the CPU usage of an active thread (PolyMCU extension, see `polymcu_cpu_usage_get()`).
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId or NULL for the current thread.
+/// \param[out]    stats         cumulative cycles, load over the last window and unused stack of the thread.
+/// \return status code that indicates the execution status of the function.
+osStatus osThreadGetCpuUsage (osThreadId thread_id, struct polymcu_cpu_usage_stats *stats);
+#endif
+
 
 //  ==== Generic Wait Functions ====
 
@@ -34,8 +34,8 @@
 
         NAME    HAL_CM4.S
 
-        #define TCB_STACKF 37
-        #define TCB_TSTACK 40
+        #define TCB_STACKF 41
+        #define TCB_TSTACK 44
 
         EXTERN  os_flags
         EXTERN  os_tsk
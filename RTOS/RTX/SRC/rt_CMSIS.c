@@ -424,17 +424,16 @@ extern       osMessageQId    osMessageQId_osTimerMessageQ;
 // ==== Helper Functions ====
 
 /// Convert timeout in millisec to system ticks
-static uint16_t rt_ms2tick (uint32_t millisec) {
-  uint32_t tick;
+static uint32_t rt_ms2tick (uint32_t millisec) {
+  uint64_t tick;
 
   if (millisec == 0U) { return 0x0U; }                  // No timeout
-  if (millisec == osWaitForever) { return 0xFFFFU; }    // Indefinite timeout
-  if (millisec > 4000000U) { return 0xFFFEU; }          // Max ticks supported
+  if (millisec == osWaitForever) { return 0xFFFFFFFFU; }// Indefinite timeout
 
-  tick = ((1000U * millisec) + os_clockrate - 1U)  / os_clockrate;
-  if (tick > 0xFFFEU) { return 0xFFFEU; }
+  tick = ((1000U * (uint64_t)millisec) + os_clockrate - 1U)  / os_clockrate;
+  if (tick > 0xFFFFFFFEU) { return 0xFFFFFFFEU; }       // Max ticks supported
   
-  return (uint16_t)tick;
+  return (uint32_t)tick;
 }
 
 /// Convert Thread ID to TCB pointer
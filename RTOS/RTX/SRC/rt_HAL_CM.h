@@ -227,6 +227,26 @@ __inline static U32 rt_inc_qi (U32 size, U8 *count, U8 *first) {
   return (cnt);
 }
 
+#ifdef __RTX_ISR_DIRECT
+__inline static U32 rt_tas (U8 *flag) {
+  /* Set "flag" and return its previous value */
+  U32 val;
+#ifdef __USE_EXCLUSIVE_ACCESS
+  do {
+    if ((val = __ldrex(flag)) != 0U) {
+      __clrex();
+      return (val); }
+  } while (__strex(1U, flag));
+#else
+  __disable_irq();
+  val = *flag;
+  *flag = 1U;
+  __enable_irq ();
+#endif
+  return (val);
+}
+#endif
+
 __inline static void rt_systick_init (void) {
   NVIC_ST_RELOAD  = os_trv;
   NVIC_ST_CURRENT = 0U;
@@ -278,6 +298,14 @@ extern void dbg_task_switch (U32 task_id);
 #define DBG_TASK_NOTIFY(p_tcb,create) if (dbg_msg) dbg_task_notify(p_tcb,create)
 #define DBG_TASK_SWITCH(task_id)      if (dbg_msg && (os_tsk.next!=os_tsk.run)) \
                                         dbg_task_switch(task_id)
+#elif defined(SUPPORT_RTOS_CPU_USAGE)
+/* Per-task CPU usage accounting of PolyMCU (see RTOS/RTX/cpu_usage.c) */
+extern void rt_cpu_usage_init (void);
+extern void rt_cpu_usage_notify (P_TCB p_tcb, BOOL create);
+extern void rt_cpu_usage_switch (void);
+#define DBG_INIT() rt_cpu_usage_init()
+#define DBG_TASK_NOTIFY(p_tcb,create) rt_cpu_usage_notify(p_tcb,create)
+#define DBG_TASK_SWITCH(task_id)      if (os_tsk.next!=os_tsk.run) rt_cpu_usage_switch()
 #else
 #define DBG_INIT()
 #define DBG_TASK_NOTIFY(p_tcb,create)
@@ -49,12 +49,143 @@ struct OS_XCB  os_rdy;
 /* List head of chained delay tasks */
 struct OS_XCB  os_dly;
 
+#ifdef __RTX_READY_BITMAP
+/* The ready tasks are kept in one FIFO per priority (chained with 'p_lnk') */
+/* and a bitmap of the non-empty FIFOs: the insertion and the selection of  */
+/* the highest priority task do not depend on the number of ready tasks.    */
+/* 'os_rdy.p_lnk' always points to the highest priority ready task.         */
+/* The FIFOs cover the idle demon (0) and the CMSIS-RTOS priorities (1 to   */
+/* 7). The higher priorities (255 while the kernel is initialized) share    */
+/* the last FIFO that is kept ordered by priority.                          */
+#define RDY_FIFO_CNT    8U
+#define RDY_FIFO(prio)  (((U32)(prio) < RDY_FIFO_CNT) ? (U32)(prio) : (RDY_FIFO_CNT - 1U))
+
+#if defined (__CC_ARM)
+#define rt_clz(x)       __clz(x)
+#else
+#define rt_clz(x)       ((U32)__builtin_clz(x))
+#endif
+
+static P_TCB os_rdy_head[RDY_FIFO_CNT];
+static P_TCB os_rdy_tail[RDY_FIFO_CNT];
+static U32   os_rdy_map;
+#endif
+
 
 /*----------------------------------------------------------------------------
  *      Functions
  *---------------------------------------------------------------------------*/
 
 
+#ifdef __RTX_READY_BITMAP
+/*--------------------------- rt_rdy_update ---------------------------------*/
+
+static __inline void rt_rdy_update (void) {
+  /* Point the head of the ready list to the highest priority ready task.   */
+  if (os_rdy_map != 0U) {
+    os_rdy.p_lnk = os_rdy_head[31U - rt_clz(os_rdy_map)];
+  }
+  else {
+    os_rdy.p_lnk = NULL;
+  }
+}
+
+
+/*--------------------------- rt_rdy_put ------------------------------------*/
+
+static void rt_rdy_put (P_TCB p_task, BOOL first) {
+  /* Put task "p_task" at the end of the FIFO of its priority (at its head  */
+  /* if "first" is set).                                                    */
+  U32 fifo = RDY_FIFO(p_task->prio);
+  P_TCB p_CB, p_CB2;
+
+  p_task->p_rlnk = NULL;
+  if (os_rdy_head[fifo] == NULL) {
+    p_task->p_lnk = NULL;
+    os_rdy_head[fifo] = p_task;
+    os_rdy_tail[fifo] = p_task;
+    os_rdy_map |= (1U << fifo);
+  }
+  else if (first) {
+    p_task->p_lnk = os_rdy_head[fifo];
+    os_rdy_head[fifo] = p_task;
+  }
+  else if ((fifo < (RDY_FIFO_CNT - 1U)) || (os_rdy_tail[fifo]->prio >= p_task->prio)) {
+    p_task->p_lnk = NULL;
+    os_rdy_tail[fifo]->p_lnk = p_task;
+    os_rdy_tail[fifo] = p_task;
+  }
+  else {
+    /* Ordered insertion in the last FIFO */
+    p_CB = NULL;
+    p_CB2 = os_rdy_head[fifo];
+    while (p_CB2->prio >= p_task->prio) {
+      p_CB = p_CB2;
+      p_CB2 = p_CB2->p_lnk;
+    }
+    p_task->p_lnk = p_CB2;
+    if (p_CB == NULL) {
+      os_rdy_head[fifo] = p_task;
+    }
+    else {
+      p_CB->p_lnk = p_task;
+    }
+  }
+  rt_rdy_update ();
+}
+
+
+/*--------------------------- rt_rdy_get_first ------------------------------*/
+
+static P_TCB rt_rdy_get_first (void) {
+  /* Remove the highest priority ready task from its FIFO. */
+  U32 fifo = 31U - rt_clz(os_rdy_map);
+  P_TCB p_first;
+
+  p_first = os_rdy_head[fifo];
+  os_rdy_head[fifo] = p_first->p_lnk;
+  if (os_rdy_head[fifo] == NULL) {
+    os_rdy_tail[fifo] = NULL;
+    os_rdy_map &= ~(1U << fifo);
+  }
+  p_first->p_lnk = NULL;
+  rt_rdy_update ();
+  return (p_first);
+}
+
+
+/*--------------------------- rt_rdy_rmv ------------------------------------*/
+
+static BOOL rt_rdy_rmv (U32 fifo, P_TCB p_task) {
+  /* Remove task "p_task" from the FIFO "fifo" if it is enqueued there. */
+  P_TCB p_CB, p_CB2;
+
+  p_CB = NULL;
+  for (p_CB2 = os_rdy_head[fifo]; p_CB2 != NULL; p_CB2 = p_CB2->p_lnk) {
+    if (p_CB2 == p_task) {
+      if (p_CB == NULL) {
+        os_rdy_head[fifo] = p_task->p_lnk;
+      }
+      else {
+        p_CB->p_lnk = p_task->p_lnk;
+      }
+      if (os_rdy_tail[fifo] == p_task) {
+        os_rdy_tail[fifo] = p_CB;
+      }
+      if (os_rdy_head[fifo] == NULL) {
+        os_rdy_map &= ~(1U << fifo);
+      }
+      p_task->p_lnk = NULL;
+      rt_rdy_update ();
+      return (__TRUE);
+    }
+    p_CB = p_CB2;
+  }
+  return (__FALSE);
+}
+#endif
+
+
 /*--------------------------- rt_put_prio -----------------------------------*/
 
 void rt_put_prio (P_XCB p_CB, P_TCB p_task) {
@@ -65,6 +196,12 @@ void rt_put_prio (P_XCB p_CB, P_TCB p_task) {
   U32 prio;
   BOOL sem_mbx = __FALSE;
 
+#ifdef __RTX_READY_BITMAP
+  if (p_CB == &os_rdy) {
+    rt_rdy_put (p_task, __FALSE);
+    return;
+  }
+#endif
   if ((p_CB->cb_type == SCB) || (p_CB->cb_type == MCB) || (p_CB->cb_type == MUCB)) {
     sem_mbx = __TRUE;
   }
@@ -97,6 +234,11 @@ P_TCB rt_get_first (P_XCB p_CB) {
   /* "p_CB" points to head of list. */
   P_TCB p_first;
 
+#ifdef __RTX_READY_BITMAP
+  if (p_CB == &os_rdy) {
+    return (rt_rdy_get_first ());
+  }
+#endif
   p_first = p_CB->p_lnk;
   p_CB->p_lnk = p_first->p_lnk;
   if ((p_CB->cb_type == SCB) || (p_CB->cb_type == MCB) || (p_CB->cb_type == MUCB)) {
@@ -118,9 +260,13 @@ P_TCB rt_get_first (P_XCB p_CB) {
 void rt_put_rdy_first (P_TCB p_task) {
   /* Put task identified with "p_task" at the head of the ready list. The   */
   /* task must have at least a priority equal to highest priority in list.  */
+#ifdef __RTX_READY_BITMAP
+  rt_rdy_put (p_task, __TRUE);
+#else
   p_task->p_lnk = os_rdy.p_lnk;
   p_task->p_rlnk = NULL;
   os_rdy.p_lnk = p_task;
+#endif
 }
 
 
@@ -133,8 +279,12 @@ P_TCB rt_get_same_rdy_prio (void) {
 
   p_first = os_rdy.p_lnk;
   if (p_first->prio == os_tsk.run->prio) {
+#ifdef __RTX_READY_BITMAP
+    return (rt_rdy_get_first ());
+#else
     os_rdy.p_lnk = os_rdy.p_lnk->p_lnk;
     return (p_first);
+#endif
   }
   return (NULL);
 }
@@ -167,7 +317,7 @@ res:rt_rmv_list (p_task);
 
 /*--------------------------- rt_put_dly ------------------------------------*/
 
-void rt_put_dly (P_TCB p_task, U16 delay) {
+void rt_put_dly (P_TCB p_task, U32 delay) {
   /* Put a task identified with "p_task" into chained delay wait list using */
   /* a delay value of "delay".                                              */
   P_TCB p;
@@ -186,7 +336,7 @@ void rt_put_dly (P_TCB p_task, U16 delay) {
 last: p_task->p_dlnk = NULL;
       p->p_dlnk = p_task;
       p_task->p_blnk = p;
-      p->delta_time = (U16)(idelay - delta);
+      p->delta_time = idelay - delta;
       p_task->delta_time = 0U;
       return;
     }
@@ -200,7 +350,7 @@ last: p_task->p_dlnk = NULL;
   if (p_task->p_dlnk != NULL) {
     p_task->p_dlnk->p_blnk = p_task;
   }
-  p_task->delta_time = (U16)(delta - idelay);
+  p_task->delta_time = delta - idelay;
   p->delta_time -= p_task->delta_time;
 }
 
@@ -231,7 +381,7 @@ void rt_dec_dly (void) {
     os_dly.delta_time = p_rdy->delta_time;
     if (p_rdy->state == WAIT_ITV) {
       /* Calculate the next time for interval wait. */
-      p_rdy->delta_time = p_rdy->interval_time + (U16)os_time;
+      p_rdy->delta_time = p_rdy->interval_time + os_time;
     }
     p_rdy->state   = READY;
     os_dly.p_dlnk = p_rdy->p_dlnk;
@@ -250,6 +400,9 @@ void rt_rmv_list (P_TCB p_task) {
   /* Remove task identified with "p_task" from ready, semaphore or mailbox  */
   /* waiting list if enqueued.                                              */
   P_TCB p_b;
+#ifdef __RTX_READY_BITMAP
+  U32 map;
+#endif
 
   if (p_task->p_rlnk != NULL) {
     /* A task is enqueued in semaphore / mailbox waiting list. */
@@ -260,7 +413,21 @@ void rt_rmv_list (P_TCB p_task) {
     return;
   }
 
+#ifdef __RTX_READY_BITMAP
+  if (rt_rdy_rmv (RDY_FIFO(p_task->prio), p_task)) {
+    return;
+  }
+  /* The priority of the task might have been changed before it is re-     */
+  /* sorted: search the other FIFOs.                                        */
+  for (map = os_rdy_map; map != 0U; map &= ~(1U << (31U - rt_clz(map)))) {
+    if (rt_rdy_rmv (31U - rt_clz(map), p_task)) {
+      return;
+    }
+  }
+  p_b = NULL;
+#else
   p_b = (P_TCB)&os_rdy;
+#endif
   while (p_b != NULL) {
     /* Search the ready list for task "p_task" */
     if (p_b->p_lnk == p_task) {
@@ -313,6 +480,21 @@ void rt_psq_enq (OS_ID entry, U32 arg) {
   }
 }
 
+
+#ifdef __RTX_ISR_DIRECT
+/*--------------------------- rt_psq_kick -----------------------------------*/
+
+void rt_psq_kick (OS_ID entry, U8 *pend) {
+  /* Request the service of object "entry" that an ISR has updated directly */
+  /* because a task waits for it. "pend" stays set until the request is     */
+  /* served: the following ISR posts do not use the ps-queue.               */
+  if (rt_tas (pend) == 0U) {
+    rt_psq_enq (entry, 0U);
+    rt_psh_req ();
+  }
+}
+#endif
+
 /*----------------------------------------------------------------------------
  * end of file
  *---------------------------------------------------------------------------*/
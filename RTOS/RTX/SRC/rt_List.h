@@ -51,11 +51,14 @@ extern P_TCB rt_get_first     (P_XCB p_CB);
 extern void  rt_put_rdy_first (P_TCB p_task);
 extern P_TCB rt_get_same_rdy_prio (void);
 extern void  rt_resort_prio   (P_TCB p_task);
-extern void  rt_put_dly       (P_TCB p_task, U16 delay);
+extern void  rt_put_dly       (P_TCB p_task, U32 delay);
 extern void  rt_dec_dly       (void);
 extern void  rt_rmv_list      (P_TCB p_task);
 extern void  rt_rmv_dly       (P_TCB p_task);
 extern void  rt_psq_enq       (OS_ID entry, U32 arg);
+#ifdef __RTX_ISR_DIRECT
+extern void  rt_psq_kick      (OS_ID entry, U8 *pend);
+#endif
 
 /* This is a fast macro generating in-line code */
 #define rt_rdy_prio(void) (os_rdy.p_lnk->prio)
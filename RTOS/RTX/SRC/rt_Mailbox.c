@@ -47,6 +47,86 @@
  *---------------------------------------------------------------------------*/
 
 
+/*--------------------------- rt_mbx_put ------------------------------------*/
+
+static BOOL rt_mbx_put (P_MCB p_MCB, void *p_msg) {
+  /* Store a message in the mailbox queue if it is not full */
+#ifdef __RTX_ISR_DIRECT
+  /* The ISRs store their messages directly: the 3 fields of the queue are  */
+  /* updated together with the interrupts disabled.                         */
+  U32 irq_mask;
+
+  irq_mask = (U32)__disable_irq ();
+  if (p_MCB->count == p_MCB->size) {
+    if (irq_mask == 0U) { __enable_irq (); }
+    return (__FALSE);
+  }
+  p_MCB->msg[p_MCB->first] = p_msg;
+  if (++p_MCB->first == p_MCB->size) {
+    p_MCB->first = 0U;
+  }
+  p_MCB->count++;
+  if (irq_mask == 0U) { __enable_irq (); }
+#else
+  if (p_MCB->count == p_MCB->size) {
+    return (__FALSE);
+  }
+  p_MCB->msg[p_MCB->first] = p_msg;
+  rt_inc (&p_MCB->count);
+  if (++p_MCB->first == p_MCB->size) {
+    p_MCB->first = 0U;
+  }
+#endif
+  return (__TRUE);
+}
+
+
+#ifdef __RTX_ISR_DIRECT
+/*--------------------------- rt_mbx_drain ----------------------------------*/
+
+static void rt_mbx_drain (P_MCB p_MCB) {
+  /* Pass the messages stored by ISRs to the waiting tasks or fill the      */
+  /* space freed by ISRs with the messages of the waiting tasks.            */
+  P_TCB p_TCB;
+  void *p_msg;
+
+  while (p_MCB->p_lnk != NULL) {
+    if ((p_MCB->state == 1U) && (p_MCB->count != 0U)) {
+      /* Task is waiting for a message, pass it the oldest one */
+      p_msg = p_MCB->msg[p_MCB->last];
+      if (++p_MCB->last == p_MCB->size) {
+        p_MCB->last = 0U;
+      }
+      rt_dec (&p_MCB->count);
+      p_TCB = rt_get_first ((P_XCB)p_MCB);
+#ifdef __CMSIS_RTOS
+      rt_ret_val2(p_TCB, 0x10U/*osEventMessage*/, (U32)p_msg);
+#else
+      *p_TCB->msg = p_msg;
+      rt_ret_val (p_TCB, OS_R_MBX);
+#endif
+    }
+    else if ((p_MCB->state == 2U) && (p_MCB->count != p_MCB->size)) {
+      /* Task is waiting to send a message, store it */
+      p_TCB = rt_get_first ((P_XCB)p_MCB);
+      rt_mbx_put (p_MCB, p_TCB->msg);
+#ifdef __CMSIS_RTOS
+      rt_ret_val(p_TCB, 0U/*osOK*/);
+#else
+      rt_ret_val(p_TCB, OS_R_OK);
+#endif
+    }
+    else {
+      break;
+    }
+    p_TCB->state = READY;
+    rt_rmv_dly (p_TCB);
+    rt_put_prio (&os_rdy, p_TCB);
+  }
+}
+#endif
+
+
 /*--------------------------- rt_mbx_init -----------------------------------*/
 
 void rt_mbx_init (OS_ID mailbox, U16 mbx_size) {
@@ -67,11 +147,14 @@ void rt_mbx_init (OS_ID mailbox, U16 mbx_size) {
 
 /*--------------------------- rt_mbx_send -----------------------------------*/
 
-OS_RESULT rt_mbx_send (OS_ID mailbox, void *p_msg, U16 timeout) {
+OS_RESULT rt_mbx_send (OS_ID mailbox, void *p_msg, U32 timeout) {
   /* Send message to a mailbox */
   P_MCB p_MCB = mailbox;
   P_TCB p_TCB;
 
+#ifdef __RTX_ISR_DIRECT
+  rt_mbx_drain (p_MCB);
+#endif
   if ((p_MCB->p_lnk != NULL) && (p_MCB->state == 1U)) {
     /* A task is waiting for message */
     p_TCB = rt_get_first ((P_XCB)p_MCB);
@@ -86,7 +169,7 @@ OS_RESULT rt_mbx_send (OS_ID mailbox, void *p_msg, U16 timeout) {
   }
   else {
     /* Store message in mailbox queue */
-    if (p_MCB->count == p_MCB->size) {
+    if (rt_mbx_put (p_MCB, p_msg) == __FALSE) {
       /* No free message entry, wait for one. If message queue is full, */
       /* then no task is waiting for message. The 'p_MCB->p_lnk' list   */
       /* pointer can now be reused for send message waits task list.    */
@@ -105,14 +188,14 @@ OS_RESULT rt_mbx_send (OS_ID mailbox, void *p_msg, U16 timeout) {
       }
       os_tsk.run->msg = p_msg;
       rt_block (timeout, WAIT_MBX);
+#ifdef __RTX_ISR_DIRECT
+      if (p_MCB->count != p_MCB->size) {
+        /* An ISR has received a message before the task was enqueued */
+        rt_psq_kick (p_MCB, &p_MCB->isr_st);
+      }
+#endif
       return (OS_R_TMO);
     }
-    /* Yes, there is a free entry in a mailbox. */
-    p_MCB->msg[p_MCB->first] = p_msg;
-    rt_inc (&p_MCB->count);
-    if (++p_MCB->first == p_MCB->size) {
-      p_MCB->first = 0U;
-    }
   }
   return (OS_R_OK);
 }
@@ -120,11 +203,14 @@ OS_RESULT rt_mbx_send (OS_ID mailbox, void *p_msg, U16 timeout) {
 
 /*--------------------------- rt_mbx_wait -----------------------------------*/
 
-OS_RESULT rt_mbx_wait (OS_ID mailbox, void **message, U16 timeout) {
+OS_RESULT rt_mbx_wait (OS_ID mailbox, void **message, U32 timeout) {
   /* Receive a message; possibly wait for it */
   P_MCB p_MCB = mailbox;
   P_TCB p_TCB;
 
+#ifdef __RTX_ISR_DIRECT
+  rt_mbx_drain (p_MCB);
+#endif
   /* If a message is available in the fifo buffer */
   /* remove it from the fifo buffer and return. */
   if (p_MCB->count) {
@@ -169,6 +255,12 @@ OS_RESULT rt_mbx_wait (OS_ID mailbox, void **message, U16 timeout) {
   rt_block(timeout, WAIT_MBX);
 #ifndef __CMSIS_RTOS
   os_tsk.run->msg = message;
+#endif
+#ifdef __RTX_ISR_DIRECT
+  if (p_MCB->count != 0U) {
+    /* An ISR has sent a message before the task was enqueued */
+    rt_psq_kick (p_MCB, &p_MCB->isr_st);
+  }
 #endif
   return (OS_R_TMO);
 }
@@ -191,8 +283,19 @@ void isr_mbx_send (OS_ID mailbox, void *p_msg) {
   /* Same function as "os_mbx_send", but to be called by ISRs. */
   P_MCB p_MCB = mailbox;
 
+#ifdef __RTX_ISR_DIRECT
+  /* Store the message, the kernel is only requested when a task waits */
+  if (rt_mbx_put (p_MCB, p_msg) == __FALSE) {
+    os_error (OS_ERR_MBX_OVF);
+    return;
+  }
+  if ((p_MCB->p_lnk != NULL) && (p_MCB->state == 1U)) {
+    rt_psq_kick (p_MCB, &p_MCB->isr_st);
+  }
+#else
   rt_psq_enq (p_MCB, (U32)p_msg);
   rt_psh_req ();
+#endif
 }
 
 
@@ -206,6 +309,16 @@ OS_RESULT isr_mbx_receive (OS_ID mailbox, void **message) {
   if (p_MCB->count) {
     /* A message is available in the fifo buffer. */
     *message = p_MCB->msg[p_MCB->last];
+#ifdef __RTX_ISR_DIRECT
+    if (++p_MCB->last == p_MCB->size) {
+      p_MCB->last = 0U;
+    }
+    rt_dec (&p_MCB->count);
+    if ((p_MCB->p_lnk != NULL) && (p_MCB->state == 2U)) {
+      /* A task is locked waiting to send message */
+      rt_psq_kick (p_MCB, &p_MCB->isr_st);
+    }
+#else
     if ((p_MCB->p_lnk != NULL) && (p_MCB->state == 2U)) {
       /* A task is locked waiting to send message */
       rt_psq_enq (p_MCB, 0U);
@@ -215,6 +328,7 @@ OS_RESULT isr_mbx_receive (OS_ID mailbox, void **message) {
     if (++p_MCB->last == p_MCB->size) {
       p_MCB->last = 0U;
     }
+#endif
     return (OS_R_MBX);
   }
   return (OS_R_OK);
@@ -228,6 +342,14 @@ void rt_mbx_psh (P_MCB p_CB, void *p_msg) {
   P_TCB p_TCB;
   void *mem;
 
+#ifdef __RTX_ISR_DIRECT
+  if (p_msg == NULL) {
+    /* The ISRs have already updated the mailbox queue */
+    p_CB->isr_st = 0U;
+    rt_mbx_drain (p_CB);
+    return;
+  }
+#endif
   if (p_CB->p_lnk != NULL) switch (p_CB->state) {
 #ifdef __CMSIS_RTOS
     case 3:
@@ -249,11 +371,7 @@ void rt_mbx_psh (P_MCB p_CB, void *p_msg) {
 #else
       rt_ret_val(p_TCB, OS_R_OK);
 #endif
-      p_CB->msg[p_CB->first] = p_TCB->msg;
-      rt_inc (&p_CB->count);
-      if (++p_CB->first == p_CB->size) {
-        p_CB->first = 0U;
-      }
+      rt_mbx_put (p_CB, p_TCB->msg);
       p_TCB->state = READY;
       rt_rmv_dly (p_TCB);
       rt_put_prio (&os_rdy, p_TCB);
@@ -275,14 +393,7 @@ void rt_mbx_psh (P_MCB p_CB, void *p_msg) {
       break;
   } else {
     /* No task is waiting for a message, store it to the mailbox queue */
-    if (p_CB->count < p_CB->size) {
-      p_CB->msg[p_CB->first] = p_msg;
-      rt_inc (&p_CB->count);
-      if (++p_CB->first == p_CB->size) {
-        p_CB->first = 0U;
-      }
-    }
-    else {
+    if (rt_mbx_put (p_CB, p_msg) == __FALSE) {
       os_error (OS_ERR_MBX_OVF);
     }
   }
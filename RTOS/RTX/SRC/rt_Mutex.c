@@ -215,7 +215,7 @@ OS_RESULT rt_mut_release (OS_ID mutex) {
 
 /*--------------------------- rt_mut_wait -----------------------------------*/
 
-OS_RESULT rt_mut_wait (OS_ID mutex, U16 timeout) {
+OS_RESULT rt_mut_wait (OS_ID mutex, U32 timeout) {
   /* Wait for a mutex, continue when mutex is free. */
   P_MUCB p_MCB = mutex;
 
@@ -46,6 +46,29 @@
  *---------------------------------------------------------------------------*/
 
 
+#ifdef __RTX_ISR_DIRECT
+/*--------------------------- rt_sem_drain ----------------------------------*/
+
+static void rt_sem_drain (P_SCB p_SCB) {
+  /* Pass the tokens returned by ISRs to the waiting tasks */
+  P_TCB p_TCB;
+
+  while ((p_SCB->p_lnk != NULL) && (p_SCB->tokens != 0U)) {
+    rt_dec (&p_SCB->tokens);
+    p_TCB = rt_get_first ((P_XCB)p_SCB);
+    rt_rmv_dly (p_TCB);
+    p_TCB->state   = READY;
+#ifdef __CMSIS_RTOS
+    rt_ret_val(p_TCB, 1U);
+#else
+    rt_ret_val(p_TCB, OS_R_SEM);
+#endif
+    rt_put_prio (&os_rdy, p_TCB);
+  }
+}
+#endif
+
+
 /*--------------------------- rt_sem_init -----------------------------------*/
 
 void rt_sem_init (OS_ID semaphore, U16 token_count) {
@@ -53,6 +76,7 @@ void rt_sem_init (OS_ID semaphore, U16 token_count) {
   P_SCB p_SCB = semaphore;
 
   p_SCB->cb_type = SCB;
+  p_SCB->mask   = 0U;
   p_SCB->p_lnk  = NULL;
   p_SCB->tokens = token_count;
 }
@@ -96,6 +120,9 @@ OS_RESULT rt_sem_send (OS_ID semaphore) {
   P_SCB p_SCB = semaphore;
   P_TCB p_TCB;
 
+#ifdef __RTX_ISR_DIRECT
+  rt_sem_drain (p_SCB);
+#endif
   if (p_SCB->p_lnk != NULL) {
     /* A task is waiting for token */
     p_TCB = rt_get_first ((P_XCB)p_SCB);
@@ -109,7 +136,11 @@ OS_RESULT rt_sem_send (OS_ID semaphore) {
   }
   else {
     /* Store token. */
+#ifdef __RTX_ISR_DIRECT
+    rt_inc (&p_SCB->tokens);
+#else
     p_SCB->tokens++;
+#endif
   }
   return (OS_R_OK);
 }
@@ -117,12 +148,19 @@ OS_RESULT rt_sem_send (OS_ID semaphore) {
 
 /*--------------------------- rt_sem_wait -----------------------------------*/
 
-OS_RESULT rt_sem_wait (OS_ID semaphore, U16 timeout) {
+OS_RESULT rt_sem_wait (OS_ID semaphore, U32 timeout) {
   /* Obtain a token; possibly wait for it */
   P_SCB p_SCB = semaphore;
 
+#ifdef __RTX_ISR_DIRECT
+  rt_sem_drain (p_SCB);
+#endif
   if (p_SCB->tokens) {
+#ifdef __RTX_ISR_DIRECT
+    rt_dec (&p_SCB->tokens);
+#else
     p_SCB->tokens--;
+#endif
     return (OS_R_OK);
   }
   /* No token available: wait for one */
@@ -138,6 +176,12 @@ OS_RESULT rt_sem_wait (OS_ID semaphore, U16 timeout) {
     os_tsk.run->p_rlnk = (P_TCB)p_SCB;
   }
   rt_block(timeout, WAIT_SEM);
+#ifdef __RTX_ISR_DIRECT
+  if (p_SCB->tokens != 0U) {
+    /* An ISR has returned a token before the task was enqueued */
+    rt_psq_kick (p_SCB, &p_SCB->mask);
+  }
+#endif
   return (OS_R_TMO);
 }
 
@@ -148,8 +192,16 @@ void isr_sem_send (OS_ID semaphore) {
   /* Same function as "os_sem_send", but to be called by ISRs */
   P_SCB p_SCB = semaphore;
 
+#ifdef __RTX_ISR_DIRECT
+  /* Store the token, the kernel is only requested when a task waits */
+  rt_inc (&p_SCB->tokens);
+  if (p_SCB->p_lnk != NULL) {
+    rt_psq_kick (p_SCB, &p_SCB->mask);
+  }
+#else
   rt_psq_enq (p_SCB, 0U);
   rt_psh_req ();
+#endif
 }
 
 
@@ -157,6 +209,11 @@ void isr_sem_send (OS_ID semaphore) {
 
 void rt_sem_psh (P_SCB p_CB) {
   /* Check if task has to be waken up */
+#ifdef __RTX_ISR_DIRECT
+  /* The ISRs have already stored their tokens */
+  p_CB->mask = 0U;
+  rt_sem_drain (p_CB);
+#else
   P_TCB p_TCB;
 
   if (p_CB->p_lnk != NULL) {
@@ -175,6 +232,7 @@ void rt_sem_psh (P_SCB p_CB) {
     /* Store token */
     p_CB->tokens++;
   }
+#endif
 }
 
 /*----------------------------------------------------------------------------
@@ -82,7 +82,7 @@ extern U32 sysUserTimerWakeupTime(void);
 
 U32 rt_suspend (void) {
   /* Suspend OS scheduler */
-  U32 delta = 0xFFFFU;
+  U32 delta = 0xFFFFFFFFU;
 #ifdef __CMSIS_RTOS
   U32 sleep;
 #endif
@@ -134,7 +134,7 @@ void rt_resume (U32 sleep_time) {
       }
     } else {
       os_time           +=      delta;
-      os_dly.delta_time -= (U16)delta;
+      os_dly.delta_time -=      delta;
     }
   } else {
     os_time += sleep_time;
@@ -168,6 +168,14 @@ void rt_resume (U32 sleep_time) {
 }
 
 
+/*--------------------------- rt_psh_pending --------------------------------*/
+
+U32 rt_psh_pending (void) {
+  /* Check for ISR requests deferred while the scheduler is locked */
+  return ((U32)os_psh_flag);
+}
+
+
 /*--------------------------- rt_tsk_lock -----------------------------------*/
 
 void rt_tsk_lock (void) {
@@ -42,6 +42,7 @@ extern void rt_resume     (U32 sleep_time);
 extern void rt_tsk_lock   (void);
 extern void rt_tsk_unlock (void);
 extern void rt_psh_req    (void);
+extern U32  rt_psh_pending (void);
 extern void rt_pop_req    (void);
 extern void rt_systick    (void);
 extern void rt_stk_check  (void);
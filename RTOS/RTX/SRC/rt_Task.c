@@ -134,14 +134,14 @@ void rt_dispatch (P_TCB next_TCB) {
 
 /*--------------------------- rt_block --------------------------------------*/
 
-void rt_block (U16 timeout, U8 block_state) {
+void rt_block (U32 timeout, U8 block_state) {
   /* Block running task and choose next ready task.                         */
-  /* "timeout" sets a time-out value or is 0xffff (=no time-out).           */
+  /* "timeout" sets a time-out value or is 0xffffffff (=no time-out).       */
   /* "block_state" defines the appropriate task state */
   P_TCB next_TCB;
 
   if (timeout) {
-    if (timeout < 0xFFFFU) {
+    if (timeout < 0xFFFFFFFFU) {
       rt_put_dly (os_tsk.run, timeout);
     }
     os_tsk.run->state = block_state;
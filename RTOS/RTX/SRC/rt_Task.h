@@ -63,7 +63,7 @@ extern struct OS_TCB os_idle_TCB;
 /* Functions */
 extern void      rt_switch_req (P_TCB p_next);
 extern void      rt_dispatch   (P_TCB next_TCB);
-extern void      rt_block      (U16 timeout, U8 block_state);
+extern void      rt_block      (U32 timeout, U8 block_state);
 extern void      rt_tsk_pass   (void);
 extern OS_TID    rt_tsk_self   (void);
 extern OS_RESULT rt_tsk_prio   (OS_TID task_id, U8 new_prio);
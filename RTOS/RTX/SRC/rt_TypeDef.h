@@ -59,8 +59,8 @@ typedef struct OS_TCB {
   struct OS_TCB *p_rlnk;          /* Link pointer for sem./mbx lst backwards */
   struct OS_TCB *p_dlnk;          /* Link pointer for delay list             */
   struct OS_TCB *p_blnk;          /* Link pointer for delay list backwards   */
-  U16    delta_time;              /* Time until time out                     */
-  U16    interval_time;           /* Time interval for periodic waits        */
+  U32    delta_time;              /* Time until time out                     */
+  U32    interval_time;           /* Time interval for periodic waits        */
   U16    events;                  /* Event flags                             */
   U16    waits;                   /* Wait flags                              */
   void   **msg;                   /* Direct message passing when task waits  */
@@ -77,8 +77,8 @@ typedef struct OS_TCB {
   /* Task entry point used for uVision debugger                              */
   FUNCP  ptask;                   /* Task entry address                      */
 } *P_TCB;
-#define TCB_STACKF      37        /* 'stack_frame' offset                    */
-#define TCB_TSTACK      40        /* 'tsk_stack' offset                      */
+#define TCB_STACKF      41        /* 'stack_frame' offset                    */
+#define TCB_TSTACK      44        /* 'tsk_stack' offset                      */
 
 typedef struct OS_PSFE {          /* Post Service Fifo Entry                 */
   void  *id;                      /* Object Identification                   */
@@ -110,7 +110,7 @@ typedef struct OS_XCB {
   struct OS_TCB *p_rlnk;          /* Link pointer for sem./mbx lst backwards */
   struct OS_TCB *p_dlnk;          /* Link pointer for delay list             */
   struct OS_TCB *p_blnk;          /* Link pointer for delay list backwards   */
-  U16    delta_time;              /* Time until time out                     */
+  U32    delta_time;              /* Time until time out                     */
 } *P_XCB;
 
 typedef struct OS_MCB {
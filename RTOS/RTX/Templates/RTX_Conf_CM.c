@@ -215,6 +215,13 @@
  
 #define OS_TRV          ((uint32_t)(((double)OS_CLOCK*(double)OS_TICK)/1E6)-1)
  
+#ifdef __RTX_TICKLESS
+ #if (OS_SYSTICK == 0)
+  #error "The RTX tickless idle requires the SysTick as RTX Kernel Timer"
+ #endif
+
+extern void os_tickless_idle (void);
+#endif
 
 /*----------------------------------------------------------------------------
  *      Global Functions
@@ -226,7 +233,11 @@
 void os_idle_demon (void) {
  
   for (;;) {
+#ifdef __RTX_TICKLESS
+    os_tickless_idle();
+#else
 	__asm volatile ("wfi");
+#endif
   }
 }
  
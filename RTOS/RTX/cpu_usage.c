@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Per-task CPU usage of RTX (`SUPPORT_RTOS_CPU_USAGE`). The debug hooks of the kernel
+ * (DBG_INIT(), DBG_TASK_NOTIFY() and DBG_TASK_SWITCH() of rt_HAL_CM.h) account the CPU
+ * cycles of the task that is switched out (see Lib/PolyMCU/cpu_usage.c).
+ */
+
+// The RTX headers first: rt_TypeDef.h defines NULL without checking it is defined
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+
+#include "PolyMCU.h"
+
+#include "rt_Task.h"
+
+// Stack filling of rt_HAL_CM.h (its intrinsics clash with the CMSIS core headers)
+#define MAGIC_PATTERN		0xCCCCCCCCU
+
+#define os_thread_cb OS_TCB
+
+#include "cmsis_os.h"
+
+// Records of the tasks (allocated in RTX_CM_lib.h) and of the idle demon
+extern polymcu_cpu_usage_t os_cpu_usage[];
+static polymcu_cpu_usage_t g_cpu_usage_idle;
+
+static polymcu_cpu_usage_t* rt_cpu_usage_get(P_TCB p_tcb) {
+	if (p_tcb == NULL) {
+		return NULL;
+	} else if (p_tcb->task_id == 255U) {
+		return &g_cpu_usage_idle;
+	} else if ((p_tcb->task_id == 0U) || (p_tcb->task_id > os_maxtaskrun)) {
+		return NULL;
+	} else {
+		return &os_cpu_usage[p_tcb->task_id - 1U];
+	}
+}
+
+void rt_cpu_usage_init(void) {
+	polymcu_cpu_usage_add(&g_cpu_usage_idle, "idle", &os_idle_TCB, NULL, POLYMCU_CPU_USAGE_IDLE);
+}
+
+void rt_cpu_usage_notify(P_TCB p_tcb, BOOL create) {
+	polymcu_cpu_usage_t* usage = rt_cpu_usage_get(p_tcb);
+
+	if (usage == NULL) {
+		return;
+	}
+
+	if (create) {
+		// RTX tasks have no name
+		polymcu_cpu_usage_add(usage, NULL, p_tcb, NULL, 0);
+	} else {
+		polymcu_cpu_usage_remove(usage);
+		usage->thread = NULL;
+	}
+}
+
+// Called by rt_switch_req() before 'os_tsk.run' is replaced by 'os_tsk.next'
+void rt_cpu_usage_switch(void) {
+	polymcu_cpu_usage_switch(rt_cpu_usage_get(os_tsk.run));
+}
+
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_find(void* thread) {
+	polymcu_cpu_usage_t* usage;
+
+	if (thread == NULL) {
+		thread = os_tsk.run;
+	}
+
+	usage = rt_cpu_usage_get((P_TCB)thread);
+	if ((usage == NULL) || (usage->thread != thread)) {
+		// Not an active task
+		return NULL;
+	}
+	return usage;
+}
+
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_running(void) {
+	return rt_cpu_usage_get(os_tsk.run);
+}
+
+uint32_t polymcu_rtos_cpu_usage_stack_free(const polymcu_cpu_usage_t* usage) {
+	P_TCB p_tcb = (P_TCB)usage->thread;
+	uint32_t size, count;
+
+	// The stacks are only filled with MAGIC_PATTERN with RTOS_STACK_WATERMARK
+	if (((os_stackinfo & 0x10000000U) == 0U) || (p_tcb == NULL) || (p_tcb->stack == NULL)) {
+		return POLYMCU_CPU_USAGE_NO_STACK;
+	}
+
+	size = (p_tcb->priv_stack != 0U) ? p_tcb->priv_stack : (U16)os_stackinfo;
+
+	// The first word of the stack holds MAGIC_WORD
+	for (count = 1; count < size / sizeof(uint32_t); count++) {
+		if (p_tcb->stack[count] != MAGIC_PATTERN) {
+			break;
+		}
+	}
+	return (count - 1) * sizeof(uint32_t);
+}
+
+osStatus osThreadGetCpuUsage(osThreadId thread_id, polymcu_cpu_usage_stats_t* stats) {
+	if (polymcu_cpu_usage_get(thread_id, stats) != 0) {
+		return osErrorParameter;
+	}
+	return osOK;
+}
+
+static void cpu_usage_report_thread(void const* argument) {
+	uint32_t period_ms = (uint32_t)argument;
+
+	for (;;) {
+		osDelay(period_ms);
+		polymcu_cpu_usage_dump();
+	}
+}
+
+// The report runs on the default stack (RTOS_TASK_STACK_SIZE) that must hold printf()
+osThreadDef(cpu_usage_report_thread, osPriorityRealtime, 1, 0);
+
+int polymcu_cpu_usage_start_report(unsigned int period_ms) {
+	if (period_ms == 0) {
+		return 1;
+	}
+	return (osThreadCreate(osThread(cpu_usage_report_thread), (void*)period_ms) != NULL) ? 0 : 1;
+}
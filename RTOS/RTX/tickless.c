@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * RTX tickless idle driven by the PolyMCU timer (`SUPPORT_RTOS_TICKLESS`).
+ * The RTX tick stays on the SysTick. When all the threads are blocked, the idle demon
+ * suspends the scheduler with os_suspend() (it also masks the SysTick interrupt) and a
+ * one-time task of the PolyMCU timer wakes the core up at the next RTX deadline. The
+ * PolyMCU timer period is the RTX tick. On wake up, os_resume() catches `os_time`, the
+ * thread timeouts and the user timers up with the ticks the core has slept.
+ */
+
+#include "cmsis_os.h"
+#include "PolyMCU.h"
+
+// Longest sleep (in RTX ticks). os_suspend() returns 0xFFFFFFFF when there is no deadline
+#define TICKLESS_MAX_TICKS      0x7FFFFFFFU
+
+// RTX tick interval in us (see RTX_CM_lib.h)
+extern const uint32_t os_clockrate;
+// Interrupt requests deferred while the scheduler is suspended (see rt_System.c)
+extern uint32_t rt_psh_pending(void);
+
+// 0: PolyMCU timer not initialized yet, 1: tickless idle, -1: the timer cannot be used
+static int g_tickless_state;
+
+static void rtx_wake_up(void* arg) {
+	// Nothing to do, the interrupt has woken up the core
+}
+
+// Sleep for at most 'ticks' RTX ticks. Return the number of ticks the core has slept
+static uint32_t rtx_sleep(uint32_t ticks) {
+	polymcu_timer_task_t wake_up_task;
+	unsigned int start;
+
+	// The interrupts still wake up the core from WFI but they are only served once the
+	// sleep has been set up
+	__disable_irq();
+
+	// An interrupt has posted a request to the kernel since os_suspend()
+	if (rt_psh_pending()) {
+		__enable_irq();
+		return 0;
+	}
+
+	wake_up_task = polymcu_timer_create_one_time_task(rtx_wake_up, ticks, NULL);
+	if (wake_up_task == NULL) {
+		// No free timer task, wait for the interrupt with the RTX tick
+		__enable_irq();
+		return 0;
+	}
+	start = polymcu_timer_get_value();
+	polymcu_timer_start_task(wake_up_task);
+
+	polymcu_timer_hw_pre_sleep(ticks);
+	__DSB();
+	__WFI();
+	__ISB();
+	polymcu_timer_hw_post_sleep(ticks);
+
+	// Serve the interrupt that has woken up the core. It might not be the PolyMCU timer
+	__enable_irq();
+	__disable_irq();
+
+	polymcu_timer_stop_task(wake_up_task);
+	polymcu_timer_remove_task(wake_up_task);
+	ticks = polymcu_timer_get_value() - start;
+
+	__enable_irq();
+	return ticks;
+}
+
+void os_tickless_idle(void) {
+	uint32_t sleep;
+
+	if (g_tickless_state == 0) {
+		g_tickless_state = (polymcu_timer_init(1000000U / os_clockrate) == 0) ? 1 : -1;
+	}
+	if (g_tickless_state < 0) {
+		__WFI();
+		return;
+	}
+
+	// Ticks until the next thread timeout or user timer
+	sleep = os_suspend();
+	if (sleep > 1) {
+		if (sleep > TICKLESS_MAX_TICKS) {
+			sleep = TICKLESS_MAX_TICKS;
+		}
+		os_resume(rtx_sleep(sleep));
+	} else {
+		// The deadline is the next RTX tick
+		os_resume(0);
+		__WFI();
+	}
+}
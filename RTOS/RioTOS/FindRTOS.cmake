@@ -43,6 +43,12 @@ add_definitions(-DCOREIF_NG=1)
 set(RTOS_LIBRARIES riot_rtos)
 
 # CMSIS RTOS support
-if(NOT SUPPORT_RTOS_NO_CMSIS)
+if(SUPPORT_RTOS_CMSIS2)
+  # The CMSIS-RTOS layer is only used by the CMSIS-RTOS2 layer (see RTOS/CMSIS_RTOS2)
+  include_directories(${CMAKE_CURRENT_LIST_DIR}/../CMSIS_RTOS2/Include)
+  add_definitions(-D__CMSIS_RTOS2)
+  # The layer is linked before the kernel it calls into
+  list(INSERT RTOS_LIBRARIES 0 cmsis_rtos2)
+elseif(NOT SUPPORT_RTOS_NO_CMSIS)
   add_definitions(-D__CMSIS_RTOS)
 endif()
@@ -24,51 +24,403 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
 #include "cmsis_os.h"
+#include "irq.h"
+#include "kernel_internal.h"
+#include "priority_queue.h"
+#include "sched.h"
 #include "thread.h"
 #include "cmsis_riotos.h"
+#include "PolyMCU.h"
 
-// Stack allocations
-//TODO: This is a simple allocator, we do not support task termination...
-char m_stacks[RTOS_TASK_COUNT * RTOS_TASK_STACK_SIZE];
-char* m_stacks_ptr = m_stacks;
+/*
+ * The timeouts of the CMSIS layer (delays, timeouts of the blocking calls and CMSIS timers)
+ * are kept in a list ordered by deadline. A single PolyMCU timer task is programmed for the
+ * earliest deadline: in tickless mode the core sleeps until then.
+ */
+#define OS_TICK_RATE		1000	// PolyMCU timer ticks per second: one tick per millisecond
 
-osStatus osDelay (uint32_t millisec) {
-	//TODO: Implement me
-	return osEventTimeout;
+// What a blocked thread waits for
+#define OS_WAIT_NONE		0
+#define OS_WAIT_DELAY		1
+#define OS_WAIT_SIGNAL		2
+#define OS_WAIT_OBJECT		3
+
+#define OS_SIGNAL_MASK		((1UL << osFeature_Signals) - 1)
+#define OS_SIGNAL_ERROR		((int32_t)0x80000000)
+
+#if RTOS_TASK_COUNT > 32
+  #error "The stack pool only supports up to 32 stacks"
+#endif
+
+typedef struct os_timeout {
+	struct os_timeout* next;
+	unsigned int       deadline;	// PolyMCU timer tick
+	void               (*function)(struct os_timeout* timeout);
+	uint32_t           active;
+} os_timeout_t;
+
+typedef struct {
+	char*                 stack;		// Stack from the pool (NULL for the threads not created by osThreadCreate())
+	uint32_t              stack_blocks;	// Blocks of the stack pool used by the stack
+	os_pthread            pthread;
+	void*                 argument;
+	int32_t               signals;
+	int32_t               wait_signals;	// Signals waited by osSignalWait() (0 for any signal)
+	uint32_t              wait;			// What the thread is blocked on (OS_WAIT_xxx)
+	priority_queue_t*     wait_queue;	// Waiters of the object the thread is blocked on
+	priority_queue_node_t wait_node;
+	uint32_t              wait_value;	// Value exchanged with the thread that wakes it up
+	osStatus              wait_status;	// osOK when woken up, otherwise the reason of the wake up
+	os_timeout_t          timeout;
+} os_thread_t;
+
+typedef struct os_timer_cb {
+	os_timeout_t        timeout;
+	struct os_timer_cb* next_expired;
+	os_ptimer           ptimer;
+	void*               argument;
+	uint32_t            period;		// Ticks between two expirations, 0 for a one-shot timer
+	uint32_t            expired;	// The timer is in the list of expired timers
+} os_timer_t;
+
+typedef struct os_mutex_cb {
+	kernel_pid_t     owner;
+	uint32_t         count;		// Recursive locks of the owner
+	priority_queue_t waiters;
+} os_mutex_t;
+
+typedef struct os_semaphore_cb {
+	uint32_t         count;
+	priority_queue_t waiters;
+} os_semaphore_t;
+
+typedef struct os_messageQ_cb {
+	uint32_t         size;
+	uint32_t         head;
+	uint32_t         count;
+	priority_queue_t senders;	// Threads waiting for room in the queue
+	priority_queue_t receivers;	// Threads waiting for a message
+	uint32_t         messages[];
+} os_message_t;
+
+// The control blocks are allocated by the macros of 'cmsis_os.h'
+_Static_assert(sizeof(os_timer_t) <= 9 * sizeof(uint32_t), "Update osTimerDef()");
+_Static_assert(sizeof(os_mutex_t) <= 3 * sizeof(uint32_t), "Update osMutexDef()");
+_Static_assert(sizeof(os_semaphore_t) <= 2 * sizeof(uint32_t), "Update osSemaphoreDef()");
+_Static_assert(sizeof(os_message_t) <= 5 * sizeof(uint32_t), "Update osMessageQDef()");
+
+// Stack pool: a thread uses contiguous blocks of RTOS_TASK_STACK_SIZE bytes
+static char g_os_stacks[RTOS_TASK_COUNT][RTOS_TASK_STACK_SIZE] __attribute__((aligned(8)));
+static uint32_t g_os_stacks_used;
+
+// The CMSIS state of the threads indexed by their RIOT PID
+static os_thread_t g_os_threads[KERNEL_PID_LAST + 1];
+
+static os_timeout_t* g_os_timeouts;
+static polymcu_timer_task_t g_os_timer_task;
+static int g_os_timer_initialized;
+
+// Expired CMSIS timers whose function must be called by the timer thread
+static os_timer_t* g_os_timers_expired;
+static os_timer_t** g_os_timers_expired_tail = &g_os_timers_expired;
+static priority_queue_t g_os_timer_thread_waiter = PRIORITY_QUEUE_INIT;
+static kernel_pid_t g_os_timer_thread_pid = KERNEL_PID_UNDEF;
+
+static inline unsigned int os_ms_to_ticks(uint32_t millisec) {
+	return ((uint64_t)millisec * OS_TICK_RATE + 999) / 1000;
 }
 
-/// Create a thread and add it to Active Threads and set it to state READY.
-/// \param[in]     thread_def    thread definition referenced with \ref osThread.
-/// \param[in]     argument      pointer that is passed to the thread function as start argument.
-/// \return thread ID for reference by other functions or NULL in case of error.
-/// \note MUST REMAIN UNCHANGED: \b osThreadCreate shall be consistent in every CMSIS-RTOS.
-osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
+static inline int os_thread_is_valid(osThreadId thread_id) {
+	return pid_is_valid(thread_id) && (sched_threads[thread_id] != NULL);
+}
+
+//  ==== Timeouts ====
+
+static void os_timeout_expired(void* arg);
+
+// Program the PolyMCU timer for the earliest deadline. Must be called with the interrupts disabled
+static void os_timeout_program(void) {
+	if (g_os_timer_task != NULL) {
+		polymcu_timer_remove_task(g_os_timer_task);
+		g_os_timer_task = NULL;
+	}
+
+	if (g_os_timeouts != NULL) {
+		int delay = (int)(g_os_timeouts->deadline - polymcu_timer_get_value());
+
+		g_os_timer_task = polymcu_timer_create_one_time_task(os_timeout_expired, (delay > 0) ? delay : 0, NULL);
+		polymcu_timer_start_task(g_os_timer_task);
+	}
+}
+
+// Must be called with the interrupts disabled
+static void os_timeout_start(os_timeout_t* timeout, unsigned int ticks) {
+	os_timeout_t** prev = &g_os_timeouts;
+	unsigned int now;
+
+	if (!g_os_timer_initialized) {
+		polymcu_timer_init(OS_TICK_RATE);
+		g_os_timer_initialized = 1;
+	}
+
+	now = polymcu_timer_get_value();
+	timeout->deadline = now + ticks;
+	timeout->active = 1;
+
+	// Timeouts with the same deadline are kept in the order they have been started. The
+	// expired timeouts that have not been processed yet stay in front.
+	while ((*prev != NULL) && ((int)((*prev)->deadline - now) <= (int)ticks)) {
+		prev = &(*prev)->next;
+	}
+	timeout->next = *prev;
+	*prev = timeout;
+
+	if (g_os_timeouts == timeout) {
+		os_timeout_program();
+	}
+}
+
+// Must be called with the interrupts disabled
+static void os_timeout_stop(os_timeout_t* timeout) {
+	os_timeout_t** prev = &g_os_timeouts;
+
+	if (!timeout->active) {
+		return;
+	}
+	timeout->active = 0;
+
+	while (*prev != timeout) {
+		prev = &(*prev)->next;
+	}
+	*prev = timeout->next;
+	timeout->next = NULL;
+
+	// The earliest deadline has changed
+	if (prev == &g_os_timeouts) {
+		os_timeout_program();
+	}
+}
+
+// Called by the PolyMCU timer interrupt
+static void os_timeout_expired(void* arg) {
+	unsigned state = disableIRQ();
+	unsigned int now = polymcu_timer_get_value();
+	os_timeout_t* timeout;
+
+	(void)arg;
+
+	while ((g_os_timeouts != NULL) && ((int)(now - g_os_timeouts->deadline) >= 0)) {
+		timeout = g_os_timeouts;
+		g_os_timeouts = timeout->next;
+		timeout->next = NULL;
+		timeout->active = 0;
+
+		timeout->function(timeout);
+	}
+	os_timeout_program();
+
+	restoreIRQ(state);
+}
+
+//  ==== Thread blocking ====
+
+/*
+ * Wake up a blocked thread: it returns `status` from os_thread_wait().
+ * Must be called with the interrupts disabled.
+ */
+static void os_thread_wake_up(kernel_pid_t pid, osStatus status) {
+	os_thread_t* thread = &g_os_threads[pid];
+	tcb_t* tcb = (tcb_t*)sched_threads[pid];
+
+	if (thread->wait_queue != NULL) {
+		priority_queue_remove(thread->wait_queue, &thread->wait_node);
+		thread->wait_queue = NULL;
+	}
+	os_timeout_stop(&thread->timeout);
+
+	thread->wait = OS_WAIT_NONE;
+	thread->wait_status = status;
+	sched_set_status(tcb, STATUS_PENDING);
+
+	// Pend the context switch: it happens when the interrupts are enabled again (or when
+	// the current interrupt handler returns)
+	if (tcb->priority < sched_active_thread->priority) {
+		thread_yield_higher();
+	}
+}
+
+// Wake up the highest priority thread waiting on `queue`. Return the thread or NULL.
+// Must be called with the interrupts disabled.
+static os_thread_t* os_thread_wake_up_waiter(priority_queue_t* queue, osStatus status) {
+	kernel_pid_t pid;
+
+	if (queue->first == NULL) {
+		return NULL;
+	}
+	pid = (kernel_pid_t)queue->first->data;
+	os_thread_wake_up(pid, status);
+	return &g_os_threads[pid];
+}
+
+static void os_thread_timeout(os_timeout_t* timeout) {
+	os_thread_t* thread = (os_thread_t*)((char*)timeout - offsetof(os_thread_t, timeout));
+
+	os_thread_wake_up(thread - g_os_threads, osEventTimeout);
+}
+
+/*
+ * Block the current thread until it is woken up by os_thread_wake_up() or `millisec` has
+ * elapsed. The thread waits in `queue` (ordered by priority) when not NULL.
+ * Must be called with the interrupts disabled, `state` is restored before blocking.
+ */
+static osStatus os_thread_wait(uint32_t wait, priority_queue_t* queue, uint32_t millisec, unsigned state) {
+	tcb_t* tcb = (tcb_t*)sched_active_thread;
+	os_thread_t* thread = &g_os_threads[tcb->pid];
+
+	thread->wait = wait;
+	thread->wait_status = osEventTimeout;
+	if (queue != NULL) {
+		thread->wait_node.priority = tcb->priority;
+		thread->wait_node.data = tcb->pid;
+		thread->wait_node.next = NULL;
+		priority_queue_add(queue, &thread->wait_node);
+		thread->wait_queue = queue;
+	}
+	if (millisec != osWaitForever) {
+		thread->timeout.function = os_thread_timeout;
+		os_timeout_start(&thread->timeout, os_ms_to_ticks(millisec));
+	}
+
+	sched_set_status(tcb, (queue != NULL) ? STATUS_MUTEX_BLOCKED : STATUS_SLEEPING);
+	restoreIRQ(state);
+	thread_yield_higher();
+
+	return thread->wait_status;
+}
+
+//  ==== Kernel Control Functions ====
+
+/// Initialize the RTOS Kernel for creating objects.
+/// \return status code that indicates the execution status of the function.
+osStatus osKernelInitialize (void) {
+	unsigned state = disableIRQ();
+	if (!g_os_timer_initialized) {
+		polymcu_timer_init(OS_TICK_RATE);
+		g_os_timer_initialized = 1;
+	}
+	restoreIRQ(state);
+	return osOK;
+}
+
+/// Start the RTOS Kernel.
+/// \return status code that indicates the execution status of the function.
+osStatus osKernelStart (void) {
+	// RIOT is already running: main() is its main thread
+	return osOK;
+}
+
+/// Check if the RTOS kernel is already started.
+/// \return 0 RTOS is not started, 1 RTOS is started.
+int32_t osKernelRunning(void) {
+	return 1;
+}
+
+//  ==== Thread Management ====
+
+// Allocate contiguous blocks of the stack pool. Return NULL if there is no room.
+static char* os_stack_alloc(int stacksize, uint32_t* blocks) {
+	uint32_t count = (stacksize + RTOS_TASK_STACK_SIZE - 1) / RTOS_TASK_STACK_SIZE;
+	uint32_t mask = (count < 32) ? ((1UL << count) - 1) : 0xFFFFFFFFUL;
+	char* stack = NULL;
+	unsigned state;
+	uint32_t index;
+
+	if ((count == 0) || (count > RTOS_TASK_COUNT)) {
+		return NULL;
+	}
+
+	state = disableIRQ();
+	for (index = 0; index + count <= RTOS_TASK_COUNT; index++) {
+		if ((g_os_stacks_used & (mask << index)) == 0) {
+			g_os_stacks_used |= mask << index;
+			*blocks = mask << index;
+			stack = g_os_stacks[index];
+			break;
+		}
+	}
+	restoreIRQ(state);
+
+	return stack;
+}
+
+static void* os_thread_entry(void* arg) {
+	os_thread_t* thread = &g_os_threads[thread_getpid()];
+
+	(void)arg;
+	thread->pthread(thread->argument);
+
+	// Release the stack when the thread function returns
+	osThreadTerminate(thread_getpid());
+	return NULL;
+}
+
+static osThreadId os_thread_create(os_pthread pthread, void* argument, osPriority tpriority, int stacksize, const char* name) {
 	// The RIOT priority is the inverse of the CMSIS RTOS priority (ie: RIOT highest priority is '0')
-	char priority = THREAD_PRIORITY_MAIN - thread_def->tpriority;
-	char* stack = m_stacks_ptr;
-	int stacksize = thread_def->stacksize;
+	char priority = THREAD_PRIORITY_MAIN - tpriority;
+	uint32_t blocks;
+	kernel_pid_t pid;
+	char* stack;
+
+	if ((tpriority < osPriorityIdle) || (tpriority > osPriorityRealtime)) {
+		return KERNEL_PID_UNDEF;
+	}
 
 	// Check if we are requesting a default stack
 	if (stacksize == 0) {
 		stacksize = RTOS_TASK_STACK_SIZE;
 	}
 
-	// Allocate stack
-	if (m_stacks_ptr + stacksize > m_stacks + sizeof(m_stacks)) {
-		return (osThreadId)NULL;
-	} else {
-		m_stacks_ptr += stacksize;
+	stack = os_stack_alloc(stacksize, &blocks);
+	if (stack == NULL) {
+		return KERNEL_PID_UNDEF;
 	}
 
-	return thread_create(stack,
-						stacksize,
+	// The thread only runs once its CMSIS state has been initialized
+	pid = thread_create(stack,
+						__builtin_popcount(blocks) * RTOS_TASK_STACK_SIZE,
 						priority,
-						CREATE_STACKTEST,
-						(thread_task_func_t)thread_def->pthread,
-						argument,
-						thread_def->name
+						CREATE_STACKTEST | CREATE_SLEEPING | CREATE_WOUT_YIELD,
+						os_thread_entry,
+						NULL,
+						name
 						);
+	if (pid < 0) {
+		unsigned state = disableIRQ();
+		g_os_stacks_used &= ~blocks;
+		restoreIRQ(state);
+		return KERNEL_PID_UNDEF;
+	}
+
+	memset(&g_os_threads[pid], 0, sizeof(os_thread_t));
+	g_os_threads[pid].stack        = stack;
+	g_os_threads[pid].stack_blocks = blocks;
+	g_os_threads[pid].pthread      = pthread;
+	g_os_threads[pid].argument     = argument;
+
+	thread_wakeup(pid);
+	return pid;
+}
+
+/// Create a thread and add it to Active Threads and set it to state READY.
+/// \param[in]     thread_def    thread definition referenced with \ref osThread.
+/// \param[in]     argument      pointer that is passed to the thread function as start argument.
+/// \return thread ID for reference by other functions or NULL in case of error.
+/// \note MUST REMAIN UNCHANGED: \b osThreadCreate shall be consistent in every CMSIS-RTOS.
+osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
+	return os_thread_create(thread_def->pthread, argument, thread_def->tpriority,
+							thread_def->stacksize, thread_def->name);
 }
 
 /// Return the thread ID of the current running thread.
@@ -83,8 +435,48 @@ osThreadId osThreadGetId (void) {
 /// \return status code that indicates the execution status of the function.
 /// \note MUST REMAIN UNCHANGED: \b osThreadTerminate shall be consistent in every CMSIS-RTOS.
 osStatus osThreadTerminate (osThreadId thread_id) {
-	// Not supported
-	return osErrorOS;
+	os_thread_t* thread;
+	tcb_t* tcb;
+	unsigned state;
+
+	if (inISR()) {
+		return osErrorISR;
+	}
+
+	state = disableIRQ();
+	if (!os_thread_is_valid(thread_id)) {
+		restoreIRQ(state);
+		return osErrorParameter;
+	}
+	thread = &g_os_threads[thread_id];
+	tcb = (tcb_t*)sched_threads[thread_id];
+
+	if (thread->wait_queue != NULL) {
+		priority_queue_remove(thread->wait_queue, &thread->wait_node);
+		thread->wait_queue = NULL;
+	}
+	os_timeout_stop(&thread->timeout);
+	thread->wait = OS_WAIT_NONE;
+
+	// The stack returns to the pool. When the thread terminates itself it keeps running on
+	// it until the context switch: the interrupts are not enabled again before then.
+	g_os_stacks_used &= ~thread->stack_blocks;
+	thread->stack = NULL;
+	thread->stack_blocks = 0;
+
+	if (thread_id == sched_active_pid) {
+		sched_task_exit();
+	}
+
+#ifdef SUPPORT_RTOS_CPU_USAGE
+	sched_cpu_usage_exit(thread_id);
+#endif
+	sched_set_status(tcb, STATUS_STOPPED);
+	sched_threads[thread_id] = NULL;
+	sched_num_threads--;
+
+	restoreIRQ(state);
+	return osOK;
 }
 
 /// Pass control to next thread that is in state \b READY.
@@ -94,3 +486,683 @@ osStatus osThreadYield (void) {
 	thread_yield();
 	return osOK;
 }
+
+/// Change priority of an active thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId.
+/// \param[in]     priority      new priority value for the thread function.
+/// \return status code that indicates the execution status of the function.
+osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority) {
+	os_thread_t* thread;
+	tcb_t* tcb;
+	unsigned state;
+
+	if ((priority < osPriorityIdle) || (priority > osPriorityRealtime)) {
+		return osErrorValue;
+	}
+
+	state = disableIRQ();
+	if (!os_thread_is_valid(thread_id)) {
+		restoreIRQ(state);
+		return osErrorParameter;
+	}
+	thread = &g_os_threads[thread_id];
+	tcb = (tcb_t*)sched_threads[thread_id];
+
+	if (tcb->status >= STATUS_ON_RUNQUEUE) {
+		// Move the thread to the run queue of its new priority
+		unsigned int status = tcb->status;
+
+		sched_set_status(tcb, STATUS_STOPPED);
+		tcb->priority = THREAD_PRIORITY_MAIN - priority;
+		sched_set_status(tcb, status);
+	} else {
+		tcb->priority = THREAD_PRIORITY_MAIN - priority;
+		// Keep the waiters of the object ordered by priority
+		if (thread->wait_queue != NULL) {
+			priority_queue_remove(thread->wait_queue, &thread->wait_node);
+			thread->wait_node.priority = tcb->priority;
+			priority_queue_add(thread->wait_queue, &thread->wait_node);
+		}
+	}
+	restoreIRQ(state);
+
+	// Another thread might now have the highest priority
+	thread_yield_higher();
+	return osOK;
+}
+
+/// Get current priority of an active thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId.
+/// \return current priority value of the thread function.
+osPriority osThreadGetPriority (osThreadId thread_id) {
+	if (!os_thread_is_valid(thread_id)) {
+		return osPriorityError;
+	}
+	return THREAD_PRIORITY_MAIN - sched_threads[thread_id]->priority;
+}
+
+#ifdef SUPPORT_RTOS_CPU_USAGE
+/// Get the CPU usage of an active thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId (0 for the current thread).
+/// \param[out]    stats         CPU usage of the thread.
+/// \return status code that indicates the execution status of the function.
+osStatus osThreadGetCpuUsage (osThreadId thread_id, polymcu_cpu_usage_stats_t *stats) {
+	if (polymcu_cpu_usage_get((void*)(intptr_t)thread_id, stats) != 0) {
+		return osErrorParameter;
+	}
+	return osOK;
+}
+
+static void os_cpu_usage_report_thread(void const* argument) {
+	uint32_t period_ms = (uint32_t)argument;
+
+	for (;;) {
+		osDelay(period_ms);
+		polymcu_cpu_usage_dump();
+	}
+}
+
+int polymcu_cpu_usage_start_report(unsigned int period_ms) {
+	osThreadId pid;
+
+	if (period_ms == 0) {
+		return 1;
+	}
+	pid = os_thread_create(os_cpu_usage_report_thread, (void*)period_ms, osPriorityRealtime, 0, "cpu");
+	return (pid == KERNEL_PID_UNDEF) ? 1 : 0;
+}
+#endif
+
+//  ==== Generic Wait Functions ====
+
+/// Wait for Timeout (Time Delay).
+/// \param[in]     millisec      time delay value
+/// \return status code that indicates the execution status of the function.
+osStatus osDelay (uint32_t millisec) {
+	if (inISR()) {
+		return osErrorISR;
+	}
+
+	if (millisec == 0) {
+		thread_yield();
+	} else {
+		os_thread_wait(OS_WAIT_DELAY, NULL, millisec, disableIRQ());
+	}
+	return osEventTimeout;
+}
+
+//  ==== Timer Management Functions ====
+
+static void os_timer_thread(void const *argument) {
+	os_timer_t* timer;
+	os_ptimer ptimer;
+	void* timer_argument;
+	unsigned state;
+
+	(void)argument;
+
+	for (;;) {
+		state = disableIRQ();
+		timer = g_os_timers_expired;
+		if (timer == NULL) {
+			os_thread_wait(OS_WAIT_OBJECT, &g_os_timer_thread_waiter, osWaitForever, state);
+			continue;
+		}
+
+		g_os_timers_expired = timer->next_expired;
+		if (g_os_timers_expired == NULL) {
+			g_os_timers_expired_tail = &g_os_timers_expired;
+		}
+		timer->next_expired = NULL;
+		timer->expired = 0;
+		ptimer = timer->ptimer;
+		timer_argument = timer->argument;
+		restoreIRQ(state);
+
+		// The timer functions run in thread mode and can call the CMSIS-RTOS functions
+		ptimer(timer_argument);
+	}
+}
+
+static void os_timer_expired(os_timeout_t* timeout) {
+	os_timer_t* timer = (os_timer_t*)timeout;
+
+	if (timer->period != 0) {
+		// Restart from the previous deadline to not accumulate the latency
+		os_timeout_start(timeout, timer->period - (polymcu_timer_get_value() - timeout->deadline) % timer->period);
+	}
+
+	if (!timer->expired) {
+		timer->expired = 1;
+		*g_os_timers_expired_tail = timer;
+		g_os_timers_expired_tail = &timer->next_expired;
+		os_thread_wake_up_waiter(&g_os_timer_thread_waiter, osOK);
+	}
+}
+
+/// Create a timer.
+/// \param[in]     timer_def     timer object referenced with \ref osTimer.
+/// \param[in]     type          osTimerOnce for one-shot or osTimerPeriodic for periodic behavior.
+/// \param[in]     argument      argument to the timer call back function.
+/// \return timer ID for reference by other functions or NULL in case of error.
+osTimerId osTimerCreate (const osTimerDef_t *timer_def, os_timer_type type, void *argument) {
+	os_timer_t* timer = (os_timer_t*)timer_def->timer;
+
+	if (inISR()) {
+		return NULL;
+	}
+
+	// The timer functions are called by a dedicated thread created with the first timer
+	if (g_os_timer_thread_pid == KERNEL_PID_UNDEF) {
+		g_os_timer_thread_pid = os_thread_create(os_timer_thread, NULL, osPriorityHigh, 0, "timer");
+		if (g_os_timer_thread_pid == KERNEL_PID_UNDEF) {
+			return NULL;
+		}
+	}
+
+	memset(timer, 0, sizeof(os_timer_t));
+	timer->timeout.function = os_timer_expired;
+	timer->ptimer = timer_def->ptimer;
+	timer->argument = argument;
+	// Non-zero period marks a periodic timer until it is started
+	timer->period = (type == osTimerPeriodic) ? 1 : 0;
+	return (osTimerId)timer;
+}
+
+/// Start or restart a timer.
+/// \param[in]     timer_id      timer ID obtained by \ref osTimerCreate.
+/// \param[in]     millisec      time delay value of the timer.
+/// \return status code that indicates the execution status of the function.
+osStatus osTimerStart (osTimerId timer_id, uint32_t millisec) {
+	os_timer_t* timer = (os_timer_t*)timer_id;
+	unsigned int ticks = os_ms_to_ticks(millisec);
+	unsigned state;
+
+	if ((timer == NULL) || (timer->timeout.function != os_timer_expired)) {
+		return osErrorParameter;
+	}
+	if (ticks == 0) {
+		return osErrorValue;
+	}
+
+	state = disableIRQ();
+	os_timeout_stop(&timer->timeout);
+	if (timer->period != 0) {
+		timer->period = ticks;
+	}
+	os_timeout_start(&timer->timeout, ticks);
+	restoreIRQ(state);
+	return osOK;
+}
+
+/// Stop the timer.
+/// \param[in]     timer_id      timer ID obtained by \ref osTimerCreate.
+/// \return status code that indicates the execution status of the function.
+osStatus osTimerStop (osTimerId timer_id) {
+	os_timer_t* timer = (os_timer_t*)timer_id;
+	osStatus status = osOK;
+	unsigned state;
+
+	if ((timer == NULL) || (timer->timeout.function != os_timer_expired)) {
+		return osErrorParameter;
+	}
+
+	state = disableIRQ();
+	if (timer->timeout.active) {
+		os_timeout_stop(&timer->timeout);
+	} else {
+		status = osErrorResource;
+	}
+	restoreIRQ(state);
+	return status;
+}
+
+/// Delete a timer that was created by \ref osTimerCreate.
+/// \param[in]     timer_id      timer ID obtained by \ref osTimerCreate.
+/// \return status code that indicates the execution status of the function.
+osStatus osTimerDelete (osTimerId timer_id) {
+	os_timer_t* timer = (os_timer_t*)timer_id;
+	os_timer_t** prev = &g_os_timers_expired;
+	unsigned state;
+
+	if ((timer == NULL) || (timer->timeout.function != os_timer_expired)) {
+		return osErrorParameter;
+	}
+	if (inISR()) {
+		return osErrorISR;
+	}
+
+	state = disableIRQ();
+	os_timeout_stop(&timer->timeout);
+
+	// The timer function must not be called anymore
+	if (timer->expired) {
+		while (*prev != timer) {
+			prev = &(*prev)->next_expired;
+		}
+		*prev = timer->next_expired;
+		if (g_os_timers_expired_tail == &timer->next_expired) {
+			g_os_timers_expired_tail = prev;
+		}
+	}
+	timer->timeout.function = NULL;
+	restoreIRQ(state);
+	return osOK;
+}
+
+//  ==== Signal Management ====
+
+// Return the signals that satisfy the wait of `wait_signals` and clear them, or 0.
+// Must be called with the interrupts disabled.
+static int32_t os_signal_take(os_thread_t* thread, int32_t wait_signals) {
+	int32_t signals = thread->signals;
+
+	if (wait_signals == 0) {
+		// Any signal
+		thread->signals = 0;
+		return signals;
+	} else if ((signals & wait_signals) == wait_signals) {
+		thread->signals &= ~wait_signals;
+		return signals;
+	} else {
+		return 0;
+	}
+}
+
+/// Set the specified Signal Flags of an active thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId.
+/// \param[in]     signals       specifies the signal flags of the thread that should be set.
+/// \return previous signal flags of the specified thread or 0x80000000 in case of incorrect parameters.
+int32_t osSignalSet (osThreadId thread_id, int32_t signals) {
+	os_thread_t* thread;
+	int32_t previous_signals;
+	int32_t taken;
+	unsigned state;
+
+	if (signals & ~OS_SIGNAL_MASK) {
+		return OS_SIGNAL_ERROR;
+	}
+
+	state = disableIRQ();
+	if (!os_thread_is_valid(thread_id)) {
+		restoreIRQ(state);
+		return OS_SIGNAL_ERROR;
+	}
+	thread = &g_os_threads[thread_id];
+
+	previous_signals = thread->signals;
+	thread->signals |= signals;
+
+	if (thread->wait == OS_WAIT_SIGNAL) {
+		taken = os_signal_take(thread, thread->wait_signals);
+		if (taken != 0) {
+			thread->wait_value = taken;
+			os_thread_wake_up(thread_id, osOK);
+		}
+	}
+	restoreIRQ(state);
+
+	return previous_signals;
+}
+
+/// Clear the specified Signal Flags of an active thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId.
+/// \param[in]     signals       specifies the signal flags of the thread that shall be cleared.
+/// \return previous signal flags of the specified thread or 0x80000000 in case of incorrect parameters or call from ISR.
+int32_t osSignalClear (osThreadId thread_id, int32_t signals) {
+	int32_t previous_signals;
+	unsigned state;
+
+	if ((signals & ~OS_SIGNAL_MASK) || inISR()) {
+		return OS_SIGNAL_ERROR;
+	}
+
+	state = disableIRQ();
+	if (!os_thread_is_valid(thread_id)) {
+		restoreIRQ(state);
+		return OS_SIGNAL_ERROR;
+	}
+	previous_signals = g_os_threads[thread_id].signals;
+	g_os_threads[thread_id].signals &= ~signals;
+	restoreIRQ(state);
+
+	return previous_signals;
+}
+
+/// Wait for one or more Signal Flags to become signaled for the current \b RUNNING thread.
+/// \param[in]     signals       wait until all specified signal flags set or 0 for any single signal flag.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return event flag information or error code.
+osEvent osSignalWait (int32_t signals, uint32_t millisec) {
+	os_thread_t* thread = &g_os_threads[thread_getpid()];
+	osEvent event;
+	unsigned state;
+
+	if (inISR()) {
+		event.status = osErrorISR;
+		return event;
+	}
+	if (signals & ~OS_SIGNAL_MASK) {
+		event.status = osErrorValue;
+		return event;
+	}
+
+	state = disableIRQ();
+	event.value.signals = os_signal_take(thread, signals);
+	if (event.value.signals != 0) {
+		event.status = osEventSignal;
+		restoreIRQ(state);
+	} else if (millisec == 0) {
+		event.status = osOK;
+		restoreIRQ(state);
+	} else {
+		thread->wait_signals = signals;
+		event.status = os_thread_wait(OS_WAIT_SIGNAL, NULL, millisec, state);
+		if (event.status == osOK) {
+			event.status = osEventSignal;
+			event.value.signals = thread->wait_value;
+		}
+	}
+	return event;
+}
+
+//  ==== Mutex Management ====
+
+/// Create and Initialize a Mutex object.
+/// \param[in]     mutex_def     mutex definition referenced with \ref osMutex.
+/// \return mutex ID for reference by other functions or NULL in case of error.
+osMutexId osMutexCreate (const osMutexDef_t *mutex_def) {
+	os_mutex_t* mutex = (os_mutex_t*)mutex_def->mutex;
+
+	mutex->owner = KERNEL_PID_UNDEF;
+	mutex->count = 0;
+	priority_queue_init(&mutex->waiters);
+	return (osMutexId)mutex;
+}
+
+/// Wait until a Mutex becomes available.
+/// \param[in]     mutex_id      mutex ID obtained by \ref osMutexCreate.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return status code that indicates the execution status of the function.
+osStatus osMutexWait (osMutexId mutex_id, uint32_t millisec) {
+	os_mutex_t* mutex = (os_mutex_t*)mutex_id;
+	kernel_pid_t pid = thread_getpid();
+	osStatus status = osOK;
+	unsigned state;
+
+	if (mutex == NULL) {
+		return osErrorParameter;
+	}
+	if (inISR()) {
+		return osErrorISR;
+	}
+
+	state = disableIRQ();
+	if (mutex->owner == KERNEL_PID_UNDEF) {
+		mutex->owner = pid;
+		mutex->count = 1;
+	} else if (mutex->owner == pid) {
+		mutex->count++;
+	} else if (millisec == 0) {
+		status = osErrorResource;
+	} else {
+		// The ownership is given by osMutexRelease()
+		if (os_thread_wait(OS_WAIT_OBJECT, &mutex->waiters, millisec, state) != osOK) {
+			return osErrorTimeoutResource;
+		}
+		return osOK;
+	}
+	restoreIRQ(state);
+	return status;
+}
+
+/// Release a Mutex that was obtained by \ref osMutexWait.
+/// \param[in]     mutex_id      mutex ID obtained by \ref osMutexCreate.
+/// \return status code that indicates the execution status of the function.
+osStatus osMutexRelease (osMutexId mutex_id) {
+	os_mutex_t* mutex = (os_mutex_t*)mutex_id;
+	os_thread_t* waiter;
+	unsigned state;
+
+	if (mutex == NULL) {
+		return osErrorParameter;
+	}
+	if (inISR()) {
+		return osErrorISR;
+	}
+
+	state = disableIRQ();
+	if (mutex->owner != thread_getpid()) {
+		restoreIRQ(state);
+		return osErrorResource;
+	}
+
+	if (--mutex->count == 0) {
+		// Hand the mutex over to the highest priority waiter
+		waiter = os_thread_wake_up_waiter(&mutex->waiters, osOK);
+		if (waiter != NULL) {
+			mutex->owner = waiter - g_os_threads;
+			mutex->count = 1;
+		} else {
+			mutex->owner = KERNEL_PID_UNDEF;
+		}
+	}
+	restoreIRQ(state);
+	return osOK;
+}
+
+/// Delete a Mutex that was created by \ref osMutexCreate.
+/// \param[in]     mutex_id      mutex ID obtained by \ref osMutexCreate.
+/// \return status code that indicates the execution status of the function.
+osStatus osMutexDelete (osMutexId mutex_id) {
+	os_mutex_t* mutex = (os_mutex_t*)mutex_id;
+	unsigned state;
+
+	if (mutex == NULL) {
+		return osErrorParameter;
+	}
+	if (inISR()) {
+		return osErrorISR;
+	}
+
+	state = disableIRQ();
+	while (os_thread_wake_up_waiter(&mutex->waiters, osErrorResource) != NULL);
+	mutex->owner = KERNEL_PID_UNDEF;
+	mutex->count = 0;
+	restoreIRQ(state);
+	return osOK;
+}
+
+//  ==== Semaphore Management Functions ====
+
+/// Create and Initialize a Semaphore object used for managing resources.
+/// \param[in]     semaphore_def semaphore definition referenced with \ref osSemaphore.
+/// \param[in]     count         number of available resources.
+/// \return semaphore ID for reference by other functions or NULL in case of error.
+osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t count) {
+	os_semaphore_t* sem = (os_semaphore_t*)semaphore_def->semaphore;
+
+	if ((count < 0) || (count > osFeature_Semaphore) || inISR()) {
+		return NULL;
+	}
+
+	sem->count = count;
+	priority_queue_init(&sem->waiters);
+	return (osSemaphoreId)sem;
+}
+
+/// Wait until a Semaphore token becomes available.
+/// \param[in]     semaphore_id  semaphore object referenced with \ref osSemaphoreCreate.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return number of available tokens, or -1 in case of incorrect parameters.
+int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec) {
+	os_semaphore_t* sem = (os_semaphore_t*)semaphore_id;
+	int32_t tokens;
+	unsigned state;
+
+	if (sem == NULL) {
+		return -1;
+	}
+
+	state = disableIRQ();
+	if (sem->count > 0) {
+		// The token taken by the caller is counted as available
+		tokens = sem->count--;
+	} else if ((millisec == 0) || inISR()) {
+		tokens = 0;
+	} else {
+		// The token is given by osSemaphoreRelease()
+		return (os_thread_wait(OS_WAIT_OBJECT, &sem->waiters, millisec, state) == osOK) ? 1 : 0;
+	}
+	restoreIRQ(state);
+	return tokens;
+}
+
+/// Release a Semaphore token.
+/// \param[in]     semaphore_id  semaphore object referenced with \ref osSemaphoreCreate.
+/// \return status code that indicates the execution status of the function.
+osStatus osSemaphoreRelease (osSemaphoreId semaphore_id) {
+	os_semaphore_t* sem = (os_semaphore_t*)semaphore_id;
+	osStatus status = osOK;
+	unsigned state;
+
+	if (sem == NULL) {
+		return osErrorParameter;
+	}
+
+	state = disableIRQ();
+	// Hand the token over to the highest priority waiter
+	if (os_thread_wake_up_waiter(&sem->waiters, osOK) == NULL) {
+		if (sem->count < osFeature_Semaphore) {
+			sem->count++;
+		} else {
+			status = osErrorResource;
+		}
+	}
+	restoreIRQ(state);
+	return status;
+}
+
+/// Delete a Semaphore that was created by \ref osSemaphoreCreate.
+/// \param[in]     semaphore_id  semaphore object referenced with \ref osSemaphoreCreate.
+/// \return status code that indicates the execution status of the function.
+osStatus osSemaphoreDelete (osSemaphoreId semaphore_id) {
+	os_semaphore_t* sem = (os_semaphore_t*)semaphore_id;
+	unsigned state;
+
+	if (sem == NULL) {
+		return osErrorParameter;
+	}
+	if (inISR()) {
+		return osErrorISR;
+	}
+
+	state = disableIRQ();
+	while (os_thread_wake_up_waiter(&sem->waiters, osErrorResource) != NULL);
+	sem->count = 0;
+	restoreIRQ(state);
+	return osOK;
+}
+
+//  ==== Message Queue Management Functions ====
+
+/// Create and Initialize a Message Queue.
+/// \param[in]     queue_def     queue definition referenced with \ref osMessageQ.
+/// \param[in]     thread_id     thread ID (obtained by \ref osThreadCreate or \ref osThreadGetId) or NULL.
+/// \return message queue ID for reference by other functions or NULL in case of error.
+osMessageQId osMessageCreate (const osMessageQDef_t *queue_def, osThreadId thread_id) {
+	os_message_t* queue = (os_message_t*)queue_def->pool;
+
+	if ((queue_def->queue_sz == 0) || inISR()) {
+		return NULL;
+	}
+
+	queue->size = queue_def->queue_sz;
+	queue->head = 0;
+	queue->count = 0;
+	priority_queue_init(&queue->senders);
+	priority_queue_init(&queue->receivers);
+	return (osMessageQId)queue;
+}
+
+/// Put a Message to a Queue.
+/// \param[in]     queue_id      message queue ID obtained with \ref osMessageCreate.
+/// \param[in]     info          message information.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return status code that indicates the execution status of the function.
+osStatus osMessagePut (osMessageQId queue_id, uint32_t info, uint32_t millisec) {
+	os_message_t* queue = (os_message_t*)queue_id;
+	os_thread_t* receiver;
+	osStatus status = osOK;
+	unsigned state;
+
+	if (queue == NULL) {
+		return osErrorParameter;
+	}
+
+	state = disableIRQ();
+	if (queue->receivers.first != NULL) {
+		// The queue is empty: the message is given to the highest priority receiver
+		receiver = os_thread_wake_up_waiter(&queue->receivers, osOK);
+		receiver->wait_value = info;
+	} else if (queue->count < queue->size) {
+		queue->messages[(queue->head + queue->count) % queue->size] = info;
+		queue->count++;
+	} else if ((millisec == 0) || inISR()) {
+		status = osErrorResource;
+	} else {
+		// The message is added to the queue by osMessageGet()
+		g_os_threads[thread_getpid()].wait_value = info;
+		if (os_thread_wait(OS_WAIT_OBJECT, &queue->senders, millisec, state) != osOK) {
+			return osErrorTimeoutResource;
+		}
+		return osOK;
+	}
+	restoreIRQ(state);
+	return status;
+}
+
+/// Get a Message or Wait for a Message from a Queue.
+/// \param[in]     queue_id      message queue ID obtained with \ref osMessageCreate.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return event information that includes status code.
+osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec) {
+	os_message_t* queue = (os_message_t*)queue_id;
+	os_thread_t* sender;
+	osEvent event;
+	unsigned state;
+
+	if (queue == NULL) {
+		event.status = osErrorParameter;
+		return event;
+	}
+	event.def.message_id = queue_id;
+
+	state = disableIRQ();
+	if (queue->count > 0) {
+		event.status = osEventMessage;
+		event.value.v = queue->messages[queue->head];
+		queue->head = (queue->head + 1) % queue->size;
+		queue->count--;
+
+		// Move the message of the highest priority sender into the queue
+		sender = os_thread_wake_up_waiter(&queue->senders, osOK);
+		if (sender != NULL) {
+			queue->messages[(queue->head + queue->count) % queue->size] = sender->wait_value;
+			queue->count++;
+		}
+	} else if ((millisec == 0) || inISR()) {
+		event.status = osOK;
+	} else {
+		os_thread_t* thread = &g_os_threads[thread_getpid()];
+
+		event.status = os_thread_wait(OS_WAIT_OBJECT, &queue->receivers, millisec, state);
+		if (event.status == osOK) {
+			event.status = osEventMessage;
+			event.value.v = thread->wait_value;
+		}
+		return event;
+	}
+	restoreIRQ(state);
+	return event;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2017, Lab A Part
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this
+ * o list of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Per-thread CPU usage of RioT-OS (`SUPPORT_RTOS_CPU_USAGE`). The scheduler accounts the
+ * CPU cycles of the thread that is switched out (see Lib/PolyMCU/cpu_usage.c). The records
+ * are indexed by the PID of the threads.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "sched.h"
+#include "thread.h"
+#include "PolyMCU.h"
+
+static polymcu_cpu_usage_t g_cpu_usage[KERNEL_PID_LAST + 1];
+
+void sched_cpu_usage_create(kernel_pid_t pid, const char *name, char *stack) {
+	// The idle thread is created by kernel_init()
+	uint32_t flags = ((name != NULL) && (strcmp(name, "idle") == 0)) ? POLYMCU_CPU_USAGE_IDLE : 0;
+
+	polymcu_cpu_usage_add(&g_cpu_usage[pid], name, (void*)(intptr_t)pid, stack, flags);
+}
+
+void sched_cpu_usage_exit(kernel_pid_t pid) {
+	polymcu_cpu_usage_remove(&g_cpu_usage[pid]);
+	g_cpu_usage[pid].thread = NULL;
+}
+
+void sched_cpu_usage_switch(kernel_pid_t pid) {
+	polymcu_cpu_usage_switch(pid_is_valid(pid) ? &g_cpu_usage[pid] : NULL);
+}
+
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_find(void* thread) {
+	kernel_pid_t pid = (thread == NULL) ? sched_active_pid : (kernel_pid_t)(intptr_t)thread;
+
+	if (!pid_is_valid(pid) || (g_cpu_usage[pid].thread == NULL)) {
+		return NULL;
+	}
+	return &g_cpu_usage[pid];
+}
+
+polymcu_cpu_usage_t* polymcu_rtos_cpu_usage_running(void) {
+	if (sched_active_thread == NULL) {
+		return NULL;
+	}
+	return &g_cpu_usage[sched_active_pid];
+}
+
+uint32_t polymcu_rtos_cpu_usage_stack_free(const polymcu_cpu_usage_t* usage) {
+	// The stack is only filled by thread_create() with CREATE_STACKTEST
+	if (usage->stack == NULL) {
+		return POLYMCU_CPU_USAGE_NO_STACK;
+	}
+	return thread_measure_stack_free(usage->stack);
+}
@@ -67,7 +67,7 @@
 #define osFeature_MainThread   1       ///< main thread      1=main can be thread, 0=not available
 #define osFeature_Pool         0       ///< Memory Pools:    1=available, 0=not available
 #define osFeature_MailQ        0       ///< Mail Queues:     1=available, 0=not available
-#define osFeature_MessageQ     0       ///< Message Queues:  1=available, 0=not available
+#define osFeature_MessageQ     1       ///< Message Queues:  1=available, 0=not available
 #define osFeature_Signals      8       ///< maximum number of Signal Flags available per thread
 #define osFeature_Semaphore    30      ///< maximum count for \ref osSemaphoreCreate function
 #define osFeature_Wait         0       ///< osWait function: 1=available, 0=not available
@@ -182,18 +182,19 @@ typedef struct os_thread_def  {
 /// \note CAN BE CHANGED: \b os_timer_def is implementation specific in every CMSIS-RTOS.
 typedef struct os_timer_def  {
   os_ptimer                 ptimer;    ///< start address of a timer function
+  void                      *timer;    ///< pointer to internal data
 } osTimerDef_t;
  
 /// Mutex Definition structure contains setup information for a mutex.
 /// \note CAN BE CHANGED: \b os_mutex_def is implementation specific in every CMSIS-RTOS.
 typedef struct os_mutex_def  {
-  uint32_t                   dummy;    ///< dummy value.
+  void                      *mutex;    ///< pointer to internal data
 } osMutexDef_t;
  
 /// Semaphore Definition structure contains setup information for a semaphore.
 /// \note CAN BE CHANGED: \b os_semaphore_def is implementation specific in every CMSIS-RTOS.
 typedef struct os_semaphore_def  {
-  uint32_t                   dummy;    ///< dummy value.
+  void                  *semaphore;    ///< pointer to internal data
 } osSemaphoreDef_t;
  
 /// Definition structure for memory block allocation.
@@ -332,6 +333,16 @@ osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority);
 /// \return current priority value of the thread function.
 /// \note MUST REMAIN UNCHANGED: \b osThreadGetPriority shall be consistent in every CMSIS-RTOS.
 osPriority osThreadGetPriority (osThreadId thread_id);
+
+#ifdef SUPPORT_RTOS_CPU_USAGE
+struct polymcu_cpu_usage_stats;
+
+/// Get the CPU usage of an active thread (PolyMCU extension, see `polymcu_cpu_usage_get()`).
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId or NULL for the current thread.
+/// \param[out]    stats         cumulative cycles, load over the last window and unused stack of the thread.
+/// \return status code that indicates the execution status of the function.
+osStatus osThreadGetCpuUsage (osThreadId thread_id, struct polymcu_cpu_usage_stats *stats);
+#endif
  
  
 //  ==== Generic Wait Functions ====
@@ -363,8 +374,9 @@ osEvent osWait (uint32_t millisec);
 extern const osTimerDef_t os_timer_def_##name
 #else                            // define the object
 #define osTimerDef(name, function)  \
+uint32_t os_timer_cb_##name[9]; \
 const osTimerDef_t os_timer_def_##name = \
-{ (function) }
+{ (function), (os_timer_cb_##name) }
 #endif
  
 /// Access a Timer definition.
@@ -437,7 +449,8 @@ osEvent osSignalWait (int32_t signals, uint32_t millisec);
 extern const osMutexDef_t os_mutex_def_##name
 #else                            // define the object
 #define osMutexDef(name)  \
-const osMutexDef_t os_mutex_def_##name = { 0 }
+uint32_t os_mutex_cb_##name[3]; \
+const osMutexDef_t os_mutex_def_##name = { (os_mutex_cb_##name) }
 #endif
  
 /// Access a Mutex definition.
@@ -486,7 +499,8 @@ osStatus osMutexDelete (osMutexId mutex_id);
 extern const osSemaphoreDef_t os_semaphore_def_##name
 #else                            // define the object
 #define osSemaphoreDef(name)  \
-const osSemaphoreDef_t os_semaphore_def_##name = { 0 }
+uint32_t os_semaphore_cb_##name[2]; \
+const osSemaphoreDef_t os_semaphore_def_##name = { (os_semaphore_cb_##name) }
 #endif
  
 /// Access a Semaphore definition.
@@ -594,8 +608,9 @@ osStatus osPoolFree (osPoolId pool_id, void *block);
 extern const osMessageQDef_t os_messageQ_def_##name
 #else                            // define the object
 #define osMessageQDef(name, queue_sz, type)   \
+uint32_t os_messageQ_q_##name[5+(queue_sz)]; \
 const osMessageQDef_t os_messageQ_def_##name = \
-{ (queue_sz), sizeof (type)  }
+{ (queue_sz), sizeof (type), (os_messageQ_q_##name) }
 #endif
  
 /// \brief Access a Message Queue Definition.
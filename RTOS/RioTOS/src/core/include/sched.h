@@ -189,6 +189,21 @@ void sched_register_cb(void (*callback)(uint32_t, uint32_t));
 
 #endif
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+/**
+ *  @brief  Per-thread CPU usage accounting of PolyMCU (see RTOS/RioTOS/cpu_usage.c).
+ *          They are called with the interrupts disabled.
+ *
+ *  @param[in] pid      Thread created, exited or switched out
+ *  @param[in] name     Name of the thread
+ *  @param[in] stack    Lowest address of the stack if it has been filled for
+ *                      thread_measure_stack_free(), NULL otherwise
+ */
+void sched_cpu_usage_create(kernel_pid_t pid, const char *name, char *stack);
+void sched_cpu_usage_exit(kernel_pid_t pid);
+void sched_cpu_usage_switch(kernel_pid_t pid);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
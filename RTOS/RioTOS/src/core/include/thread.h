@@ -225,7 +225,9 @@ static inline kernel_pid_t thread_getpid(void)
  * @return          `NULL` if pid is unknown
  */
 const char *thread_getname(kernel_pid_t pid);
+#endif
 
+#if defined(DEVELHELP) || defined(SUPPORT_RTOS_CPU_USAGE)
 /**
  * @brief Measures the stack usage of a stack
  *
@@ -104,6 +104,10 @@ int sched_run(void)
 #endif
     }
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+    sched_cpu_usage_switch((active_thread == NULL) ? KERNEL_PID_UNDEF : active_thread->pid);
+#endif
+
 #ifdef MODULE_SCHEDSTATISTICS
     schedstat *next_stat = &sched_pidlist[next_thread->pid];
     next_stat->laststart = time;
@@ -184,6 +188,10 @@ NORETURN void sched_task_exit(void)
     DEBUG("sched_task_exit: ending thread %" PRIkernel_pid "...\n", sched_active_thread->pid);
 
     (void) disableIRQ();
+#ifdef SUPPORT_RTOS_CPU_USAGE
+    sched_cpu_usage_switch(sched_active_pid);
+    sched_cpu_usage_exit(sched_active_pid);
+#endif
     sched_threads[sched_active_pid] = NULL;
     sched_num_threads--;
 
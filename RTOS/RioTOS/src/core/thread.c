@@ -102,7 +102,7 @@ void thread_yield(void)
     thread_yield_higher();
 }
 
-#ifdef DEVELHELP
+#if defined(DEVELHELP) || defined(SUPPORT_RTOS_CPU_USAGE)
 uintptr_t thread_measure_stack_free(char *stack)
 {
     uintptr_t *stackp = (uintptr_t *)stack;
@@ -147,7 +147,8 @@ kernel_pid_t thread_create(char *stack, int stacksize, char priority, int flags,
     /* allocate our thread control block at the top of our stackspace */
     tcb_t *cb = (tcb_t *) (stack + stacksize);
 
-#ifdef DEVELHELP
+#if defined(DEVELHELP) || defined(SUPPORT_RTOS_CPU_USAGE)
+    /* the CPU usage reports the stack that has never been used */
     if (flags & CREATE_STACKTEST) {
         /* assign each int of the stack the value of it's address */
         uintptr_t *stackmax = (uintptr_t *) (stack + stacksize);
@@ -195,6 +196,10 @@ kernel_pid_t thread_create(char *stack, int stacksize, char priority, int flags,
     cb->priority = priority;
     cb->status = 0;
 
+#ifdef SUPPORT_RTOS_CPU_USAGE
+    sched_cpu_usage_create(pid, name, (flags & CREATE_STACKTEST) ? stack : NULL);
+#endif
+
     cb->rq_entry.next = NULL;
     cb->rq_entry.prev = NULL;
 